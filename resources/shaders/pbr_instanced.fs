@@ -0,0 +1,145 @@
+#version 330 core
+out vec4 FragColor;
+in vec2 TexCoords;
+in vec3 WorldPos;
+in vec3 Normal;
+flat in float WDelta; // Distance in 4th dimension from the player's slice
+flat in float Layer;  // Layer of fruit_textures
+
+// material parameters
+// uniform vec3 albedo;
+uniform sampler2DArray fruit_textures;
+uniform float metallic;
+uniform float roughness;
+uniform float ao;
+uniform float alpha;
+uniform float alpha_mult; // Multiplier for ghosting passes
+
+// lights
+uniform samplerCube environmentMap;
+uniform vec3 lightPositions[1];
+uniform vec3 lightColors[1];
+
+uniform vec3 camPos;
+
+const float PI = 3.14159265359;
+// ----------------------------------------------------------------------------
+float DistributionGGX(vec3 N, vec3 H, float roughness)
+{
+    float a = roughness*roughness;
+    float a2 = a*a;
+    float NdotH = max(dot(N, H), 0.0);
+    float NdotH2 = NdotH*NdotH;
+
+    float nom   = a2;
+    float denom = (NdotH2 * (a2 - 1.0) + 1.0);
+    denom = PI * denom * denom;
+
+    return nom / denom;
+}
+// ----------------------------------------------------------------------------
+float GeometrySchlickGGX(float NdotV, float roughness)
+{
+    float r = (roughness + 1.0);
+    float k = (r*r) / 8.0;
+
+    float nom   = NdotV;
+    float denom = NdotV * (1.0 - k) + k;
+
+    return nom / denom;
+}
+// ----------------------------------------------------------------------------
+float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness)
+{
+    float NdotV = max(dot(N, V), 0.0);
+    float NdotL = max(dot(N, L), 0.0);
+    float ggx2 = GeometrySchlickGGX(NdotV, roughness);
+    float ggx1 = GeometrySchlickGGX(NdotL, roughness);
+
+    return ggx1 * ggx2;
+}
+// ----------------------------------------------------------------------------
+vec3 fresnelSchlick(float cosTheta, vec3 F0)
+{
+    return F0 + (1.0 - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
+}
+// ----------------------------------------------------------------------------
+vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness)
+{
+    return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
+}   
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+void main()
+{		
+    // FragColor = vec4(normalize(Normal) * 0.5 + 0.5, 1.0);
+    // return;
+    
+    // FragColor = vec4(normalize(Normal) * 0.5 + 0.5, 1.0);
+    // return;
+
+    vec4 texColor = texture(fruit_textures, vec3(TexCoords, Layer));
+    // Discard if alpha is low OR if the pixel is black (common in some asset packs without alpha channel)
+    if(texColor.a < 0.1 || (texColor.r + texColor.g + texColor.b) < 0.1) discard;
+    vec3 albedo = texColor.rgb;
+    
+    vec3 N = normalize(Normal);
+    vec3 V = normalize(camPos - WorldPos);
+
+    // 4D Phasing Edge (Soft Alpha Fade)
+    // Instead of harsh clipping or colors, we just use a smooth alpha fade near the W-limits
+    // Lenient threshold to ensure objects are visible for their whole 4D span
+    float phaseLife = clamp(1.0 - abs(WDelta) / 1.5, 0.0, 1.0);
+
+    vec3 R = reflect(-V, N); 
+
+    vec3 F0 = vec3(0.04); 
+    F0 = mix(F0, albedo, metallic);
+
+    // ambient (simple constant)
+    // vec3 ambient = vec3(0.03) * albedo * ao;
+    vec3 diffuse_IBL  = texture(environmentMap, N).rgb * albedo;
+    const float MAX_REFLECTION_LOD = 4.0;
+    vec3 specular_IBL = textureLod(environmentMap, R, roughness * MAX_REFLECTION_LOD).rgb;
+    vec3 F = fresnelSchlickRoughness(max(dot(N, V), 0.0), F0, roughness);
+    vec3 kS = F;
+    vec3 kD = (1.0 - kS) * (1.0 - metallic);
+    vec3 ambient = (vec3(0.02) * albedo + 0.01 * (kD * diffuse_IBL + specular_IBL * F)) * ao;
+    
+    // vec3 ambient = (vec3(0.015) + 0.05 * texture(environmentMap, N).rgb) * albedo * ao;
+
+    // direct lighting
+    vec3 Lo = vec3(0.0);
+    for (int i = 0; i < 1; ++i) 
+    {
+        vec3 L = normalize(lightPositions[i] - WorldPos);
+        vec3 H = normalize(V + L);
+        float distance = length(lightPositions[i] - WorldPos);
+        float attenuation = 1.0 / (distance * distance);
+        vec3 radiance = lightColors[i] * attenuation;
+
+        float NDF = DistributionGGX(N, H, roughness);
+        float G = GeometrySmith(N, V, L, roughness);
+        vec3 F = fresnelSchlick(max(dot(H, V), 0.0), F0);
+
+        vec3 numerator = NDF * G * F;
+        float denominator = 4.0 * max(dot(N, V), 0.0) * max(dot(N, L), 0.0) + 0.0001;
+        vec3 specular = numerator / denominator;
+
+        vec3 kS = F;
+        vec3 kD = vec3(1.0) - kS;
+        kD *= 1.0 - metallic;
+
+        float NdotL = max(dot(N, L), 0.0);
+        Lo += (kD * albedo / PI + specular) * radiance * NdotL;
+    }
+
+    vec3 color = ambient + Lo;
+
+    // HDR tonemapping and gamma correction
+    color = color / (color + vec3(1.0));
+    color = pow(color, vec3(1.0 / 2.2)); 
+
+    FragColor = vec4(color, alpha * alpha_mult);
+}
+
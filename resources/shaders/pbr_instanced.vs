@@ -0,0 +1,28 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+// Per instance: slice-space center with the projected radius in w, then (wDelta, layer)
+layout (location = 3) in vec4 aCenterScale;
+layout (location = 4) in vec2 aWDeltaLayer;
+
+out vec2 TexCoords;
+out vec3 WorldPos;
+out vec3 Normal;
+flat out float WDelta;
+flat out float Layer;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    TexCoords = aTexCoords;
+    // uniform scale and no rotation, so the mesh normal is already the world normal
+    WorldPos = aCenterScale.xyz + aPos * aCenterScale.w;
+    Normal = aNormal;
+    WDelta = aWDeltaLayer.x;
+    Layer = aWDeltaLayer.y;
+
+    gl_Position = projection * view * vec4(WorldPos, 1.0);
+}
@@ -0,0 +1,83 @@
+#version 430 core
+// Contact resolution as a Jacobi pass: every fruit sums the pushes of the fruits it
+// overlaps, weighted by mass (radius cubed) like the CPU solver, from positions nobody
+// moves during the pass. The integrate pass applies the sum.
+layout(local_size_x = 64) in;
+
+struct Fruit {
+    vec4  position;
+    vec4  last_position;
+    vec4  correction;
+    float radius;
+    float target_radius;
+    int   fruit;
+    uint  flags;
+    float boundary_push;
+    uint  cell;
+    float pad0;
+    float pad1;
+};
+const uint PRESENT = 1u;
+const uint HIDDEN  = 2u;
+const uint DYNAMIC = 4u;
+const float EPS    = 0.0001;
+
+layout(std430, binding = 0) buffer Fruits { Fruit fruits[]; };
+layout(std430, binding = 2) readonly buffer CellStart { uint cell_start[]; };
+layout(std430, binding = 3) readonly buffer CellItems { uint cell_items[]; };
+layout(std430, binding = 4) buffer Counters { int points; int merges; uint pairs_tested; };
+
+uniform int   object_count;
+uniform vec4  grid_origin;
+uniform float cell_size;
+uniform ivec4 grid_dims;
+uniform float response_coef;
+
+ivec4 cellCoord(vec4 p)
+{
+    return ivec4(clamp(floor((p - grid_origin) / cell_size), vec4(0.0), vec4(grid_dims - 1)));
+}
+
+uint cellIndex(ivec4 c)
+{
+    return uint(((c.x * grid_dims.y + c.y) * grid_dims.z + c.z) * grid_dims.w + c.w);
+}
+
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= uint(object_count)) return;
+    Fruit self = fruits[i];
+    vec4 correction = vec4(0.0);
+    uint tested = 0u;
+    if ((self.flags & (PRESENT | HIDDEN | DYNAMIC)) == (PRESENT | DYNAMIC)) {
+        float w_self = self.radius * self.radius * self.radius;
+        ivec4 c = cellCoord(self.position);
+        ivec4 lo = max(c - 1, ivec4(0));
+        ivec4 hi = min(c + 1, grid_dims - 1);
+        for (int x = lo.x; x <= hi.x; ++x)
+        for (int y = lo.y; y <= hi.y; ++y)
+        for (int z = lo.z; z <= hi.z; ++z)
+        for (int w = lo.w; w <= hi.w; ++w) {
+            uint cell = cellIndex(ivec4(x, y, z, w));
+            for (uint k = cell_start[cell]; k < cell_start[cell + 1u]; ++k) {
+                uint j = cell_items[k];
+                if (j == i) continue;
+                Fruit other = fruits[j];
+                if ((other.flags & (PRESENT | HIDDEN)) != PRESENT) continue; // merged away
+                tested += j > i ? 1u : 0u;
+                // fruits of one kind merge instead of pushing, at the next merge pass
+                if (other.fruit == self.fruit) continue;
+                vec4 d = self.position - other.position;
+                float dist2 = dot(d, d);
+                float reach = self.radius + other.radius;
+                if (dist2 >= reach * reach || dist2 <= EPS) continue;
+                float dist = sqrt(dist2);
+                float w_other = (other.flags & DYNAMIC) != 0u ? other.radius * other.radius * other.radius : 0.0;
+                correction += d * (response_coef * (reach - dist) * w_other) / ((w_self + w_other) * dist);
+            }
+        }
+    }
+    fruits[i].correction = correction;
+    if (tested > 0u) atomicAdd(pairs_tested, tested);
+}
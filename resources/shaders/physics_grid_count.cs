@@ -0,0 +1,44 @@
+#version 430 core
+// Broadphase, pass 1 of 3: each fruit counts itself into the grid cell of its center
+layout(local_size_x = 64) in;
+
+struct Fruit {
+    vec4  position;
+    vec4  last_position;
+    vec4  correction;
+    float radius;
+    float target_radius;
+    int   fruit;
+    uint  flags;
+    float boundary_push;
+    uint  cell;
+    float pad0;
+    float pad1;
+};
+const uint PRESENT = 1u;
+const uint HIDDEN  = 2u;
+
+layout(std430, binding = 0) buffer Fruits { Fruit fruits[]; };
+layout(std430, binding = 1) buffer CellCount { uint cell_count[]; };
+
+uniform int   object_count;
+uniform vec4  grid_origin;
+uniform float cell_size;
+uniform ivec4 grid_dims;
+
+uint cellOf(vec4 p)
+{
+    // fruits outside the grid land in its border cells, which keeps neighbours adjacent
+    ivec4 c = ivec4(clamp(floor((p - grid_origin) / cell_size), vec4(0.0), vec4(grid_dims - 1)));
+    return uint(((c.x * grid_dims.y + c.y) * grid_dims.z + c.z) * grid_dims.w + c.w);
+}
+
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= uint(object_count)) return;
+    if ((fruits[i].flags & (PRESENT | HIDDEN)) != PRESENT) return;
+    uint cell = cellOf(fruits[i].position);
+    fruits[i].cell = cell;
+    atomicAdd(cell_count[cell], 1u);
+}
@@ -0,0 +1,39 @@
+#version 430 core
+// Broadphase, pass 2 of 3: one work group turns the cell counts into start offsets
+// (exclusive prefix sum) and zeroes the counts for the scatter pass to reuse as cursors
+layout(local_size_x = 256) in;
+
+layout(std430, binding = 1) buffer CellCount { uint cell_count[]; };
+layout(std430, binding = 2) buffer CellStart { uint cell_start[]; }; // cell_count + 1 entries
+
+uniform int cell_total;
+
+shared uint partial[256];
+
+void main()
+{
+    uint lane = gl_LocalInvocationID.x;
+    uint cells = uint(cell_total);
+    uint per_lane = (cells + 255u) / 256u;
+    uint begin = min(lane * per_lane, cells);
+    uint end = min(begin + per_lane, cells);
+
+    uint sum = 0u;
+    for (uint c = begin; c < end; ++c) sum += cell_count[c];
+    partial[lane] = sum;
+    barrier();
+    for (uint offset = 1u; offset < 256u; offset <<= 1) {
+        uint add = lane >= offset ? partial[lane - offset] : 0u;
+        barrier();
+        partial[lane] += add;
+        barrier();
+    }
+
+    uint running = partial[lane] - sum;
+    for (uint c = begin; c < end; ++c) {
+        cell_start[c] = running;
+        running += cell_count[c];
+        cell_count[c] = 0u;
+    }
+    if (lane == 255u) cell_start[cells] = partial[255];
+}
@@ -0,0 +1,35 @@
+#version 430 core
+// Broadphase, pass 3 of 3: each fruit writes its slot into its cell's range
+layout(local_size_x = 64) in;
+
+struct Fruit {
+    vec4  position;
+    vec4  last_position;
+    vec4  correction;
+    float radius;
+    float target_radius;
+    int   fruit;
+    uint  flags;
+    float boundary_push;
+    uint  cell;
+    float pad0;
+    float pad1;
+};
+const uint PRESENT = 1u;
+const uint HIDDEN  = 2u;
+
+layout(std430, binding = 0) readonly buffer Fruits { Fruit fruits[]; };
+layout(std430, binding = 1) buffer CellCount { uint cell_count[]; };
+layout(std430, binding = 2) readonly buffer CellStart { uint cell_start[]; };
+layout(std430, binding = 3) writeonly buffer CellItems { uint cell_items[]; };
+
+uniform int object_count;
+
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= uint(object_count)) return;
+    if ((fruits[i].flags & (PRESENT | HIDDEN)) != PRESENT) return;
+    uint cell = fruits[i].cell;
+    cell_items[cell_start[cell] + atomicAdd(cell_count[cell], 1u)] = i;
+}
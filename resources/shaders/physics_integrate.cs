@@ -0,0 +1,114 @@
+#version 430 core
+// Applies the contact pushes, then the Verlet step (growth, gravity, damping) and the
+// hemisphere bowl constraint, mirroring PhysicsObject::update and HemisphereBoundary
+layout(local_size_x = 64) in;
+
+struct Fruit {
+    vec4  position;
+    vec4  last_position;
+    vec4  correction;
+    float radius;
+    float target_radius;
+    int   fruit;
+    uint  flags;
+    float boundary_push;
+    uint  cell;
+    float pad0;
+    float pad1;
+};
+const uint PRESENT = 1u;
+const uint GROWING = 8u;
+
+layout(std430, binding = 0) buffer Fruits { Fruit fruits[]; };
+
+uniform int   object_count;
+uniform float dt;
+uniform vec4  gravity;
+uniform float velocity_damping;
+uniform float grow_speed;
+
+uniform vec4  bowl_center;
+uniform float bowl_radius;
+uniform float bowl_margin;
+uniform float bowl_cutoff; // radians
+
+// HemisphereBoundary::checkSphere: pushes the fruit out of the nearest of the inner
+// shell, the outer shell and the rim, keeping only its tangential velocity
+void bowl(inout Fruit f)
+{
+    float inner_radius = bowl_radius - bowl_margin;
+    float outer_radius = bowl_radius + bowl_margin;
+    vec4 pos = f.position;
+    vec4 offset = pos - bowl_center;
+    float dist = length(offset);
+    if (dist < 1e-6) return;
+
+    vec4 normal = offset / dist;
+    const vec4 down = vec4(0.0, -1.0, 0.0, 0.0);
+    float cos_theta = clamp(dot(normal, down), -1.0, 1.0);
+    if (acos(cos_theta) > bowl_cutoff) {
+        float clamped_cos = cos(bowl_cutoff);
+        vec4 perp = normal - cos_theta * down;
+        float perp_len = length(perp);
+        if (perp_len > 1e-6) {
+            normal = clamped_cos * down + sqrt(1.0 - clamped_cos * clamped_cos) * (perp / perp_len);
+        } else {
+            normal = vec4(sin(bowl_cutoff), -cos(bowl_cutoff), 0.0, 0.0);
+        }
+        normal = normalize(normal);
+    }
+
+    vec4 inner_point = bowl_center + normal * inner_radius;
+    vec4 outer_point = bowl_center + normal * outer_radius;
+
+    float rim_y = bowl_center.y - inner_radius * cos(bowl_cutoff);
+    float rim_rad = inner_radius * sin(bowl_cutoff);
+    vec4 rim_offset = offset;
+    rim_offset.y = 0.0;
+    float rim_len = length(rim_offset);
+    rim_offset = rim_len > 1e-6 ? rim_offset / rim_len * rim_rad : vec4(rim_rad, 0.0, 0.0, 0.0);
+    vec4 rim_point = vec4(bowl_center.x + rim_offset.x, rim_y, bowl_center.z + rim_offset.z, bowl_center.w + rim_offset.w);
+
+    vec4 closest = inner_point;
+    float min_dist = length(pos - inner_point);
+    float d_outer = length(pos - outer_point);
+    float d_rim = length(pos - rim_point);
+    if (d_outer < min_dist) { min_dist = d_outer; closest = outer_point; }
+    if (d_rim < min_dist) { min_dist = d_rim; closest = rim_point; }
+
+    if (min_dist < f.radius) {
+        vec4 push_dir = pos - closest;
+        float len = length(push_dir);
+        push_dir = len > 1e-6 ? push_dir / len : vec4(0.0, 1.0, 0.0, 0.0);
+        pos = closest + push_dir * f.radius;
+        vec4 velocity = pos - f.last_position;
+        f.last_position = pos - (velocity - dot(velocity, push_dir) * push_dir);
+        f.position = pos;
+    }
+}
+
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= uint(object_count)) return;
+    Fruit f = fruits[i];
+    if ((f.flags & PRESENT) == 0u) return;
+
+    f.position += f.correction;
+    if ((f.flags & GROWING) != 0u) {
+        f.radius += f.target_radius * dt * grow_speed;
+        if (f.radius > f.target_radius) {
+            f.radius = f.target_radius;
+            f.flags &= ~GROWING;
+        }
+    }
+    vec4 move = f.position - f.last_position;
+    vec4 next = f.position + move + (gravity - move * velocity_damping) * (dt * dt);
+    f.last_position = f.position;
+    f.position = next;
+
+    vec4 before = f.position;
+    bowl(f);
+    f.boundary_push += length(f.position - before);
+    fruits[i] = f;
+}
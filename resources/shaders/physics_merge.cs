@@ -0,0 +1,51 @@
+#version 430 core
+// Merges the pairs that picked each other: the lower slot moves to the midpoint at
+// rest and grows into the next fruit, the higher slot is freed. As on the CPU.
+layout(local_size_x = 64) in;
+
+struct Fruit {
+    vec4  position;
+    vec4  last_position;
+    vec4  correction;
+    float radius;
+    float target_radius;
+    int   fruit;
+    uint  flags;
+    float boundary_push;
+    uint  cell;
+    float pad0;
+    float pad1;
+};
+const uint PRESENT = 1u;
+const uint HIDDEN  = 2u;
+const uint GROWING = 8u;
+const uint NONE    = 0xffffffffu;
+
+layout(std430, binding = 0) buffer Fruits { Fruit fruits[]; };
+layout(std430, binding = 4) buffer Counters { int points; int merges; uint pairs_tested; };
+layout(std430, binding = 5) readonly buffer Partner { uint partner[]; };
+
+uniform int   object_count;
+uniform int   last_fruit;        // merging two of these keeps the kind
+uniform float fruit_radius[16];
+uniform int   merge_points[16];
+
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= uint(object_count)) return;
+    uint j = partner[i];
+    if (j == NONE || j <= i || partner[j] != i) return;
+
+    atomicAdd(points, merge_points[fruits[j].fruit]);
+    atomicAdd(merges, 1);
+    fruits[j].flags = (fruits[j].flags & ~PRESENT) | HIDDEN;
+
+    vec4 middle = (fruits[i].position + fruits[j].position) * 0.5;
+    int next = min(fruits[i].fruit + 1, last_fruit);
+    fruits[i].position = middle;
+    fruits[i].last_position = middle;
+    fruits[i].fruit = next;
+    fruits[i].target_radius = fruit_radius[next];
+    fruits[i].flags |= GROWING;
+}
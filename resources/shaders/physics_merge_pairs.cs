@@ -0,0 +1,74 @@
+#version 430 core
+// Each fruit picks the lowest slot of the same kind it overlaps. Two fruits that pick
+// each other merge in the next pass, so no fruit takes part in two merges at once.
+layout(local_size_x = 64) in;
+
+struct Fruit {
+    vec4  position;
+    vec4  last_position;
+    vec4  correction;
+    float radius;
+    float target_radius;
+    int   fruit;
+    uint  flags;
+    float boundary_push;
+    uint  cell;
+    float pad0;
+    float pad1;
+};
+const uint PRESENT = 1u;
+const uint HIDDEN  = 2u;
+const uint DYNAMIC = 4u;
+const uint NONE    = 0xffffffffu;
+const float EPS    = 0.0001;
+
+layout(std430, binding = 0) readonly buffer Fruits { Fruit fruits[]; };
+layout(std430, binding = 2) readonly buffer CellStart { uint cell_start[]; };
+layout(std430, binding = 3) readonly buffer CellItems { uint cell_items[]; };
+layout(std430, binding = 5) writeonly buffer Partner { uint partner[]; };
+
+uniform int   object_count;
+uniform vec4  grid_origin;
+uniform float cell_size;
+uniform ivec4 grid_dims;
+
+ivec4 cellCoord(vec4 p)
+{
+    return ivec4(clamp(floor((p - grid_origin) / cell_size), vec4(0.0), vec4(grid_dims - 1)));
+}
+
+uint cellIndex(ivec4 c)
+{
+    return uint(((c.x * grid_dims.y + c.y) * grid_dims.z + c.z) * grid_dims.w + c.w);
+}
+
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= uint(object_count)) return;
+    uint best = NONE;
+    Fruit self = fruits[i];
+    if ((self.flags & (PRESENT | HIDDEN)) == PRESENT) {
+        ivec4 c = cellCoord(self.position);
+        ivec4 lo = max(c - 1, ivec4(0));
+        ivec4 hi = min(c + 1, grid_dims - 1);
+        for (int x = lo.x; x <= hi.x; ++x)
+        for (int y = lo.y; y <= hi.y; ++y)
+        for (int z = lo.z; z <= hi.z; ++z)
+        for (int w = lo.w; w <= hi.w; ++w) {
+            uint cell = cellIndex(ivec4(x, y, z, w));
+            for (uint k = cell_start[cell]; k < cell_start[cell + 1u]; ++k) {
+                uint j = cell_items[k];
+                if (j == i || j >= best) continue;
+                Fruit other = fruits[j];
+                if (other.fruit != self.fruit) continue;
+                if (((self.flags | other.flags) & DYNAMIC) == 0u) continue;
+                vec4 d = self.position - other.position;
+                float dist2 = dot(d, d);
+                float reach = self.radius + other.radius;
+                if (dist2 < reach * reach && dist2 > EPS) best = j;
+            }
+        }
+    }
+    partner[i] = best;
+}
@@ -0,0 +1,237 @@
+#pragma once
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "globals.h"
+#include "fruit_data.hpp"
+#include "physics_solver.hpp"
+#include "hemisphere_boundary.hpp"
+#include "executor_factory.hpp"
+#include "replay.hpp"
+#include "profiler.hpp"
+
+const float AUTOPLAY_DROP_SECONDS = 1.0f; // time between two bot drops
+const float AUTOPLAY_DROP_HEIGHT  = 3.0f; // drops start this far above the rim, like a click on it
+
+// Search effort per move. SUIKA_BOT_CANDIDATES, SUIKA_BOT_ROLLOUTS and
+// SUIKA_BOT_HORIZON (seconds) override the defaults.
+struct AutoPlayerConfig
+{
+    uint32_t candidates = 32;   // drop positions tried per move
+    uint32_t rollouts   = 4;    // random futures simulated per candidate
+    float    horizon    = 2.0f; // seconds simulated per rollout
+    float    follow_up  = 0.5f; // a random fruit is dropped this often during a rollout
+
+    static AutoPlayerConfig fromEnvironment()
+    {
+        AutoPlayerConfig config;
+        if (const char* v = std::getenv("SUIKA_BOT_CANDIDATES")) config.candidates = std::max(1, std::atoi(v));
+        if (const char* v = std::getenv("SUIKA_BOT_ROLLOUTS")) config.rollouts = std::max(1, std::atoi(v));
+        if (const char* v = std::getenv("SUIKA_BOT_HORIZON")) {
+            const float seconds = static_cast<float>(std::atof(v));
+            if (seconds > 0.0f) config.horizon = seconds;
+        }
+        return config;
+    }
+};
+
+struct AutoPlayerMove
+{
+    glm::vec4 position = glm::vec4(0.0f, AUTOPLAY_DROP_HEIGHT, 0.0f, 0.0f);
+    float     score    = 0.0f; // mean rollout score of the chosen candidate
+    double    search_ms = 0.0;
+};
+
+// Monte Carlo drop search. Every candidate drop position (x, z and the w slice) is
+// played forward on cloned solvers, each rollout with its own random follow-up drops,
+// and scored on points gained minus the height of the stack; a fruit leaving the bowl
+// costs the game. Rollouts are spread over the executor, and each chunk steps its
+// clones on a private serial executor, so the search is deterministic for a given seed
+// whatever the pool does.
+class AutoPlayer
+{
+public:
+    static constexpr float HEIGHT_WEIGHT = 4.0f;    // points per unit of stack height
+    static constexpr float LOSS_PENALTY  = 1000.0f;
+    static constexpr float LOSS_Y        = -3.0f;   // same game over line as Game
+
+    AutoPlayer(tp::Executor& executor, const HemisphereBoundary& boundary, float timestep, uint32_t sub_steps,
+               AutoPlayerConfig config = AutoPlayerConfig::fromEnvironment())
+        : m_executor(executor), m_boundary(boundary), m_timestep(timestep), m_sub_steps(sub_steps), m_config(config)
+    {}
+
+    const AutoPlayerConfig& config() const { return m_config; }
+
+    // Extra colliders of the level (static props), shared read-only by every clone
+    void addObstacles(Boundary* obstacles) { m_obstacles.push_back(obstacles); }
+
+    // Picks where to drop `fruit` into the bowl described by `state`
+    AutoPlayerMove choose(const SolverState& state, Fruit fruit, uint64_t seed)
+    {
+        PROFILE_SCOPE("AutoPlayer::choose");
+        const auto start = std::chrono::steady_clock::now();
+        Pcg32 rng(seed);
+        m_candidates.resize(m_config.candidates);
+        for (glm::vec4& candidate : m_candidates) candidate = randomDrop(rng, fruit);
+
+        const uint32_t total = m_config.candidates * m_config.rollouts;
+        m_scores.assign(total, 0.0f);
+        m_executor.dispatch(total, [&](uint32_t begin, uint32_t end) {
+            // one clone per chunk, stepped inline: the pool is busy running the chunks
+            tp::SerialExecutor serial(false);
+            PhysicSolver clone(serial, &m_boundary);
+            clone.boundary.insert(clone.boundary.end(), m_obstacles.begin(), m_obstacles.end());
+            clone.sub_steps = m_sub_steps;
+            for (uint32_t k = begin; k < end; ++k) {
+                const uint32_t candidate = k / m_config.rollouts;
+                m_scores[k] = rollout(clone, state, m_candidates[candidate], fruit, Pcg32(seed, k + 1));
+            }
+        }, "rollouts");
+
+        AutoPlayerMove move;
+        float best = -FLT_MAX;
+        for (uint32_t c = 0; c < m_config.candidates; ++c) {
+            float sum = 0.0f;
+            for (uint32_t r = 0; r < m_config.rollouts; ++r) sum += m_scores[c * m_config.rollouts + r];
+            const float mean = sum / m_config.rollouts;
+            if (mean > best) {
+                best = mean;
+                move.position = m_candidates[c];
+                move.score = mean;
+            }
+        }
+        move.search_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        m_rollouts += total;
+        m_search_seconds += move.search_ms / 1000.0;
+        return move;
+    }
+
+    uint64_t rollouts() const { return m_rollouts; }
+    double searchSeconds() const { return m_search_seconds; }
+    double rolloutsPerSecond() const { return m_search_seconds > 0.0 ? m_rollouts / m_search_seconds : 0.0; }
+
+private:
+    // Uniform over the part of the bowl the fruit fits into, at drop height
+    glm::vec4 randomDrop(Pcg32& rng, Fruit fruit) const
+    {
+        const float reach = std::max(0.0f, m_boundary.radius - m_boundary.margin - fruitPhysics(fruit).radius);
+        for (;;) {
+            const glm::vec3 p(unit(rng), unit(rng), unit(rng)); // x, z, w in [-1, 1]
+            if (glm::dot(p, p) > 1.0f) continue;
+            return glm::vec4(m_boundary.center.x + p.x * reach, m_boundary.center.y + AUTOPLAY_DROP_HEIGHT,
+                             m_boundary.center.z + p.y * reach, m_boundary.center.w + p.z * reach);
+        }
+    }
+
+    static float unit(Pcg32& rng) { return static_cast<float>(rng.next()) * (2.0f / 4294967296.0f) - 1.0f; }
+
+    float rollout(PhysicSolver& clone, const SolverState& state, const glm::vec4& drop, Fruit fruit, Pcg32 rng)
+    {
+        clone.loadState(state);
+        const int start_points = clone.total_points;
+        clone.addObject(PhysicsObject(drop, fruit, true, false));
+
+        const uint32_t ticks = static_cast<uint32_t>(m_config.horizon / m_timestep + 0.5f);
+        const uint32_t follow_up = std::max(1u, static_cast<uint32_t>(m_config.follow_up / m_timestep + 0.5f));
+        for (uint32_t t = 1; t <= ticks; ++t) {
+            clone.update(m_timestep);
+            if (t % follow_up == 0 && t < ticks) {
+                const Fruit next = randomDropFruit(rng);
+                clone.addObject(PhysicsObject(randomDrop(rng, next), next, true, false));
+            }
+        }
+
+        float top = m_boundary.center.y - m_boundary.radius;
+        for (int i = 0; i < MAX_OBJECTS; ++i) {
+            if (!clone.has_obj[i]) continue;
+            const PhysicsObject& obj = clone.objects[i];
+            if (obj.position.y < LOSS_Y) return -LOSS_PENALTY;
+            if (obj.position.y < m_boundary.center.y + 1.0f) top = std::max(top, obj.position.y + obj.radius); // skip fruit still falling
+        }
+        return static_cast<float>(clone.total_points - start_points) - HEIGHT_WEIGHT * (top - (m_boundary.center.y - m_boundary.radius));
+    }
+
+    tp::Executor&          m_executor;
+    HemisphereBoundary     m_boundary; // shared read-only by every clone
+    std::vector<Boundary*> m_obstacles;
+    float                  m_timestep;
+    uint32_t               m_sub_steps;
+    AutoPlayerConfig       m_config;
+    std::vector<glm::vec4> m_candidates;
+    std::vector<float>     m_scores;
+    uint64_t               m_rollouts = 0;
+    double                 m_search_seconds = 0.0;
+};
+
+// 4d_game --autoplay <moves>: the bot plays a game headless, as a load generator and
+// to measure rollouts per second. The game itself is stepped on a serial executor so
+// that --record produces a bit-reproducible replay; the rollouts use the executor
+// picked by SUIKA_EXECUTOR.
+inline int runAutoplay(uint32_t moves, uint64_t seed, const std::string& record_path)
+{
+    const tp::PoolConfig config = tp::PoolConfig::fromEnvironment(SUIKA_DEFAULT_EXECUTOR);
+    std::unique_ptr<tp::Executor> pool = tp::makeExecutor(config.backend, tp::planPlacement(tp::CpuTopology::discover(), config));
+    tp::SerialExecutor serial;
+
+    HemisphereBoundary boundary(glm::vec4(0.0f), 3, 90.0f, 0.1f); // same bowl as Game
+    PhysicSolver solver(serial, &boundary);
+    AutoPlayer bot(*pool, boundary, PHYSICS_TIMESTEP, solver.sub_steps);
+
+    ReplayHeader header;
+    header.timestep = PHYSICS_TIMESTEP;
+    header.sub_steps = solver.sub_steps;
+    header.seed = seed;
+    header.bowl_radius = boundary.radius;
+    header.bowl_angle = glm::degrees(boundary.cutoffAngle);
+    header.bowl_margin = boundary.margin;
+    ReplayRecorder recorder(header);
+
+    std::cout << "autoplay: " << moves << " moves, " << bot.config().candidates << " candidates x "
+              << bot.config().rollouts << " rollouts of " << bot.config().horizon << " s on " << pool->name()
+              << " x" << pool->threadCount() << std::endl;
+
+    Pcg32 fruits(seed); // same fruit sequence as the game with this seed
+    SolverState state;
+    uint64_t tick = 0;
+    const uint32_t ticks_per_move = static_cast<uint32_t>(AUTOPLAY_DROP_SECONDS / PHYSICS_TIMESTEP + 0.5f);
+    uint32_t played = 0;
+    bool lost = false;
+    for (; played < moves && !lost; ++played) {
+        const Fruit fruit = randomDropFruit(fruits);
+        solver.saveState(state);
+        const AutoPlayerMove move = bot.choose(state, fruit, seed ^ (tick * 0x9e3779b97f4a7c15ull));
+        const PhysicsObject object(move.position, fruit, true, false);
+        recorder.drop(tick, object);
+        solver.addObject(object);
+        for (uint32_t t = 0; t < ticks_per_move && !lost; ++t, ++tick) {
+            solver.update(PHYSICS_TIMESTEP);
+            for (int i = 0; i < MAX_OBJECTS && !lost; ++i) {
+                lost = solver.has_obj[i] && solver.objects[i].position.y < AutoPlayer::LOSS_Y;
+            }
+        }
+    }
+    recorder.finish(tick, solver.total_points, solverChecksum(solver));
+
+    std::cout << (lost ? "game over after " : "played ") << played << " moves, " << tick << " ticks, "
+              << solver.total_points << " points" << std::endl;
+    std::cout << bot.rollouts() << " rollouts in " << bot.searchSeconds() * 1000.0 << " ms: "
+              << bot.rolloutsPerSecond() << " rollouts/s, "
+              << (played ? bot.searchSeconds() * 1000.0 / played : 0.0) << " ms per move" << std::endl;
+    if (!record_path.empty()) {
+        if (!recorder.save(record_path)) {
+            std::cerr << "could not write replay to " << record_path << std::endl;
+            return 1;
+        }
+        std::cout << "wrote replay " << record_path << std::endl;
+    }
+    return 0;
+}
@@ -28,7 +28,7 @@ public:
         this->initRenderData();
     }
 
-    ~BallRenderer()
+    virtual ~BallRenderer()
     {
         glDeleteVertexArrays(1, &this->vao);
         glDeleteBuffers(1, &this->vbo);
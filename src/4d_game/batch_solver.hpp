@@ -0,0 +1,342 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "globals.h"
+#include "fruit_data.hpp"
+#include "physics_object.hpp"
+#include "physics_solver.hpp"
+#include "hemisphere_boundary.hpp"
+#include "executor.hpp"
+#include "profiler.hpp"
+
+// Hemisphere bowl of one batched world, with the trigonometry of the rim precomputed
+struct BatchBowl : HemisphereShape
+{
+    float loss_y = 0.0f; // a fruit below the bottom of the bowl has left it (Game's game over line)
+
+    BatchBowl() = default;
+    explicit BatchBowl(const HemisphereBoundary& bowl)
+        : HemisphereShape(bowl.center, bowl.radius, bowl.margin, bowl.cutoffAngle),
+          loss_y(bowl.center.y - bowl.radius)
+    {}
+};
+
+enum class BatchEventType : uint8_t {
+    Merge, // two fruits merged into `fruit` at `position`
+    Lost,  // a fruit fell out of the bowl
+};
+
+struct BatchEvent
+{
+    uint64_t       tick;  // update() the event happened in
+    uint32_t       world;
+    uint32_t       slot;
+    BatchEventType type;
+    Fruit          fruit;
+    glm::vec4      position;
+};
+
+// Many independent bowls stepped in lockstep, for automated play-testing and training.
+// Fruits of every world live in shared structure-of-arrays storage, MAX_OBJECTS slots
+// per world; each world has its own bowl and score. update() advances all worlds in a
+// single dispatch over worlds: a world is only ever touched by one task, so there are
+// no pair locks, and each world runs the same passes in the same order as a serial
+// PhysicSolver (bit-identical results).
+class BatchSolver
+{
+public:
+    enum : uint8_t { PRESENT = 1, DYNAMIC = 2, HIDDEN = 4, GROWING = 8 }; // slot flags
+
+    glm::vec4 gravity   = {0.0f, -20.0f, 0.0f, 0.0f};
+    uint32_t  sub_steps = 1;
+    PhysicsParams params;
+
+    BatchSolver(tp::Executor& executor, uint32_t world_count, const HemisphereBoundary& bowl)
+        : m_executor(executor), m_worlds(world_count), m_bowls(world_count, BatchBowl(bowl)),
+          m_points(world_count, 0), m_merges(world_count, 0), m_count(world_count, 0), m_events(world_count)
+    {
+        const size_t slots = static_cast<size_t>(world_count) * MAX_OBJECTS;
+        for (std::vector<float>* v : {&px, &py, &pz, &pw, &lx, &ly, &lz, &lw, &radius, &target_radius}) v->assign(slots, 0.0f);
+        fruit.assign(slots, 0);
+        flags.assign(slots, 0);
+    }
+
+    // Per-slot state, indexed world * MAX_OBJECTS + slot
+    std::vector<float>   px, py, pz, pw; // position
+    std::vector<float>   lx, ly, lz, lw; // last position (Verlet)
+    std::vector<float>   radius, target_radius;
+    std::vector<uint8_t> fruit, flags;
+
+    uint32_t worldCount() const { return m_worlds; }
+    int      points(uint32_t world) const { return m_points[world]; }
+    uint64_t merges(uint32_t world) const { return m_merges[world]; }
+    uint32_t objectCount(uint32_t world) const { return m_count[world]; }
+    uint64_t fruitSteps() const { return m_fruit_steps; } // fruits advanced by one tick, over all updates
+    uint64_t tick() const { return m_tick; }
+
+    // Events a world keeps until they are drained. Past that the oldest are dropped and
+    // counted, so a caller that never drains does not grow the queues without bound.
+    static constexpr size_t EVENT_QUEUE_CAPACITY = 1024;
+
+    // Merge and loss events are only collected once enabled; each world keeps its own
+    // queue, so recording needs no synchronisation inside update()
+    void recordEvents(bool enabled) { m_record_events = enabled; }
+
+    size_t pendingEvents() const
+    {
+        size_t total = 0;
+        for (const EventQueue& q : m_events) total += q.events.size();
+        return total;
+    }
+
+    // Events dropped from full queues since the solver was created
+    uint64_t droppedEvents() const
+    {
+        uint64_t total = 0;
+        for (const EventQueue& q : m_events) total += q.dropped;
+        return total;
+    }
+
+    // Moves up to `capacity` queued events into `out`, in world order and oldest first
+    // within a world. The rest stays queued for the next call.
+    size_t drainEvents(BatchEvent* out, size_t capacity)
+    {
+        size_t written = 0;
+        for (EventQueue& q : m_events) {
+            while (written < capacity && !q.events.empty()) {
+                out[written++] = q.events.front();
+                q.events.pop_front();
+            }
+            if (written == capacity) break;
+        }
+        return written;
+    }
+
+    void setBowl(uint32_t world, const HemisphereBoundary& bowl) { m_bowls[world] = BatchBowl(bowl); }
+
+    // Takes the lowest free slot of the world, like PhysicSolver::addObject
+    bool addObject(uint32_t world, const PhysicsObject& object)
+    {
+        for (uint32_t i = 0; i < MAX_OBJECTS; ++i) {
+            const size_t k = index(world, i);
+            if (flags[k] & PRESENT) continue;
+            store(k, object);
+            flags[k] |= PRESENT;
+            ++m_count[world];
+            return true;
+        }
+        return false;
+    }
+
+    void clearWorld(uint32_t world)
+    {
+        for (uint32_t i = 0; i < MAX_OBJECTS; ++i) {
+            const size_t k = index(world, i);
+            flags[k] = (flags[k] & ~PRESENT) | HIDDEN;
+        }
+        m_points[world] = 0;
+        m_count[world] = 0;
+    }
+
+    // Moves a single solver's bowl in or out of the batch
+    void loadWorld(uint32_t world, const SolverState& state)
+    {
+        m_count[world] = 0;
+        for (uint32_t i = 0; i < MAX_OBJECTS; ++i) {
+            const size_t k = index(world, i);
+            store(k, state.objects[i]);
+            if (state.has_obj[i]) {
+                flags[k] |= PRESENT;
+                ++m_count[world];
+            }
+        }
+        m_points[world] = state.total_points;
+    }
+
+    void saveWorld(uint32_t world, SolverState& out) const
+    {
+        for (uint32_t i = 0; i < MAX_OBJECTS; ++i) {
+            const size_t k = index(world, i);
+            PhysicsObject& obj = out.objects[i];
+            obj.position      = glm::vec4(px[k], py[k], pz[k], pw[k]);
+            obj.last_position = glm::vec4(lx[k], ly[k], lz[k], lw[k]);
+            obj.acceleration  = glm::vec4(0.0f);
+            obj.radius        = radius[k];
+            obj.target_radius = target_radius[k];
+            obj.fruit         = static_cast<Fruit>(fruit[k]);
+            obj.dynamic       = (flags[k] & DYNAMIC) != 0;
+            obj.hidden        = (flags[k] & HIDDEN) != 0;
+            obj.growing       = (flags[k] & GROWING) != 0;
+            out.has_obj[i]    = (flags[k] & PRESENT) != 0;
+        }
+        out.total_points = m_points[world];
+    }
+
+    // One tick of every world
+    void update(float dt)
+    {
+        PROFILE_SCOPE("BatchSolver::update");
+        const float sub_dt = dt / static_cast<float>(sub_steps);
+        std::atomic<uint64_t> fruit_steps{0};
+        m_executor.dispatch(m_worlds, [&](uint32_t begin, uint32_t end) {
+            uint64_t steps = 0;
+            for (uint32_t w = begin; w < end; ++w) {
+                steps += m_count[w];
+                for (uint32_t s = sub_steps; s--;) {
+                    solveCollisions(w);
+                    integrate(w, sub_dt);
+                }
+            }
+            fruit_steps.fetch_add(steps, std::memory_order_relaxed);
+        }, "batch worlds");
+        m_fruit_steps += fruit_steps.load();
+        ++m_tick;
+    }
+
+private:
+    static size_t index(uint32_t world, uint32_t slot) { return static_cast<size_t>(world) * MAX_OBJECTS + slot; }
+
+    glm::vec4 position(size_t k) const { return glm::vec4(px[k], py[k], pz[k], pw[k]); }
+    glm::vec4 lastPosition(size_t k) const { return glm::vec4(lx[k], ly[k], lz[k], lw[k]); }
+    void setPosition(size_t k, const glm::vec4& p) { px[k] = p.x; py[k] = p.y; pz[k] = p.z; pw[k] = p.w; }
+    void setLastPosition(size_t k, const glm::vec4& p) { lx[k] = p.x; ly[k] = p.y; lz[k] = p.z; lw[k] = p.w; }
+
+    void store(size_t k, const PhysicsObject& obj)
+    {
+        setPosition(k, obj.position);
+        setLastPosition(k, obj.last_position);
+        radius[k] = obj.radius;
+        target_radius[k] = obj.target_radius;
+        fruit[k] = static_cast<uint8_t>(obj.fruit);
+        flags[k] = static_cast<uint8_t>((obj.dynamic ? DYNAMIC : 0) | (obj.hidden ? HIDDEN : 0) | (obj.growing ? GROWING : 0));
+    }
+
+    // PhysicSolver::solveCollisionsSerial on one world
+    void solveCollisions(uint32_t world)
+    {
+        uint32_t occupied[MAX_OBJECTS];
+        uint32_t count = 0;
+        const size_t base = index(world, 0);
+        for (uint32_t i = 0; i < MAX_OBJECTS; ++i) {
+            if (flags[base + i] & PRESENT) occupied[count++] = i;
+        }
+        for (uint32_t a = 0; a < count; ++a) {
+            for (uint32_t b = a + 1; b < count; ++b) {
+                const size_t i = base + occupied[a];
+                const size_t j = base + occupied[b];
+                if (!(flags[i] & flags[j] & PRESENT)) continue; // merged away earlier in this pass
+                solveContact(world, i, j);
+            }
+        }
+    }
+
+    // PhysicSolver::solveContact on slots i and j of the same world
+    void solveContact(uint32_t world, size_t i, size_t j)
+    {
+        if ((flags[i] | flags[j]) & HIDDEN) return;
+        if (!((flags[i] | flags[j]) & DYNAMIC)) return;
+
+        const glm::vec4 p1 = position(i);
+        const glm::vec4 p2 = position(j);
+        const glm::vec4 o2_o1 = p1 - p2;
+        const float dist2 = glm::dot(o2_o1, o2_o1);
+        const float combined_radius = radius[i] + radius[j];
+        if (!(dist2 < combined_radius * combined_radius && dist2 > EPS)) return;
+
+        if (fruit[i] == fruit[j]) {
+            m_points[world] += fruitPhysics(static_cast<Fruit>(fruit[j])).merge_points;
+            ++m_merges[world];
+            flags[j] = (flags[j] & ~PRESENT) | HIDDEN;
+            --m_count[world];
+            const glm::vec4 merged = (p1 + p2) / 2.0f;
+            setPosition(i, merged);
+            setLastPosition(i, merged); // the merged fruit starts at rest
+            fruit[i] = static_cast<uint8_t>(nextFruit(static_cast<Fruit>(fruit[i])));
+            target_radius[i] = fruitPhysics(static_cast<Fruit>(fruit[i])).radius;
+            flags[i] |= GROWING;
+            if (m_record_events) {
+                m_events[world].push({m_tick, world, static_cast<uint32_t>(i - index(world, 0)), BatchEventType::Merge,
+                                      static_cast<Fruit>(fruit[i]), merged});
+            }
+            return;
+        }
+
+        const float dist = std::sqrt(dist2);
+        const float penetration = combined_radius - dist;
+        if (penetration > 0.0f) {
+            const float w1 = (flags[i] & DYNAMIC) ? radius[i] * radius[i] * radius[i] : 0.0f;
+            const float w2 = (flags[j] & DYNAMIC) ? radius[j] * radius[j] * radius[j] : 0.0f;
+            setPosition(i, p1 + o2_o1 * (params.response_coef * penetration * w2) / ((w1 + w2) * dist));
+            setPosition(j, p2 - o2_o1 * (params.response_coef * penetration * w1) / ((w1 + w2) * dist));
+        }
+    }
+
+    // PhysicsObject::update followed by HemisphereBoundary::checkSphere, for every fruit of the world
+    void integrate(uint32_t world, float dt)
+    {
+        const BatchBowl& bowl = m_bowls[world];
+        const size_t base = index(world, 0);
+        for (size_t k = base; k < base + MAX_OBJECTS; ++k) {
+            if (!(flags[k] & PRESENT)) continue;
+            if (flags[k] & GROWING) {
+                radius[k] += target_radius[k] * dt * params.grow_speed;
+                if (radius[k] > target_radius[k]) {
+                    radius[k] = target_radius[k];
+                    flags[k] &= ~GROWING;
+                }
+            }
+            const glm::vec4 pos = position(k);
+            const glm::vec4 move = pos - lastPosition(k);
+            const glm::vec4 next = pos + move + (gravity - move * params.velocity_damping) * (dt * dt);
+            setLastPosition(k, pos);
+            setPosition(k, next);
+            constrain(bowl, k);
+            if (m_record_events && pos.y >= bowl.loss_y && py[k] < bowl.loss_y) {
+                m_events[world].push({m_tick, world, static_cast<uint32_t>(k - base), BatchEventType::Lost,
+                                      static_cast<Fruit>(fruit[k]), position(k)});
+            }
+        }
+    }
+
+    void constrain(const BatchBowl& bowl, size_t k)
+    {
+        glm::vec4 pos = position(k);
+        glm::vec4 last = lastPosition(k);
+        if (!bowl.constrain(pos, last, radius[k])) return;
+        setPosition(k, pos);
+        setLastPosition(k, last);
+    }
+
+    tp::Executor&          m_executor;
+    uint32_t               m_worlds;
+    std::vector<BatchBowl> m_bowls;
+    std::vector<int>       m_points;
+    std::vector<uint64_t>  m_merges;
+    std::vector<uint32_t>  m_count;
+    uint64_t               m_fruit_steps = 0;
+    uint64_t               m_tick = 0;
+
+    struct EventQueue
+    {
+        std::deque<BatchEvent> events;
+        uint64_t               dropped = 0;
+
+        void push(const BatchEvent& event)
+        {
+            if (events.size() == EVENT_QUEUE_CAPACITY) {
+                events.pop_front();
+                ++dropped;
+            }
+            events.push_back(event);
+        }
+    };
+    std::vector<EventQueue> m_events; // one per world
+    bool                    m_record_events = false;
+};
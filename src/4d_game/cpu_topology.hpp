@@ -0,0 +1,273 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+
+#if defined(__linux__) && !defined(__EMSCRIPTEN__)
+#include <pthread.h>
+#include <sched.h>
+#define TP_HAS_AFFINITY
+#endif
+
+namespace tp
+{
+
+enum class CoreKind
+{
+    Performance,
+    Efficiency,
+};
+
+struct LogicalCpu
+{
+    uint32_t id           = 0;
+    uint32_t core_id      = 0; // physical core inside the package
+    uint32_t package_id   = 0;
+    uint32_t capacity     = 0; // cpu_capacity or max frequency, whichever the kernel exposes
+    uint32_t smt_index    = 0; // 0 for the first hardware thread of a core
+    CoreKind kind         = CoreKind::Performance;
+};
+
+// Parses kernel cpu lists such as "0-3,8,10-11"
+inline std::vector<uint32_t> parseCpuList(const std::string& text)
+{
+    std::vector<uint32_t> out;
+    std::stringstream ss(text);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty() || range == "\n") continue;
+        const size_t dash = range.find('-');
+        const uint32_t first = static_cast<uint32_t>(std::strtoul(range.c_str(), nullptr, 10));
+        const uint32_t last  = dash == std::string::npos ? first
+                             : static_cast<uint32_t>(std::strtoul(range.c_str() + dash + 1, nullptr, 10));
+        for (uint32_t i = first; i <= last; ++i) out.push_back(i);
+    }
+    return out;
+}
+
+inline bool readSysFile(const std::string& path, std::string& out)
+{
+    std::ifstream file(path);
+    if (!file) return false;
+    std::getline(file, out);
+    return true;
+}
+
+inline uint32_t readSysValue(const std::string& path, uint32_t fallback)
+{
+    std::string text;
+    if (!readSysFile(path, text) || text.empty()) return fallback;
+    return static_cast<uint32_t>(std::strtoul(text.c_str(), nullptr, 10));
+}
+
+struct CpuTopology
+{
+    std::vector<LogicalCpu> cpus;
+    uint32_t                physical_cores = 0;
+    bool                    hybrid         = false;
+    bool                    from_sysfs     = false;
+
+    static CpuTopology discover()
+    {
+        CpuTopology topo;
+#ifdef __linux__
+        std::string online;
+        if (readSysFile("/sys/devices/system/cpu/online", online)) {
+            const std::string base = "/sys/devices/system/cpu/cpu";
+            for (uint32_t id : parseCpuList(online)) {
+                LogicalCpu cpu;
+                cpu.id         = id;
+                cpu.core_id    = readSysValue(base + std::to_string(id) + "/topology/core_id", id);
+                cpu.package_id = readSysValue(base + std::to_string(id) + "/topology/physical_package_id", 0);
+                // arm big.LITTLE publishes a normalised capacity, x86 only the max frequency
+                cpu.capacity   = readSysValue(base + std::to_string(id) + "/cpu_capacity",
+                                 readSysValue(base + std::to_string(id) + "/cpufreq/cpuinfo_max_freq", 0));
+                topo.cpus.push_back(cpu);
+            }
+            topo.from_sysfs = !topo.cpus.empty();
+        }
+
+        // Intel hybrid parts split the PMU into cpu_core (P) and cpu_atom (E)
+        std::string atom_list;
+        if (topo.from_sysfs && readSysFile("/sys/devices/cpu_atom/cpus", atom_list)) {
+            for (uint32_t id : parseCpuList(atom_list)) {
+                for (LogicalCpu& cpu : topo.cpus) {
+                    if (cpu.id == id) cpu.kind = CoreKind::Efficiency;
+                }
+            }
+        } else if (topo.from_sysfs) {
+            uint32_t best = 0;
+            for (const LogicalCpu& cpu : topo.cpus) best = std::max(best, cpu.capacity);
+            for (LogicalCpu& cpu : topo.cpus) {
+                // anything clearly below the fastest core class is treated as an efficiency core
+                if (best > 0 && cpu.capacity > 0 && cpu.capacity * 10 < best * 8) cpu.kind = CoreKind::Efficiency;
+            }
+        }
+#endif
+        if (topo.cpus.empty()) {
+            const uint32_t count = std::max(1u, std::thread::hardware_concurrency());
+            for (uint32_t id = 0; id < count; ++id) {
+                LogicalCpu cpu;
+                cpu.id      = id;
+                cpu.core_id = id;
+                topo.cpus.push_back(cpu);
+            }
+        }
+
+        // Number SMT siblings so that placement can prefer one thread per physical core
+        std::vector<std::pair<uint64_t, uint32_t>> seen;
+        for (LogicalCpu& cpu : topo.cpus) {
+            const uint64_t key = (static_cast<uint64_t>(cpu.package_id) << 32) | cpu.core_id;
+            auto it = std::find_if(seen.begin(), seen.end(), [key](const auto& s){ return s.first == key; });
+            if (it == seen.end()) {
+                seen.emplace_back(key, 1);
+                cpu.smt_index = 0;
+            } else {
+                cpu.smt_index = it->second++;
+            }
+            if (cpu.kind == CoreKind::Efficiency) topo.hybrid = true;
+        }
+        topo.physical_cores = static_cast<uint32_t>(seen.size());
+        return topo;
+    }
+
+    uint32_t performanceCores() const
+    {
+        uint32_t count = 0;
+        for (const LogicalCpu& cpu : cpus) {
+            if (cpu.kind == CoreKind::Performance && cpu.smt_index == 0) ++count;
+        }
+        return count;
+    }
+
+    // Preferred placement order: one hardware thread per performance core, then
+    // efficiency cores, then the remaining SMT siblings.
+    std::vector<uint32_t> placementOrder() const
+    {
+        std::vector<const LogicalCpu*> sorted;
+        for (const LogicalCpu& cpu : cpus) sorted.push_back(&cpu);
+        auto rank = [](const LogicalCpu* cpu) {
+            if (cpu->smt_index > 0) return 2;
+            return cpu->kind == CoreKind::Performance ? 0 : 1;
+        };
+        std::stable_sort(sorted.begin(), sorted.end(), [&](const LogicalCpu* a, const LogicalCpu* b) {
+            if (rank(a) != rank(b)) return rank(a) < rank(b);
+            if (a->package_id != b->package_id) return a->package_id < b->package_id;
+            return a->smt_index < b->smt_index;
+        });
+        std::vector<uint32_t> order;
+        for (const LogicalCpu* cpu : sorted) order.push_back(cpu->id);
+        return order;
+    }
+
+    const LogicalCpu* find(uint32_t id) const
+    {
+        for (const LogicalCpu& cpu : cpus) {
+            if (cpu.id == id) return &cpu;
+        }
+        return nullptr;
+    }
+
+    std::string describe() const
+    {
+        std::stringstream ss;
+        ss << cpus.size() << " logical cpus, " << physical_cores << " physical cores";
+        if (hybrid) ss << " (" << performanceCores() << " performance)";
+        if (!from_sysfs) ss << " [no sysfs topology]";
+        return ss.str();
+    }
+};
+
+// Worker count and pinning requested by the user. Zero threads means "size from topology".
+struct PoolConfig
+{
+    uint32_t    thread_count = 0;
+    bool        pin_threads  = false;
+    std::string backend;     // executor backend name, empty for the default
+
+    // SUIKA_THREADS=<n> overrides the worker count, SUIKA_PIN=1 enables core pinning,
+    // SUIKA_EXECUTOR=serial|pool|steal picks the task backend
+    static PoolConfig fromEnvironment(const char* default_backend = "")
+    {
+        PoolConfig config;
+        config.backend = default_backend;
+        if (const char* backend = std::getenv("SUIKA_EXECUTOR")) {
+            config.backend = backend;
+        }
+        if (const char* threads = std::getenv("SUIKA_THREADS")) {
+            config.thread_count = static_cast<uint32_t>(std::strtoul(threads, nullptr, 10));
+        }
+        if (const char* pin = std::getenv("SUIKA_PIN")) {
+            config.pin_threads = pin[0] != '\0' && pin[0] != '0';
+        }
+        return config;
+    }
+};
+
+struct ThreadPlacement
+{
+    int              render_cpu = -1; // cpu reserved for the GL thread, -1 when unpinned
+    std::vector<int> worker_cpus;     // one entry per worker, -1 when unpinned
+};
+
+// Upper bound of the topology-derived worker count. A bowl holds at most 100 fruits,
+// so one tick's passes are a few thousand pairs: split over more than a handful of
+// workers, each chunk gets too small to pay for its hand-off. SUIKA_THREADS still
+// asks for more.
+constexpr uint32_t DEFAULT_MAX_WORKERS = 4;
+
+// Keeps the GL thread on the first performance core and spreads workers over the
+// remaining ones. By default only performance cores are used, one thread each, up
+// to DEFAULT_MAX_WORKERS.
+inline ThreadPlacement planPlacement(const CpuTopology& topo, const PoolConfig& config)
+{
+    const std::vector<uint32_t> order = topo.placementOrder();
+
+    uint32_t worker_count = config.thread_count;
+    if (worker_count == 0) {
+        const uint32_t fast_cores = std::max(1u, topo.performanceCores());
+        worker_count = std::min(DEFAULT_MAX_WORKERS, fast_cores > 1 ? fast_cores - 1 : 1);
+    }
+
+    ThreadPlacement placement;
+    placement.worker_cpus.assign(worker_count, -1);
+    if (!config.pin_threads || order.empty()) return placement;
+
+    placement.render_cpu = static_cast<int>(order[0]);
+    for (uint32_t i = 0; i < worker_count; ++i) {
+        // wrap around (skipping the render cpu) when more workers than cpus are requested
+        const size_t slot = order.size() > 1 ? 1 + i % (order.size() - 1) : 0;
+        placement.worker_cpus[i] = static_cast<int>(order[slot]);
+    }
+    return placement;
+}
+
+inline bool pinCurrentThread(int cpu)
+{
+#ifdef TP_HAS_AFFINITY
+    if (cpu < 0) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+inline int currentCpu()
+{
+#ifdef TP_HAS_AFFINITY
+    return sched_getcpu();
+#else
+    return -1;
+#endif
+}
+
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "cpu_topology.hpp"
+#include "pool_telemetry.hpp"
+#include "profiler.hpp"
+
+#ifdef __EMSCRIPTEN__
+// For web builds, disable threading and use synchronous execution
+#define WEB_BUILD
+#endif
+
+namespace tp
+{
+
+// Common interface of the task backends (serial, shared-queue pool, work stealing).
+// dispatch() splits [0, element_count) into chunks and returns once all of them ran.
+struct Executor
+{
+    virtual ~Executor() = default;
+
+    virtual const char* name() const = 0;
+    virtual uint32_t threadCount() const = 0;
+
+    virtual void addTask(std::function<void()> callback) = 0;
+    virtual void waitForCompletion() = 0;
+    virtual void dispatch(uint32_t element_count,
+                          const std::function<void(uint32_t, uint32_t)>& callback,
+                          const char* label = "dispatch") = 0;
+
+    virtual PoolStats stats() const = 0;
+    virtual void resetStats() = 0;
+
+    virtual std::string placementReport(const CpuTopology& topo) const
+    {
+        (void)topo;
+        return std::string(name()) + " executor runs tasks on the calling thread\n";
+    }
+};
+
+// Runs everything inline on the calling thread: no queue, no atomics, no waiting.
+// Used for single-core hosts, web builds and cloned solvers stepped inside a task.
+// Its only worker is the caller, so time the caller spends outside tasks since the
+// last reset counts as idle and utilization is the share of wall time spent in tasks.
+// Telemetry is plain counters without locks: stats() and resetStats() must not run
+// concurrently with a dispatch (the game reads them between ticks).
+struct SerialExecutor : Executor
+{
+    WorkerStats      m_counters;
+    DispatchTable    m_dispatch_stats;
+    bool             m_telemetry = true;
+    uint64_t         m_stats_since = nowNs();
+
+    explicit
+    SerialExecutor(bool telemetry = true)
+        : m_telemetry{telemetry}
+    {}
+
+    const char* name() const override { return "serial"; }
+    uint32_t threadCount() const override { return 1; }
+
+    void addTask(std::function<void()> callback) override
+    {
+        if (!m_telemetry) {
+            callback();
+            return;
+        }
+        const uint64_t start = nowNs();
+        callback();
+        m_counters.tasks_run++;
+        m_counters.busy_ns += nowNs() - start;
+    }
+
+    void waitForCompletion() override {}
+
+    void dispatch(uint32_t element_count,
+                  const std::function<void(uint32_t, uint32_t)>& callback,
+                  const char* label = "dispatch") override
+    {
+        if (element_count == 0) return;
+        PROFILE_SCOPE(label);
+        if (!m_telemetry) {
+            callback(0, element_count);
+            return;
+        }
+        const uint64_t start = nowNs();
+        callback(0, element_count);
+        const uint64_t elapsed = nowNs() - start;
+        m_counters.tasks_run++;
+        m_counters.busy_ns += elapsed;
+        m_dispatch_stats.record(label, &elapsed, 1, elapsed);
+    }
+
+    PoolStats stats() const override
+    {
+        PoolStats out;
+        out.backend      = name();
+        out.thread_count = 1;
+        out.workers.push_back(m_counters);
+        if (m_telemetry) {
+            const uint64_t wall = nowNs() - m_stats_since;
+            out.workers.back().idle_ns = wall > m_counters.busy_ns ? wall - m_counters.busy_ns : 0;
+        }
+        out.dispatches   = m_dispatch_stats.m_stats;
+        return out;
+    }
+
+    void resetStats() override
+    {
+        m_counters = WorkerStats{};
+        m_dispatch_stats.reset();
+        m_stats_since = nowNs();
+    }
+};
+
+}
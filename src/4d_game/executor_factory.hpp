@@ -0,0 +1,41 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <iostream>
+
+#include "executor.hpp"
+#include "threadpool.hpp"
+#include "work_stealing_pool.hpp"
+
+// Backend used when SUIKA_EXECUTOR is not set; can be overridden at compile time
+#ifndef SUIKA_DEFAULT_EXECUTOR
+#define SUIKA_DEFAULT_EXECUTOR ""
+#endif
+
+namespace tp
+{
+
+// backend: "serial", "pool" or "steal". An empty name picks serial when there is only
+// one worker to run on (a pool of one just adds hand-off latency) and the pool otherwise.
+inline std::unique_ptr<Executor> makeExecutor(const std::string& backend, const ThreadPlacement& placement)
+{
+    const uint32_t worker_count = static_cast<uint32_t>(placement.worker_cpus.size());
+#ifdef WEB_BUILD
+    (void)backend;
+    (void)worker_count;
+    return std::make_unique<SerialExecutor>();
+#else
+    if (backend == "serial" || (backend.empty() && worker_count <= 1)) {
+        return std::make_unique<SerialExecutor>();
+    }
+    if (backend == "steal") {
+        return std::make_unique<WorkStealingPool>(worker_count, placement.worker_cpus);
+    }
+    if (!backend.empty() && backend != "pool") {
+        std::cerr << "Unknown executor '" << backend << "', using the thread pool" << std::endl;
+    }
+    return std::make_unique<ThreadPool>(worker_count, placement.worker_cpus);
+#endif
+}
+
+}
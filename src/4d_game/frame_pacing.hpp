@@ -0,0 +1,315 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#ifndef __EMSCRIPTEN__
+// WebGL2 has no timer queries, desktop GL 3.3 core always does
+#define GPU_TIMER_QUERIES
+#endif
+
+enum class PacingMode {
+    Vsync,    // swap interval 1, the driver blocks in SwapBuffers
+    Adaptive, // swap interval -1 (tear instead of waiting when a frame is late), falls back to vsync
+    Hybrid,   // no vsync: sleep most of the remaining frame time, then spin to the deadline
+    Off,      // no vsync and no cap
+};
+
+inline const char* pacingModeName(PacingMode mode)
+{
+    switch (mode) {
+        case PacingMode::Vsync:    return "vsync";
+        case PacingMode::Adaptive: return "adaptive";
+        case PacingMode::Hybrid:   return "hybrid";
+        case PacingMode::Off:      return "off";
+    }
+    return "?";
+}
+
+struct PacingConfig {
+    PacingMode mode = PacingMode::Hybrid;
+    float target_fps = 60.0f;
+
+    // SUIKA_PACING=vsync|adaptive|hybrid|off, SUIKA_FPS=<target> (hybrid only)
+    static PacingConfig fromEnvironment() {
+        PacingConfig config;
+        if (const char* mode = std::getenv("SUIKA_PACING")) {
+            if (!std::strcmp(mode, "vsync")) config.mode = PacingMode::Vsync;
+            else if (!std::strcmp(mode, "adaptive")) config.mode = PacingMode::Adaptive;
+            else if (!std::strcmp(mode, "hybrid")) config.mode = PacingMode::Hybrid;
+            else if (!std::strcmp(mode, "off")) config.mode = PacingMode::Off;
+        }
+        if (const char* fps = std::getenv("SUIKA_FPS")) {
+            const float target = static_cast<float>(std::atof(fps));
+            if (target > 0.0f) config.target_fps = target;
+        }
+        return config;
+    }
+};
+
+// Measures GPU time between Begin() and End() with timestamp queries. Results are
+// read a few frames later so the CPU never stalls on the GPU; timestamps (unlike
+// GL_TIME_ELAPSED) may be interleaved, so several timers can run in the same frame.
+struct GpuTimer {
+    static const int LATENCY = 4;
+
+    unsigned int queries[LATENCY][2] = {};
+    bool pending[LATENCY] = {};
+    int index = 0;
+    bool active = false;
+    bool initialized = false;
+    float last_ms = 0.0f;
+
+    void Init() {
+#ifdef GPU_TIMER_QUERIES
+        if (initialized) return;
+        glGenQueries(LATENCY * 2, &queries[0][0]);
+        initialized = true;
+#endif
+    }
+
+    void Release() {
+#ifdef GPU_TIMER_QUERIES
+        if (!initialized) return;
+        glDeleteQueries(LATENCY * 2, &queries[0][0]);
+        initialized = false;
+#endif
+    }
+
+    void Begin() {
+        active = false;
+#ifdef GPU_TIMER_QUERIES
+        if (!initialized) return;
+        Poll();
+        if (pending[index]) return; // GPU is more than LATENCY frames behind, skip this sample
+        glQueryCounter(queries[index][0], GL_TIMESTAMP);
+        active = true;
+#endif
+    }
+
+    void End() {
+#ifdef GPU_TIMER_QUERIES
+        if (!active) return;
+        glQueryCounter(queries[index][1], GL_TIMESTAMP);
+        pending[index] = true;
+        index = (index + 1) % LATENCY;
+        active = false;
+#endif
+    }
+
+    // Picks up finished samples, oldest first
+    void Poll() {
+#ifdef GPU_TIMER_QUERIES
+        for (int k = 0; k < LATENCY; ++k) {
+            const int slot = (index + k) % LATENCY;
+            if (!pending[slot]) continue;
+            GLint available = 0;
+            glGetQueryObjectiv(queries[slot][1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) return;
+            GLuint64 begin_ns = 0, end_ns = 0;
+            glGetQueryObjectui64v(queries[slot][0], GL_QUERY_RESULT, &begin_ns);
+            glGetQueryObjectui64v(queries[slot][1], GL_QUERY_RESULT, &end_ns);
+            last_ms = static_cast<float>(end_ns - begin_ns) * 1e-6f;
+            pending[slot] = false;
+        }
+#endif
+    }
+};
+
+struct FrameTiming {
+    float frame_ms = 0.0f;   // start of this frame to start of the next
+    float cpu_ms = 0.0f;     // frame start until SwapBuffers is issued
+    float gpu_ms = 0.0f;     // GPU time of the frame's commands (reported a few frames late)
+    float present_ms = 0.0f; // time spent inside SwapBuffers
+    float wait_ms = 0.0f;    // time spent by the pacer
+};
+
+struct FrameTimeStats {
+    float mean_ms = 0.0f;
+    float stddev_ms = 0.0f;
+    float p50_ms = 0.0f;
+    float p99_ms = 0.0f;
+    float max_ms = 0.0f;
+    size_t frames = 0;
+};
+
+class FramePacer {
+public:
+    static const size_t HISTORY = 240;
+
+    PacingConfig config;
+    std::array<FrameTiming, HISTORY> history;
+    size_t frame_count = 0;
+    GpuTimer gpu_timer;
+
+    void Init(GLFWwindow* window, const PacingConfig& cfg) {
+        config = cfg;
+        (void)window;
+        switch (config.mode) {
+            case PacingMode::Vsync:
+                glfwSwapInterval(1);
+                break;
+            case PacingMode::Adaptive:
+                if (glfwExtensionSupported("WGL_EXT_swap_control_tear") || glfwExtensionSupported("GLX_EXT_swap_control_tear")) {
+                    glfwSwapInterval(-1);
+                } else {
+                    config.mode = PacingMode::Vsync;
+                    glfwSwapInterval(1);
+                }
+                break;
+            case PacingMode::Hybrid:
+            case PacingMode::Off:
+                glfwSwapInterval(0);
+                break;
+        }
+        gpu_timer.Init();
+        period = Clock::duration(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / config.target_fps)));
+        frame_start = Clock::now();
+        deadline = frame_start + period;
+    }
+
+    void Release() {
+        gpu_timer.Release();
+    }
+
+    // Call at the top of the loop, before any GL work of the frame
+    void BeginFrame() {
+        const Clock::time_point now = Clock::now();
+        if (frame_count > 0) {
+            FrameTiming& previous = current();
+            // after an idle gap only the time spent on the frame itself is meaningful
+            previous.frame_ms = suspended ? previous.cpu_ms + previous.present_ms + previous.wait_ms
+                                          : Milliseconds(now - frame_start);
+        }
+        suspended = false;
+        ++frame_count;
+        current() = FrameTiming();
+        frame_start = now;
+        gpu_timer.Begin();
+    }
+
+    // Replaces glfwSwapBuffers: closes the GPU sample and times the present call
+    void Present(GLFWwindow* window) {
+        gpu_timer.End();
+        const Clock::time_point before = Clock::now();
+        current().cpu_ms = Milliseconds(before - frame_start);
+        glfwSwapBuffers(window);
+        current().present_ms = Milliseconds(Clock::now() - before);
+        current().gpu_ms = gpu_timer.last_ms;
+    }
+
+    // Hybrid pacing: sleep until shortly before the deadline, then spin. The spin
+    // margin follows the measured scheduler oversleep, so short sleeps stay accurate.
+    void Wait() {
+        if (config.mode != PacingMode::Hybrid) return;
+        const Clock::time_point wait_start = Clock::now();
+        // a frame that overran the deadline starts a new schedule instead of bursting
+        if (wait_start > deadline + period) deadline = wait_start;
+
+        const Clock::duration remaining = deadline - wait_start;
+        if (remaining > spin_margin) {
+            const Clock::duration request = remaining - spin_margin;
+            const Clock::time_point before = Clock::now();
+            std::this_thread::sleep_for(request);
+            const float oversleep_ms = Milliseconds(Clock::now() - before) - Milliseconds(request);
+            oversleep_ema_ms += 0.1f * (std::max(0.0f, oversleep_ms) - oversleep_ema_ms);
+            const float margin_ms = std::min(3.0f, std::max(0.2f, oversleep_ema_ms * 2.0f + 0.1f));
+            spin_margin = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float, std::milli>(margin_ms));
+        }
+#ifndef __EMSCRIPTEN__
+        while (Clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+#endif
+        deadline += period;
+        current().wait_ms = Milliseconds(Clock::now() - wait_start);
+    }
+
+    // The loop stopped producing frames for a while (idle mode)
+    void Suspend() {
+        suspended = true;
+    }
+
+    const FrameTiming& Last() const {
+        return history[(frame_count + HISTORY - 2) % HISTORY];
+    }
+
+    // Completed frames only, oldest first
+    std::vector<FrameTiming> Recent() const {
+        std::vector<FrameTiming> out;
+        const size_t count = frame_count > 1 ? std::min(frame_count - 1, HISTORY - 1) : 0;
+        for (size_t k = count; k > 0; --k) {
+            out.push_back(history[(frame_count - 1 - k) % HISTORY]);
+        }
+        return out;
+    }
+
+    FrameTimeStats Stats() const {
+        FrameTimeStats stats;
+        std::vector<float> frames;
+        for (const FrameTiming& t : Recent()) frames.push_back(t.frame_ms);
+        if (frames.empty()) return stats;
+        stats.frames = frames.size();
+        double sum = 0.0, sum_sq = 0.0;
+        for (float ms : frames) {
+            sum += ms;
+            sum_sq += static_cast<double>(ms) * ms;
+        }
+        stats.mean_ms = static_cast<float>(sum / frames.size());
+        stats.stddev_ms = static_cast<float>(std::sqrt(std::max(0.0, sum_sq / frames.size() - static_cast<double>(stats.mean_ms) * stats.mean_ms)));
+        std::sort(frames.begin(), frames.end());
+        stats.p50_ms = frames[frames.size() / 2];
+        stats.p99_ms = frames[std::min(frames.size() - 1, frames.size() * 99 / 100)];
+        stats.max_ms = frames.back();
+        return stats;
+    }
+
+    std::string Summary() const {
+        const FrameTimeStats stats = Stats();
+        float cpu = 0.0f, gpu = 0.0f, present = 0.0f;
+        const std::vector<FrameTiming> recent = Recent();
+        for (const FrameTiming& t : recent) {
+            cpu += t.cpu_ms;
+            gpu += t.gpu_ms;
+            present += t.present_ms;
+        }
+        const float n = recent.empty() ? 1.0f : static_cast<float>(recent.size());
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(2)
+           << "pacing " << pacingModeName(config.mode);
+        if (config.mode == PacingMode::Hybrid) ss << " @" << config.target_fps << "fps";
+        ss << "  frame " << stats.mean_ms << "ms (sd " << stats.stddev_ms << ", p99 " << stats.p99_ms
+           << ", max " << stats.max_ms << ")  cpu " << cpu / n << "ms  gpu " << gpu / n
+           << "ms  present " << present / n << "ms  over " << stats.frames << " frames";
+        return ss.str();
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static float Milliseconds(Clock::duration d) {
+        return std::chrono::duration<float, std::milli>(d).count();
+    }
+
+    FrameTiming& current() {
+        return history[(frame_count + HISTORY - 1) % HISTORY];
+    }
+
+    Clock::time_point frame_start;
+    Clock::time_point deadline;
+    Clock::duration period = std::chrono::milliseconds(16);
+    Clock::duration spin_margin = std::chrono::milliseconds(1);
+    float oversleep_ema_ms = 0.5f;
+    bool suspended = false;
+};
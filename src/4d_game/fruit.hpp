@@ -1,24 +1,13 @@
 #ifndef FRUIT_MANAGER_HPP
 #define FRUIT_MANAGER_HPP
 
+#include <algorithm>
+#include <cctype>
 #include <unordered_map>
 #include <string>
 #include "learnopengl/filesystem.h"
 #include "render_helper.hpp"
-
-enum Fruit {
-    CHERRY,
-    STRAWBERRY,
-    GRAPE,
-    DEKOPON,
-    PERSIMMON,
-    APPLE,
-    PEAR,
-    PEACH,
-    PINEAPPLE,
-    MELON,
-    WATERMELON,
-};
+#include "fruit_data.hpp"
 
 struct FruitProperties {
     float radius;
@@ -33,6 +22,7 @@ struct FruitProperties {
 class FruitManager {
 private:
     inline static std::unordered_map<Fruit, FruitProperties> fruitPropertiesMap;
+    inline static Pcg32 random;
     
     
 public:
@@ -49,113 +39,113 @@ public:
         // Each fruit gets progressively larger
         
         fruitPropertiesMap[CHERRY] = {
-            0.33f,  // radius
+            fruitPhysics(CHERRY).radius,  // radius
             0.1f,   // metallic
             0.8f,   // roughness
             1.0f,   // ao
             1.0f,   // alpha
             loadTexture(FileSystem::getPath("resources/textures/fruits/cherry.png").c_str()),
-            1,
+            fruitPhysics(CHERRY).merge_points,
         };
         
         fruitPropertiesMap[STRAWBERRY] = {
-            0.48f,
+            fruitPhysics(STRAWBERRY).radius,
             0.1f,
             0.7f,
             1.0f,
             1.0f,
             loadTexture(FileSystem::getPath("resources/textures/fruits/strawberry.png").c_str()),
-            3,
+            fruitPhysics(STRAWBERRY).merge_points,
         };
         
         fruitPropertiesMap[GRAPE] = {
-            0.63f,
+            fruitPhysics(GRAPE).radius,
             0.2f,
             0.6f,
             1.0f,
             1.0f,
             loadTexture(FileSystem::getPath("resources/textures/fruits/grape.png").c_str()),
-            6,
+            fruitPhysics(GRAPE).merge_points,
         };
         
         fruitPropertiesMap[DEKOPON] = {
-            0.78f,
+            fruitPhysics(DEKOPON).radius,
             0.1f,
             0.5f,
             1.0f,
             1.0f,
             loadTexture(FileSystem::getPath("resources/textures/fruits/dekopon.png").c_str()),
-            10,
+            fruitPhysics(DEKOPON).merge_points,
         };
         
         fruitPropertiesMap[PERSIMMON] = {
-            0.93f,
+            fruitPhysics(PERSIMMON).radius,
             0.1f,
             0.6f,
             1.0f,
             1.0f,
             loadTexture(FileSystem::getPath("resources/textures/fruits/persimmon.png").c_str()),
-            15,
+            fruitPhysics(PERSIMMON).merge_points,
         };
         
         fruitPropertiesMap[APPLE] = {
-            1.08f,
+            fruitPhysics(APPLE).radius,
             0.2f,
             0.4f,
             1.0f,
             1.0f,
             loadTexture(FileSystem::getPath("resources/textures/fruits/apple.png").c_str()),
-            21,
+            fruitPhysics(APPLE).merge_points,
         };
         
         fruitPropertiesMap[PEAR] = {
-            1.23f,
+            fruitPhysics(PEAR).radius,
             0.1f,
             0.5f,
             1.0f,
             1.0f,
             loadTexture(FileSystem::getPath("resources/textures/fruits/pear.png").c_str()),
-            28,
+            fruitPhysics(PEAR).merge_points,
         };
         
         fruitPropertiesMap[PEACH] = {
-            1.38f,
+            fruitPhysics(PEACH).radius,
             0.1f,
             0.3f,
             1.0f,
             1.0f,
             loadTexture(FileSystem::getPath("resources/textures/fruits/peach.png").c_str()),
-            36,
+            fruitPhysics(PEACH).merge_points,
         };
         
         fruitPropertiesMap[PINEAPPLE] = {
-            1.53f,
+            fruitPhysics(PINEAPPLE).radius,
             0.2f,
             0.7f,
             1.0f,
             1.0f,
             loadTexture(FileSystem::getPath("resources/textures/fruits/pineapple.png").c_str()),
-            45,
+            fruitPhysics(PINEAPPLE).merge_points,
         };
         
         fruitPropertiesMap[MELON] = {
-            1.68f,
+            fruitPhysics(MELON).radius,
             0.1f,
             0.4f,
             1.0f,
             1.0f,
             loadTexture(FileSystem::getPath("resources/textures/fruits/melon.png").c_str()),
-            55,
+            fruitPhysics(MELON).merge_points,
         };
         
         fruitPropertiesMap[WATERMELON] = {
-            2.0f,
+            fruitPhysics(WATERMELON).radius,
             0.1f,
             0.5f,
             1.0f,
             1.0f,
             loadTexture(FileSystem::getPath("resources/textures/fruits/watermelon.png").c_str()),
-            66,
+            fruitPhysics(WATERMELON).merge_points,
         };
     }
     
@@ -166,20 +156,7 @@ public:
     
     // Get the next evolution fruit (for merging)
     static Fruit getNextFruit(Fruit currentFruit) {
-        switch(currentFruit) {
-            case CHERRY: return STRAWBERRY;
-            case STRAWBERRY: return GRAPE;
-            case GRAPE: return DEKOPON;
-            case DEKOPON: return PERSIMMON;
-            case PERSIMMON: return APPLE;
-            case APPLE: return PEAR;
-            case PEAR: return PEACH;
-            case PEACH: return PINEAPPLE;
-            case PINEAPPLE: return MELON;
-            case MELON: return WATERMELON;
-            case WATERMELON: return WATERMELON; // Max evolution
-            default: return CHERRY;
-        }
+        return nextFruit(currentFruit);
     }
     
     // Check if fruit can evolve further
@@ -214,17 +191,30 @@ public:
         }
     }
     
+    // Albedo image of a fruit, e.g. resources/textures/fruits/cherry.png
+    static std::string texturePath(Fruit fruit) {
+        std::string name = getFruitName(fruit);
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return FileSystem::getPath("resources/textures/fruits/" + name + ".png");
+    }
+
     // Get a random fruit from the first 5 fruits (cherry through persimmon)
     static Fruit getRandomFruit(){
-        static const Fruit randomFruits[] = {
-            CHERRY,
-            STRAWBERRY, 
-            GRAPE,
-            DEKOPON,
-            PERSIMMON
-        };
-        int randomIndex = rand() % 5;
-        return randomFruits[randomIndex];
+        return randomDropFruit(random);
+    }
+
+    // Restarts the fruit sequence; replays record the seed
+    static void seedRandom(uint64_t seed){
+        random.seed(seed);
+    }
+
+    // Position in the fruit sequence, for save games
+    static Pcg32 randomState(){
+        return random;
+    }
+
+    static void setRandomState(const Pcg32& state){
+        random = state;
     }
 
     // Cleanup textures
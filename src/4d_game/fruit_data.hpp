@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+
+// Gameplay data of the fruits, without any rendering state, so the solver, replays
+// and tools can run without a GL context. FruitManager adds the textures and materials.
+
+enum Fruit {
+    CHERRY,
+    STRAWBERRY,
+    GRAPE,
+    DEKOPON,
+    PERSIMMON,
+    APPLE,
+    PEAR,
+    PEACH,
+    PINEAPPLE,
+    MELON,
+    WATERMELON,
+};
+
+const int FRUIT_COUNT = WATERMELON + 1;
+
+struct FruitPhysics {
+    float radius;
+    int merge_points;
+};
+
+// Radii from 0.33 to 2.0, each fruit progressively larger
+inline const FruitPhysics& fruitPhysics(Fruit fruit) {
+    static const FruitPhysics table[FRUIT_COUNT] = {
+        {0.33f, 1},  // CHERRY
+        {0.48f, 3},  // STRAWBERRY
+        {0.63f, 6},  // GRAPE
+        {0.78f, 10}, // DEKOPON
+        {0.93f, 15}, // PERSIMMON
+        {1.08f, 21}, // APPLE
+        {1.23f, 28}, // PEAR
+        {1.38f, 36}, // PEACH
+        {1.53f, 45}, // PINEAPPLE
+        {1.68f, 55}, // MELON
+        {2.0f,  66}, // WATERMELON
+    };
+    return table[fruit];
+}
+
+// The fruit two of the same kind merge into
+inline Fruit nextFruit(Fruit fruit) {
+    return fruit == WATERMELON ? WATERMELON : static_cast<Fruit>(fruit + 1);
+}
+
+// PCG32 (XSH RR): small, fast and identical on every platform and standard library,
+// which rand() is not. Replays store the seed to reproduce the fruit sequence.
+struct Pcg32 {
+    uint64_t state = 0;
+    uint64_t inc = 1;
+
+    Pcg32() { seed(0x853c49e6748fea9bull); }
+    explicit Pcg32(uint64_t initial, uint64_t sequence = 0xda3e39cb94b95bdbull) { seed(initial, sequence); }
+
+    void seed(uint64_t initial, uint64_t sequence = 0xda3e39cb94b95bdbull) {
+        state = 0;
+        inc = (sequence << 1u) | 1u;
+        next();
+        state += initial;
+        next();
+    }
+
+    uint32_t next() {
+        const uint64_t old = state;
+        state = old * 6364136223846793005ull + inc;
+        const uint32_t xorshifted = static_cast<uint32_t>(((old >> 18u) ^ old) >> 27u);
+        const uint32_t rot = static_cast<uint32_t>(old >> 59u);
+        return (xorshifted >> rot) | (xorshifted << ((32u - rot) & 31u));
+    }
+
+    // Uniform in [0, bound) without modulo bias
+    uint32_t below(uint32_t bound) {
+        const uint32_t threshold = (0u - bound) % bound;
+        for (;;) {
+            const uint32_t r = next();
+            if (r >= threshold) return r % bound;
+        }
+    }
+};
+
+// Drops are drawn from the first five fruits (cherry through persimmon)
+inline Fruit randomDropFruit(Pcg32& rng) {
+    return static_cast<Fruit>(rng.below(5));
+}
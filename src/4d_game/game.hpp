@@ -3,6 +3,7 @@
 #include <tuple>
 #include <random>
 #include <thread>
+#include <future>
 #include <algorithm>
 
 #include <glad/glad.h>
@@ -21,19 +22,32 @@
 #include "learnopengl/model.h"
 #include "filesystem.h"
 
-#include "threadpool.hpp"
+#include "executor_factory.hpp"
+#include "cpu_topology.hpp"
 
 #include "hemisphere_renderer.hpp"
 #include "ballrenderer.hpp"
+#include "instanced_ball_renderer.hpp"
 #include "text_renderer.h"
 #include "shape.hpp"
 
 #include "hemisphere_boundary.hpp"
+#include "static_colliders.hpp"
 #include "physics_solver.hpp"
+#ifndef __EMSCRIPTEN__
+#include "gpu_physics.hpp"
+#endif
+#include "simulation_thread.hpp"
+#include "autoplayer.hpp"
+#include "save_game.hpp"
 
 #include "render_helper.hpp"
 #include "state_helper.hpp"
 #include "fruit.hpp"
+#include "frame_pacing.hpp"
+#include "perf_overlay.hpp"
+#include "idle_mode.hpp"
+#include "profiler.hpp"
 
 enum GameState {
     GAME_ACTIVE,
@@ -45,6 +59,10 @@ const float light_radius = 1000.0f;
 const float angle_in_sky = glm::radians(10.0f);
 const float max_height = light_radius*sin(angle_in_sky); // height of the sun at its peak (noon)
 
+// Layers of Game::fruitTextureArray: one per fruit (the fruit textures are 512x512), then gold
+const int FRUIT_TEXTURE_SIZE = 512;
+const int BOWL_LAYER = FRUIT_COUNT;
+
 float ShakeTime = 0.0f;
 float                   angle=0;
 float                   angle_speed=10;
@@ -136,15 +154,21 @@ public:
     unsigned int backgroundTexture;
     unsigned int defaultTexture;
     unsigned int bowlTexture;
+    unsigned int fruitTextureArray; // layer per fruit, then BOWL_LAYER
 
     BallRenderer    *b_rend;
+    InstancedBallRenderer *i_rend;
     HemisphereRenderer    *h_rend;
     TextRenderer    *t_rend;
 
     PhysicSolver *physics_solver;
-    tp::ThreadPool *thread_pool;
+    SimulationThread *simulation;
+    tp::Executor *thread_pool;
+    tp::CpuTopology topology;
+    tp::ThreadPlacement placement;
     Shader *background_shader;
     Shader *ball_shader;
+    Shader *instanced_shader;
     Shader *text_shader;
     Shader *model_shader;
     Model* tableModel;
@@ -160,11 +184,70 @@ public:
 
     int total_points=0;
     int high_score = 0;
+    uint64_t merges_heard = 0;
+    RenderState frame_state;     // interpolated between the last two physics ticks
+    float physics_alpha = 1.0f;  // set by the main loop when physics runs on this thread
     ViewState state;
     VolumeSettings vset;
+    FramePacer pacer;
+    PerfOverlay overlay;
+    IdleMode idle;
 
     bool ballPlaced=false;
 
+    // Chrome trace capture (F4 toggles, --trace <file> captures the whole run)
+    std::string trace_path;
+    int trace_count = 0;
+
+    // Replay recording (--record <file>) and the fruit sequence seed (--seed <n>)
+    std::string record_path;
+    uint64_t fruit_seed = std::random_device{}();
+    std::unique_ptr<ReplayRecorder> recorder;
+    std::unique_ptr<tp::Executor> record_executor; // serial solver executor while recording
+
+    // Monte Carlo bot (F6 toggles, --autoplay <moves> plays headless)
+    std::unique_ptr<AutoPlayer> bot;
+    std::unique_ptr<tp::Executor> bot_executor;
+    bool bot_active = false;
+    float bot_timer = 0.0f;
+    SolverState bot_state;                      // read by the search in flight
+    std::future<AutoPlayerMove> bot_search;
+    uint64_t bot_epoch = 0;                     // bumped by Reset and F6: older searches are dropped
+    uint64_t bot_search_epoch = 0;
+
+    // Live stream of the bowl for spectators (--spectate <endpoint>)
+    std::string spectate_endpoint;
+    std::unique_ptr<SpectatorPublisher> spectator;
+
+    // Static props of the level (--props <file>): pegs and obstacle fruits that never move
+    std::string props_path;
+    StaticColliders props;
+
+    // Level of detail along w (--physics-lod <ticks>): fruits away from the three rendered
+    // slices step every <ticks> ticks. Off while recording, since the view is not replayed.
+    uint32_t physics_lod = 0;
+
+    // Compute shader physics (--gpu-physics): steps on the GL thread instead of the
+    // simulation thread. Off while recording, since GPU results are not bit-exact.
+    bool gpu_physics = false;
+#ifndef __EMSCRIPTEN__
+    GpuPhysics gpu;
+#endif
+
+    // Per-tick physics health written to CSV or JSON Lines (--physics-log <file>)
+    std::string physics_log_path;
+    PhysicsLog physics_log;
+
+    // Save game (--save <file>, --no-save): written on pause and exit, resumed at start
+#ifdef __EMSCRIPTEN__
+    std::string save_path;
+#else
+    std::string save_path = "suika4d.s4ds";
+#endif
+    bool game_lost = false;
+    SolverState save_state;
+    std::vector<SaveObject> save_objects;
+
     // constructor/destructor
     Game(unsigned int width, unsigned int height) : boundary(glm::vec4(0.0f), 3, 90.0f, 0.1f) {
         State = GAME_MENU;
@@ -177,47 +260,59 @@ public:
             KeysProcessed[i] = false;
         }
 
-        unsigned int thread_count = 1;
-        
+        // Size the pool from the cpu topology (one worker per performance core, minus the GL thread)
+        tp::PoolConfig pool_config = tp::PoolConfig::fromEnvironment(SUIKA_DEFAULT_EXECUTOR);
         #ifdef __EMSCRIPTEN__
-            thread_count = 1;
-        #else
-            thread_count = std::thread::hardware_concurrency();
-            if (thread_count == 0) thread_count = 1; // Fallback to single thread
-            if (thread_count > 4) thread_count = 4; // Cap at 4 threads
+            pool_config.thread_count = 1;
+            pool_config.pin_threads = false;
         #endif
-        
-        thread_pool = new tp::ThreadPool(thread_count);
+        topology = tp::CpuTopology::discover();
+        placement = tp::planPlacement(topology, pool_config);
+
+        // Web builds and single-worker hosts get the inline serial executor
+        thread_pool = tp::makeExecutor(pool_config.backend, placement).release();
 
         // glm::vec3 center, float radius, float angleDegrees = 90.0f, float margin = 0.01f
         physics_solver = new PhysicSolver(*thread_pool, &boundary);
         // physics_solver = new PhysicSolver(*thread_pool);
+        // SUIKA_PHYSICS_HZ=<rate> changes the tick rate; rendering interpolates between ticks
+        float physics_timestep = PHYSICS_TIMESTEP;
+        if (const char* hz = std::getenv("SUIKA_PHYSICS_HZ")) {
+            const float rate = static_cast<float>(std::atof(hz));
+            if (rate > 0.0f) physics_timestep = 1.0f / rate;
+        }
+        simulation = new SimulationThread(*physics_solver, physics_timestep);
         total_points = 0;
 
     }
     ~Game(){
+        if (bot_search.valid()) bot_search.wait(); // the search uses bot and bot_executor
         Mix_FreeChunk(mergeSound);
         Mix_CloseAudio();
         SDL_Quit();
 
         delete b_rend;
+        delete i_rend;
         delete h_rend;
         delete t_rend;
+        delete simulation; // joins the simulation thread before the solver goes away
         delete physics_solver;
         delete thread_pool;
     }
+    // Keeps the GL thread on its own core when pinning is enabled and logs where every thread landed
+    void PinRenderThread(){
+        bool pinned = tp::pinCurrentThread(placement.render_cpu);
+        std::cout << "CPU topology: " << topology.describe() << std::endl;
+        std::cout << "render thread " << (pinned ? "pinned to cpu " : "unpinned, on cpu ") << tp::currentCpu() << std::endl;
+        std::cout << "executor: " << thread_pool->name() << std::endl;
+        std::cout << thread_pool->placementReport(topology);
+    }
     void Reset(){
-        // Clear all objects in the physics solver
-        for (int i = 0; i < MAX_OBJECTS; ++i) {
-            if (physics_solver->has_obj[i]) {
-                physics_solver->removeObject(i);
-            }
-        }
-        // Reset physics solver internal state
-        physics_solver->reset();  // Assuming you have or can add this method
+        simulation->resetSolver();
+        ++bot_epoch;
         // Reset points
         total_points = 0;
-        physics_solver->total_points = 0;
+        game_lost = false;
 
         // Reset the fruit manager state (if needed)
         fm.initializeFruits();
@@ -236,12 +331,17 @@ public:
     }
     // initialize game state (load all shaders/textures/levels)
     void Init(GLFWwindow* window){
+        PROFILE_SCOPE("Game::Init");
+        prof::Zone load_shaders("load shaders");
         ball_shader = new Shader(FileSystem::getPath("resources/shaders/pbr.vs").c_str(), FileSystem::getPath("resources/shaders/pbr.fs").c_str());
+        instanced_shader = new Shader(FileSystem::getPath("resources/shaders/pbr_instanced.vs").c_str(), FileSystem::getPath("resources/shaders/pbr_instanced.fs").c_str());
         background_shader = new Shader(FileSystem::getPath("resources/shaders/background.vs").c_str(), FileSystem::getPath("resources/shaders/background.fs").c_str());
         text_shader = new Shader(FileSystem::getPath("resources/shaders/text_2d.vs").c_str(), FileSystem::getPath("resources/shaders/text_2d.fs").c_str());
         model_shader = ball_shader;
         // new Shader(FileSystem::getPath("resources/shaders/table.vs").c_str(), FileSystem::getPath("resources/shaders/table.fs").c_str());
 
+        load_shaders.end();
+        prof::Zone load_model("load model");
         tableModel = new Model(FileSystem::getPath("resources/models/flyingIsland/flyingIsland.obj").c_str()); 
         // tableModel = new Model(FileSystem::getPath("resources/models/skyisland/skyisland.obj").c_str()); 
         // Load shaders with error handling
@@ -275,7 +375,10 @@ public:
         //     std::cerr << "[ball_shader] Link error:\n" << infoLog << std::endl;
         // }
 
+        load_model.end();
+        prof::Zone load_font("load meshes and font");
         b_rend = new BallRenderer(ball_shader, SPHERE, 5);
+        i_rend = new InstancedBallRenderer(instanced_shader, SPHERE, 5);
         h_rend = new HemisphereRenderer(ball_shader, SPHERE, 5, 90.0f, 1.0f, boundary.margin/boundary.radius);
     
         t_rend = new TextRenderer(text_shader);
@@ -288,11 +391,14 @@ public:
         }
 
         fm.initializeFruits();
+        FruitManager::seedRandom(fruit_seed);
         nextFruit = fm.getRandomFruit();
 
         state.Init(window);
+        load_font.end();
 
         // Load audio files with error handling
+        prof::Zone load_audio("load audio");
         mergeSound = Mix_LoadWAV(FileSystem::getPath("resources/audio/drop.wav").c_str());
         if (!mergeSound) {
             std::cerr << "Warning: Could not load drop.wav: " << Mix_GetError() << std::endl;
@@ -313,6 +419,9 @@ public:
             std::cerr << "Mix_LoadMUS error: " << Mix_GetError() << std::endl;
         }
 
+        load_audio.end();
+
+        prof::Zone load_textures("load textures");
         std::vector<std::string> faces
         {
             FileSystem::getPath("resources/textures/sky/right.jpg"),  // right
@@ -341,11 +450,21 @@ public:
             bowlTexture = 0;
         }
 
+        // Fruits and gold props drawn instanced pick their texture by layer
+        std::vector<std::string> layers;
+        for (int f = 0; f < FRUIT_COUNT; ++f) layers.push_back(FruitManager::texturePath(static_cast<Fruit>(f)));
+        layers.push_back(FileSystem::getPath("resources/textures/gold/albedo.png"));
+        fruitTextureArray = loadTextureArray(layers, FRUIT_TEXTURE_SIZE);
+
+        load_textures.end();
+
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, defaultTexture);
 
         ball_shader->use();
         ball_shader->setInt("texture_diffuse1", 0);
+        instanced_shader->use();
+        instanced_shader->setInt("fruit_textures", 0);
 
         // glActiveTexture(GL_TEXTURE1);
         // glBindTexture(GL_TEXTURE_2D, metallicTex);
@@ -374,10 +493,25 @@ public:
         if (themeMusic) {
             Mix_PlayMusic(themeMusic, -1);
         }
+
+        pacer.Init(window, PacingConfig::fromEnvironment());
+        overlay.Init();
+        idle.Init();
+        if (!record_path.empty()) StartRecording();
+        else LoadGame(); // a recording starts from an empty bowl
+        if (!spectate_endpoint.empty()) StartSpectating();
+        if (!physics_log_path.empty()) StartPhysicsLog();
+        if (physics_lod > 1) EnablePhysicsLod();
+        if (!props_path.empty()) LoadProps();
+        if (gpu_physics) EnableGpuPhysics();
+        // with a GPU backend the solver has to step in this thread's context, from FixedUpdate
+        if (!physics_solver->backend) simulation->start();
         std::cout<<"INIT DONE"<<std::endl;
     }
     // game loop
     void ProcessInput(float dt){
+        PROFILE_SCOPE("Game::ProcessInput");
+        PerfOverlay::Scope perf_scope(overlay, PERF_INPUT);
         if (State == GAME_ACTIVE)
         {
             // Handle input for camera movement using continuous key check
@@ -419,6 +553,7 @@ public:
         // Toggle menu with Escape key
         if (Keys[GLFW_KEY_ESCAPE] && !KeysProcessed[GLFW_KEY_ESCAPE]){
             if (State == GAME_ACTIVE || State == GAME_OVER) {
+                if (State == GAME_ACTIVE) SaveGame();
                 State = GAME_MENU;
             } 
             else {
@@ -426,6 +561,297 @@ public:
             }
             KeysProcessed[GLFW_KEY_ESCAPE] = true;
         }
+
+        // Rewind the bowl a few seconds, also out of a lost game
+        if (Keys[GLFW_KEY_BACKSPACE] && !KeysProcessed[GLFW_KEY_BACKSPACE]){
+            KeysProcessed[GLFW_KEY_BACKSPACE] = true;
+            if ((State == GAME_ACTIVE || State == GAME_OVER) && simulation->rewind(REWIND_STEP_SECONDS)) {
+                State = GAME_ACTIVE;
+                game_lost = false; // the restored bowl is saved as a live game again
+            }
+        }
+
+        // Performance overlay
+        if (Keys[GLFW_KEY_F3] && !KeysProcessed[GLFW_KEY_F3]){
+            KeysProcessed[GLFW_KEY_F3] = true;
+            overlay.Toggle();
+            simulation->measureHealth(overlay.visible);
+        }
+
+        // Trace capture: first press starts, second press writes the file
+        if (Keys[GLFW_KEY_F4] && !KeysProcessed[GLFW_KEY_F4]){
+            KeysProcessed[GLFW_KEY_F4] = true;
+            ToggleTrace();
+        }
+
+        // Let the bot play
+        if (Keys[GLFW_KEY_F6] && !KeysProcessed[GLFW_KEY_F6]){
+            KeysProcessed[GLFW_KEY_F6] = true;
+            ToggleAutoPlayer();
+        }
+    }
+
+    void StartTrace(const std::string& path){
+        trace_path = path;
+        prof::startCapture();
+        std::cout << "trace capture started" << std::endl;
+    }
+    void StopTrace(){
+        if (!prof::enabled()) return;
+        prof::stopCapture();
+        const std::string path = trace_path.empty() ? "suika_trace_" + std::to_string(trace_count++) + ".json" : trace_path;
+        if (prof::writeChromeTrace(path)) {
+            std::cout << "wrote " << prof::eventCount() << " trace events to " << path << std::endl;
+        } else {
+            std::cerr << "could not write trace to " << path << std::endl;
+        }
+        trace_path.clear();
+    }
+    void StartRecording(){
+        // Only serial stepping is bit-reproducible, and playback defaults to it: rebuild the
+        // solver on a serial executor so the recording replays to its checksum. Init calls
+        // this before the simulation thread starts or anything else configures the solver.
+        if (std::string(thread_pool->name()) != "serial") {
+            const float timestep = simulation->timestep();
+            delete simulation;
+            delete physics_solver;
+            record_executor = std::make_unique<tp::SerialExecutor>();
+            physics_solver = new PhysicSolver(*record_executor, &boundary);
+            simulation = new SimulationThread(*physics_solver, timestep);
+            std::cout << "recording steps physics on the serial executor" << std::endl;
+        }
+        ReplayHeader header;
+        header.timestep = simulation->timestep();
+        header.sub_steps = physics_solver->sub_steps;
+        header.seed = fruit_seed;
+        header.bowl_radius = boundary.radius;
+        header.bowl_angle = glm::degrees(boundary.cutoffAngle);
+        header.bowl_margin = boundary.margin;
+        recorder = std::make_unique<ReplayRecorder>(header);
+        simulation->startRecording(recorder.get());
+        std::cout << "recording replay to " << record_path << " (seed " << fruit_seed << ")" << std::endl;
+    }
+    void StopRecording(){
+        if (!recorder) return;
+        simulation->stopRecording();
+        if (recorder->save(record_path)) {
+            std::cout << "wrote replay " << record_path << " (" << recorder->bytes() << " bytes of events)" << std::endl;
+        } else {
+            std::cerr << "could not write replay to " << record_path << std::endl;
+        }
+        recorder.reset();
+    }
+    // Writes the bowl, score, fruit sequence and camera. A lost game is saved as an
+    // empty bowl, so only the high score carries over. A recorded session started from
+    // an empty bowl instead of the save, so it leaves the save alone.
+    bool SaveGame(){
+        if (save_path.empty()) return false;
+        if (recorder) {
+            std::cout << "not saving to " << save_path << " while recording a replay" << std::endl;
+            return false;
+        }
+        PROFILE_SCOPE("Game::SaveGame");
+        const auto start = std::chrono::steady_clock::now();
+        SaveHeader header = makeSaveHeader();
+        simulation->latestState(save_state);
+        header.total_points = save_state.total_points;
+        if (game_lost) {
+            save_state.has_obj.fill(false);
+            header.total_points = 0;
+        }
+        packSaveObjects(save_state, save_objects);
+        const Pcg32 rng = FruitManager::randomState();
+        header.rng_state = rng.state;
+        header.rng_inc = rng.inc;
+        header.high_score = std::max(high_score, header.total_points);
+        header.next_fruit = static_cast<uint32_t>(nextFruit);
+        header.timestep = simulation->timestep();
+        header.sub_steps = physics_solver->sub_steps;
+        header.view = SaveView{state.w, state.yaw, state.pitch, state.radius};
+        std::string error;
+        if (!writeSaveFile(save_path, header, save_objects.data(), static_cast<uint32_t>(save_objects.size()), error)) {
+            std::cerr << "could not save the game: " << error << std::endl;
+            return false;
+        }
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "saved " << save_objects.size() << " fruits to " << save_path << " in " << ms << " ms" << std::endl;
+        return true;
+    }
+    // Resumes from the save file if there is one; the game stays in the menu
+    bool LoadGame(){
+        if (save_path.empty()) return false;
+        PROFILE_SCOPE("Game::LoadGame");
+        const auto start = std::chrono::steady_clock::now();
+        SaveFile file;
+        std::string error;
+        if (!file.open(save_path, error)) {
+            if (error.rfind("cannot open", 0) != 0) std::cerr << "ignoring save " << save_path << ": " << error << std::endl;
+            return false;
+        }
+        const SaveHeader& header = file.header();
+        if (header.next_fruit >= FRUIT_COUNT) {
+            std::cerr << "ignoring save " << save_path << ": unknown fruit" << std::endl;
+            return false;
+        }
+        // the bowl only continues the same way under the physics it was saved with
+        if (header.timestep != simulation->timestep() || header.sub_steps != physics_solver->sub_steps) {
+            std::cerr << "ignoring save " << save_path << ": saved at a " << header.timestep * 1000.0f << " ms tick with "
+                      << header.sub_steps << " substeps, the game runs a " << simulation->timestep() * 1000.0f
+                      << " ms tick with " << physics_solver->sub_steps << std::endl;
+            return false;
+        }
+        unpackSaveObjects(file.objects(), file.objectCount(), save_state);
+        save_state.total_points = header.total_points;
+        simulation->withSolver([this](PhysicSolver& solver) { solver.loadState(save_state); });
+        total_points = header.total_points;
+        high_score = std::max(high_score, static_cast<int>(header.high_score));
+        nextFruit = static_cast<Fruit>(header.next_fruit);
+        Pcg32 rng;
+        rng.state = header.rng_state;
+        rng.inc = header.rng_inc;
+        FruitManager::setRandomState(rng);
+        state.w = glm::clamp(header.view.w, state.w_min, state.w_max);
+        state.yaw = state.lastYaw = header.view.yaw;
+        state.pitch = state.lastPitch = glm::clamp(header.view.pitch, state.pitchMin, state.pitchMax);
+        state.radius = header.view.radius;
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "resumed " << file.objectCount() << " fruits, " << total_points << " points from " << save_path
+                  << " in " << ms << " ms" << std::endl;
+        return true;
+    }
+    void StartSpectating(){
+        auto publisher = std::make_unique<SpectatorPublisher>(spectate_endpoint, simulation->timestep());
+        std::string error;
+        if (!publisher->start(error)) {
+            std::cerr << "could not start the spectator stream: " << error << std::endl;
+            return;
+        }
+        spectator = std::move(publisher);
+        simulation->startSpectating(spectator.get());
+        std::cout << "streaming to spectators on " << spectator->endpoint() << std::endl;
+    }
+    void StopSpectating(){
+        if (!spectator) return;
+        simulation->stopSpectating();
+        spectator.reset();
+    }
+    void LoadProps(){
+        if (recorder) {
+            std::cout << "static props are off while recording" << std::endl;
+            return;
+        }
+        std::string error;
+        if (!props.load(props_path, error)) {
+            std::cerr << "could not load props: " << error << std::endl;
+            props.clear();
+            return;
+        }
+        simulation->withSolver([this](PhysicSolver& solver) { solver.boundary.push_back(&props); });
+        std::cout << "loaded " << props.size() << " static props from " << props_path << std::endl;
+    }
+    void EnablePhysicsLod(){
+        if (recorder) {
+            std::cout << "physics level of detail is off while recording" << std::endl;
+            return;
+        }
+        // near: within reach of the side slices RenderTripleBowl draws at w +/- R/4
+        physics_solver->lod.near_distance = boundary.radius * 0.25f + 0.25f;
+        physics_solver->lod.interval = physics_lod;
+        physics_solver->lod.enabled = true;
+        simulation->setLodFocus(state.w);
+        std::cout << "physics level of detail: far fruits step every " << physics_lod << " ticks" << std::endl;
+    }
+    void EnableGpuPhysics(){
+#ifdef __EMSCRIPTEN__
+        std::cout << "gpu physics is not available in web builds" << std::endl;
+#else
+        std::string reason;
+        if (recorder) {
+            std::cout << "gpu physics is off while recording" << std::endl;
+            return;
+        }
+        if (!gpu.supports(*physics_solver, &reason) || !gpu.init(reason)) {
+            std::cout << "gpu physics unavailable, " << reason << std::endl;
+            return;
+        }
+        simulation->withSolver([this](PhysicSolver& solver) { solver.backend = &gpu; });
+        std::cout << "gpu physics on " << glGetString(GL_RENDERER) << std::endl;
+#endif
+    }
+    // Call while the context is still current
+    void ReleaseGpuPhysics(){
+#ifndef __EMSCRIPTEN__
+        if (!gpu.ready()) return;
+        simulation->withSolver([](PhysicSolver& solver) { solver.backend = nullptr; });
+        gpu.release();
+#endif
+    }
+    void StartPhysicsLog(){
+        if (!physics_log.open(physics_log_path)) {
+            std::cerr << "could not write the physics log " << physics_log_path << std::endl;
+            return;
+        }
+        simulation->startPhysicsLog(&physics_log);
+    }
+    void StopPhysicsLog(){
+        if (!physics_log.isOpen()) return;
+        simulation->stopPhysicsLog();
+        physics_log.close();
+    }
+    void ToggleTrace(){
+        if (prof::enabled()) StopTrace();
+        else StartTrace("");
+    }
+    void ToggleAutoPlayer(){
+        if (!bot) {
+            // The search runs beside the simulation thread on executor threads of its own:
+            // a dispatch waits for every queued task, so physics ticks on a shared pool would
+            // wait for the rollouts. At most two workers, half the physics pool, unpinned to
+            // leave the pinned cores to the physics; they park between searches.
+            tp::PoolConfig bot_config = tp::PoolConfig::fromEnvironment(SUIKA_DEFAULT_EXECUTOR);
+            bot_config.thread_count = std::clamp(physics_solver->thread_pool.threadCount() / 2, 1u, 2u);
+            bot_config.pin_threads = false;
+            bot_executor = tp::makeExecutor(bot_config.backend, tp::planPlacement(topology, bot_config));
+            bot = std::make_unique<AutoPlayer>(*bot_executor, boundary, simulation->timestep(), physics_solver->sub_steps);
+            if (props.built() && props.size()) bot->addObstacles(&props);
+        }
+        bot_active = !bot_active;
+        bot_timer = 0.0f;
+        ++bot_epoch;
+        std::cout << "autoplayer " << (bot_active ? "on" : "off") << std::endl;
+    }
+    // The search starts from the bowl as of the last tick, copied without waiting for the
+    // simulation. The rollouts run on a worker thread while the simulation and rendering
+    // go on, and the fruit drops on the first frame after they finish.
+    void UpdateAutoPlayer(float dt){
+        if (bot_search.valid()) {
+            if (bot_search.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+            const AutoPlayerMove move = bot_search.get();
+            if (bot_search_epoch == bot_epoch) PlayAutoPlayerMove(move);
+            return;
+        }
+        bot_timer += dt;
+        if (bot_timer < AUTOPLAY_DROP_SECONDS) return;
+        bot_timer = 0.0f;
+        simulation->latestState(bot_state);
+        const Fruit fruit = nextFruit;
+        const uint64_t seed = fruit_seed ^ simulation->current().tick;
+        bot_search_epoch = bot_epoch;
+#ifdef WEB_BUILD
+        PlayAutoPlayerMove(bot->choose(bot_state, fruit, seed));
+#else
+        bot_search = std::async(std::launch::async, [this, fruit, seed]() {
+            prof::setThreadName("autoplayer search");
+            return bot->choose(bot_state, fruit, seed);
+        });
+#endif
+    }
+
+    void PlayAutoPlayerMove(const AutoPlayerMove& move){
+        overlay.SampleAutoPlayer(bot->rolloutsPerSecond(), static_cast<float>(move.search_ms));
+        state.w = move.position.w; // the view follows the bot's slice
+        DropFruitAt(move.position);
+        ballPlaced = true;
     }
 
     void ApplyVolumeSettings()
@@ -444,8 +870,25 @@ public:
 
     void Update(float dt)
     {
+        PROFILE_SCOPE("Game::Update");
         Width = state.windowWidth;
         Height = state.windowHeight;
+        simulation->setActive(State == GAME_ACTIVE);
+        simulation->setLodFocus(state.w);
+        const RenderState& snapshot = simulation->acquire();
+        total_points = snapshot.total_points;
+        const float alpha = simulation->threaded() ? simulation->interpolationAlpha(simulationClock()) : physics_alpha;
+        interpolateRenderState(simulation->previous(), snapshot, alpha, frame_state);
+        overlay.SampleSimulation(snapshot);
+        if (spectator) overlay.SampleSpectator(*spectator);
+        if (overlay.PoolSampleDue(dt)) {
+            // read and restart the executor counters while no tick is dispatching; when a
+            // tick is in flight the sample is taken on a later frame
+            simulation->tryBetweenTicks([this]() {
+                overlay.SamplePool(physics_solver->thread_pool.stats());
+                physics_solver->thread_pool.resetStats();
+            });
+        }
         // Logic that should run every frame, regardless of state
         Sound(); // Manages ongoing sounds
 
@@ -457,6 +900,7 @@ public:
                     Mix_ResumeMusic();
                 }
                 UpdateGameActive(dt);
+                if (bot_active && State == GAME_ACTIVE) UpdateAutoPlayer(dt);
                 break;
             case GAME_OVER:
                 UpdateGameOver(dt);
@@ -482,10 +926,11 @@ public:
     void UpdateGameActive(float dt)
     {
         // Check for the game-over condition
+        const RenderState& snapshot = simulation->current();
         for (int i = 0; i < MAX_OBJECTS; i++) {
-            if (!physics_solver->has_obj[i]) continue;
+            if (!snapshot.objects[i].active) continue;
 
-            if (physics_solver->objects[i].position.y < -3) {
+            if (snapshot.objects[i].position.y < -3) {
                 if (total_points > high_score) {
                     high_score = total_points;
                 }
@@ -495,6 +940,7 @@ public:
                 }
 
                 State = GAME_OVER;
+                game_lost = true;
                 return; // Exit immediately, game is over
             }
         }
@@ -527,18 +973,54 @@ public:
     }
 
     /**
-     * Handles physics updates at a fixed interval. This function is already correct.
+     * Handles physics updates at a fixed interval when there is no simulation thread.
      */
     void FixedUpdate(float dt)
     {
-        if (State != GAME_ACTIVE) return;
-        physics_solver->update(dt);
-        total_points = physics_solver->total_points;
+        if (State != GAME_ACTIVE || simulation->threaded()) return;
+        simulation->step();
+    }
+    // Gameplay always redraws; the game over camera animates slowly; the menu only changes on input
+    FrameDemand CurrentFrameDemand() const {
+        if (State == GAME_ACTIVE || overlay.visible || prof::enabled()) return FrameDemand::Continuous;
+        if (State == GAME_OVER) return FrameDemand::Animated;
+        return FrameDemand::Static;
+    }
+    // Minimised windows skip rendering and pause the simulation
+    void SetIconified(bool iconified){
+        idle.SetIconified(iconified);
+        simulation->setActive(State == GAME_ACTIVE && !iconified);
+    }
+    bool PhysicsThreaded() const {
+        return simulation->threaded();
+    }
+    float PhysicsTimestep() const {
+        return simulation->timestep();
+    }
+    // Governor limits for the main-thread fixed-update loop
+    float PhysicsTimeScale() const {
+        return simulation->current().time_scale;
+    }
+    uint32_t PhysicsCatchUpTicks() const {
+        return simulation->current().catch_up;
+    }
+    void DropPhysicsTicks(uint64_t ticks){
+        if (State == GAME_ACTIVE) simulation->dropTicks(ticks);
+    }
+    // Queues a fruit drop for the next physics tick
+    void DropFruit(glm::vec3 point){
+        DropFruitAt(glm::vec4(point, state.w) + glm::vec4(0, 3.0f, 0, 0));
+    }
+    void DropFruitAt(glm::vec4 position){
+        simulation->drop(PhysicsObject(position, nextFruit, true, false));
+        nextFruit = FruitManager::getRandomFruit();
     }
     int Sound(){
-        if (physics_solver->just_merged > 0 && mergeSound != nullptr) {
+        const uint64_t merges = simulation->current().merges;
+        if (merges > merges_heard && mergeSound != nullptr) {
             Mix_PlayChannel(-1, mergeSound, 0);
         }
+        merges_heard = merges;
         if (ballPlaced && placeSound != nullptr) {
             Mix_PlayChannel(-1, placeSound, 0);
         }
@@ -567,20 +1049,23 @@ public:
     void SetupBallShader(const glm::mat4& projection, const glm::mat4& view,
                     const glm::vec3& camPos, const glm::vec3& lightPos,
                     const glm::vec3& lightColor) {
-        ball_shader->use();
-        ball_shader->setMat4("view", view);
-        ball_shader->setMat4("projection", projection);
-        ball_shader->setVec3("camPos", camPos);
-        ball_shader->setVec3("lightPositions[0]", lightPos);
-        ball_shader->setVec3("lightColors[0]", lightColor);
-        ball_shader->setFloat("metallic", 0.0f);
-        ball_shader->setFloat("roughness", 0.5f);
-        ball_shader->setFloat("ao", 1.0f);
-        ball_shader->setFloat("alpha", 1.0f);
-
         glActiveTexture(GL_TEXTURE10);
         glBindTexture(GL_TEXTURE_CUBE_MAP, backgroundTexture);
-        ball_shader->setInt("environmentMap", 10);
+
+        // the instanced fruits share every uniform with the bowl
+        for (Shader* shader : {instanced_shader, ball_shader}) {
+            shader->use();
+            shader->setMat4("view", view);
+            shader->setMat4("projection", projection);
+            shader->setVec3("camPos", camPos);
+            shader->setVec3("lightPositions[0]", lightPos);
+            shader->setVec3("lightColors[0]", lightColor);
+            shader->setFloat("metallic", 0.0f);
+            shader->setFloat("roughness", 0.5f);
+            shader->setFloat("ao", 1.0f);
+            shader->setFloat("alpha", 1.0f);
+            shader->setInt("environmentMap", 10);
+        }
     }
 
     /**
@@ -588,6 +1073,8 @@ public:
      */
     void RenderSkybox(const glm::mat4& projection, const glm::mat4& view)
     {
+        PROFILE_SCOPE("Game::RenderSkybox");
+        PerfOverlay::Scope perf_scope(overlay, PERF_SKYBOX);
         glDepthFunc(GL_LEQUAL); // Render behind everything else
         glDepthMask(GL_FALSE);  // Don't write to the depth buffer
 
@@ -604,38 +1091,53 @@ public:
         glDepthFunc(GL_LESS);   // Restore default depth function
     }
     
-    void RenderSlice(float w, float alpha, glm::vec3 spatial_offset) {
-        // 1. Render the bowl for this slice (Background)
-        h_rend->Draw4d(w, bowlTexture, glm::vec4(0.0f), boundary.radius, glm::vec3(0.0f), alpha, spatial_offset);
-        
-        // 2. Render all fruits in this 4D slice (Foreground)
+    // Instances of one slice, as a range of i_rend's buffer
+    struct SliceInstances { uint32_t first, count; };
+
+    SliceInstances AddSliceInstances(float w, glm::vec3 spatial_offset) {
+        const uint32_t first = i_rend->size();
+
+        // Static props in this slice: obstacle fruits with their fruit's texture, others gold like the bowl
+        for (const StaticCollider& prop : props.colliders())
+            i_rend->add(w, prop.center, prop.radius, prop.fruit >= 0 ? prop.fruit : BOWL_LAYER, spatial_offset);
+
+        // All fruits in this 4D slice
         for (int i = 0; i < MAX_OBJECTS; i++) {
-            if (!physics_solver->has_obj[i] || physics_solver->objects[i].hidden) continue;
-            PhysicsObject &obj = physics_solver->objects[i];
-            
+            const RenderObject &obj = frame_state.objects[i];
+            if (!obj.active) continue;
+
             // 4D Visibility Check: Only render if the sphere intersects this 4D slice
             if (abs(obj.position.w - w) > obj.radius) continue;
-            
-            b_rend->Draw4d(w, obj.fruit, obj.position, glm::vec3(0.0f), alpha, spatial_offset);
+
+            i_rend->add(w, obj.position, obj.radius, obj.fruit, spatial_offset);
         }
+        return {first, i_rend->size() - first};
+    }
+
+    void RenderSlice(float w, float alpha, glm::vec3 spatial_offset, SliceInstances instances) {
+        PROFILE_SCOPE("Game::RenderSlice");
+        // 1. Render the bowl for this slice (Background)
+        ball_shader->use();
+        h_rend->Draw4d(w, bowlTexture, glm::vec4(0.0f), boundary.radius, glm::vec3(0.0f), alpha, spatial_offset);
+
+        // 2. Render its props and fruits in one draw (Foreground)
+        instanced_shader->use();
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, fruitTextureArray);
+        i_rend->draw(instances.first, instances.count, alpha);
     }
 
     void RenderTripleBowl(const glm::mat4& projection, const glm::mat4& view, 
                          const glm::vec3& camPos, const glm::vec3& light_pos, 
                          const glm::vec3& light_color) {
+        PROFILE_SCOPE("Game::RenderTripleBowl");
+        PerfOverlay::Scope perf_scope(overlay, PERF_BOWL);
         SetupBallShader(projection, view, camPos, light_pos, light_color);
         
         const glm::vec3 cameraRight = state.getRightVector();
         const float sideAlpha = 0.66f;
         const float wOffset = boundary.radius * 0.25f;
 
-        // 1. Render Main slice (Opaque) first so it's in the depth buffer
-        RenderSlice(state.w, 1.0f, glm::vec3(0.0f));
-
-        // 2. Render Side panels (Transparent) second with depth-write off
-        glEnable(GL_BLEND);
-        glDepthMask(GL_FALSE); 
-        
         // Dynamic offsets: Use the diameter of the *specific slice* at w +/- wOffset
         // rendering_radius = sqrt(R^2 - w^2)
 
@@ -651,14 +1153,31 @@ public:
         float rRightSq = boundary.radius * boundary.radius - wRight * wRight;
         float rRight = (rRightSq > 0.0f) ? sqrt(rRightSq) : 0.0f;
         glm::vec3 offsetRight = cameraRight * (rRight + r); // Spaced by its own diameter
-        
-        RenderSlice(wLeft, sideAlpha, -offsetLeft);
-        RenderSlice(wRight, sideAlpha, offsetRight);
+
+        // Every slice's instances go to the GPU in one upload per frame
+        i_rend->clear();
+        const SliceInstances center = AddSliceInstances(state.w, glm::vec3(0.0f));
+        const SliceInstances left = AddSliceInstances(wLeft, -offsetLeft);
+        const SliceInstances right = AddSliceInstances(wRight, offsetRight);
+        i_rend->upload();
+
+        // 1. Render Main slice (Opaque) first so it's in the depth buffer
+        RenderSlice(state.w, 1.0f, glm::vec3(0.0f), center);
+
+        // 2. Render Side panels (Transparent) second with depth-write off
+        glEnable(GL_BLEND);
+        glDepthMask(GL_FALSE); 
+
+        RenderSlice(wLeft, sideAlpha, -offsetLeft, left);
+        RenderSlice(wRight, sideAlpha, offsetRight, right);
         
         glDepthMask(GL_TRUE);
+        ball_shader->use(); // the preview fruit is drawn next with the plain ball shader
     }
 
     void RenderTable() {
+        PROFILE_SCOPE("Game::RenderTable");
+        PerfOverlay::Scope perf_scope(overlay, PERF_TABLE);
         // model_shader should already be active when this is called
         model_shader->use(); 
         model_shader->setFloat("alpha", 1.0f); // Ensure opaque rendering for the environment
@@ -670,6 +1189,7 @@ public:
     }
 
     void RenderSceneCore() {
+        PROFILE_SCOPE("Game::RenderSceneCore");
         glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)Width / (float)Height, 0.1f, 100.0f);
         glm::mat4 view = state.getViewMatrix();
         glm::vec3 camPos = state.getCameraPosition();
@@ -688,7 +1208,8 @@ public:
         RenderTripleBowl(projection, view, camPos, light_position, light_color);
     } 
     void RenderPreviewObject() {
-        RayInter mousePos = getPlacementMouse(&state, &boundary, physics_solver);
+        PROFILE_SCOPE("Game::RenderPreviewObject");
+        RayInter mousePos = getPlacementMouse(&state, &boundary, frame_state);
         if (mousePos.hit) {
             // ball_shader should already be active when this is called
             ball_shader->setFloat("alpha", 0.5f);
@@ -701,13 +1222,16 @@ public:
      */
     void RenderGameUI()
     {
+        PROFILE_SCOPE("Game::RenderGameUI");
+        PerfOverlay::Scope perf_scope(overlay, PERF_UI);
         glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(state.windowWidth), static_cast<float>(state.windowHeight), 0.0f);
         text_shader->use();
         text_shader->setMat4("projection", projection);
-        t_rend->RenderText("Score " + std::to_string((int)physics_solver->total_points), 25.0f, 25.0f, 1.0f, glm::vec3(1.0f));
+        t_rend->RenderText("Score " + std::to_string(total_points), 25.0f, 25.0f, 1.0f, glm::vec3(1.0f));
     }
 
     void Render() {
+        PROFILE_SCOPE("Game::Render");
         // Clear the screen and set initial OpenGL state for all frames
         glEnable(GL_DEPTH_TEST);
         glEnable(GL_BLEND);
@@ -727,6 +1251,8 @@ public:
                 RenderEndScreen();
                 break;
         }
+        overlay.Draw(t_rend, state.windowWidth, state.windowHeight, pacer);
+        overlay.EndFrame();
     }
 
     void RenderGame() {
@@ -752,39 +1278,59 @@ public:
         t_rend->RenderText(slider.label,  slider.rect.x, slider.rect.y - 25.0f, scale, color);
         t_rend->RenderTextScale(bar,  slider.rect.x, slider.rect.y,slider.rect.z,slider.rect.w, color);
     }
-    void RenderMenu() {
-        // 1. Setup 3D view for the background skybox
-        glm::mat4 projection3D = glm::perspective(glm::radians(45.0f), (float)Width / (float)Height, 0.1f, 100.0f);
-        glm::mat4 view = state.getViewMatrix();
-        RenderSkybox(projection3D, view);
+    // Menu text with its layout, rebuilt only when the window size changes
+    struct MenuText {
+        std::string text;
+        float x, y, scale;
+        glm::vec3 color;
+    };
+    std::vector<MenuText> menu_text;
+    unsigned int menu_layout_width = 0, menu_layout_height = 0;
+
+    void LayoutMenu() {
+        if (menu_layout_width == Width && menu_layout_height == Height && !menu_text.empty()) return;
+        menu_layout_width = Width;
+        menu_layout_height = Height;
+        menu_text.clear();
 
-        // 2. Setup 2D projection for all text and UI rendering
-        glm::mat4 projection2D = glm::ortho(0.0f, static_cast<float>(Width), static_cast<float>(Height), 0.0f);
-        t_rend->shader->use();
-        t_rend->shader->setMat4("projection", projection2D);
-
-        // --- Render All Menu Text ---
         float centerX = Width / 2.0f;
         float centerY = Height / 2.0f;
-        
+
         // Title and Subtitle
         std::string title = "Suika 4D";
-        t_rend->RenderText(title, centerX - t_rend->GetTextWidth(title, 2.0f) / 2.0f, centerY - 150.0f, 2.0f, glm::vec3(0.9f, 0.9f, 1.0f));
+        menu_text.push_back({title, centerX - t_rend->GetTextWidth(title, 2.0f) / 2.0f, centerY - 150.0f, 2.0f, glm::vec3(0.9f, 0.9f, 1.0f)});
         std::string subtitle = "Press ESC or ENTER to Play";
-        t_rend->RenderText(subtitle, centerX - t_rend->GetTextWidth(subtitle, 1.0f) / 2.0f, centerY - 50.0f, 1.0f, glm::vec3(0.8f, 0.8f, 0.8f));
+        menu_text.push_back({subtitle, centerX - t_rend->GetTextWidth(subtitle, 1.0f) / 2.0f, centerY - 50.0f, 1.0f, glm::vec3(0.8f, 0.8f, 0.8f)});
 
         // Instructions Block
         float instructionScale = 0.75f;
         glm::vec3 instructionColor = glm::vec3(0.7f);
 
-
         float startY = Height*0.6f;
-        // float startY = centerY + 50.0f;
         float lineSpacing = 20.0f;
-        
-        vector<std::string> lines = {"W / S - Move in the 4th Dimension","Left Click - Place Fruit","Right-Click + Drag - Rotate Camera","Mouse Wheel - Zoom In/Out","ESC - Pause / Return to Menu"};
+
+        vector<std::string> lines = {"W / S - Move in the 4th Dimension","Left Click - Place Fruit","Right-Click + Drag - Rotate Camera","Mouse Wheel - Zoom In/Out","ESC - Pause / Return to Menu","Backspace - Rewind 3 Seconds","F3 - Performance Overlay","F6 - Autoplay"};
         for (int i =0;i<lines.size();i++){
-            t_rend->RenderText(lines[i], centerX - t_rend->GetTextWidth(lines[i], instructionScale) / 2.0f, startY + lineSpacing*i, instructionScale, instructionColor);
+            menu_text.push_back({lines[i], centerX - t_rend->GetTextWidth(lines[i], instructionScale) / 2.0f, startY + lineSpacing*i, instructionScale, instructionColor});
+        }
+    }
+
+    void RenderMenu() {
+        PROFILE_SCOPE("Game::RenderMenu");
+        // 1. Setup 3D view for the background skybox
+        glm::mat4 projection3D = glm::perspective(glm::radians(45.0f), (float)Width / (float)Height, 0.1f, 100.0f);
+        glm::mat4 view = state.getViewMatrix();
+        RenderSkybox(projection3D, view);
+
+        // 2. Setup 2D projection for all text and UI rendering
+        glm::mat4 projection2D = glm::ortho(0.0f, static_cast<float>(Width), static_cast<float>(Height), 0.0f);
+        t_rend->shader->use();
+        t_rend->shader->setMat4("projection", projection2D);
+
+        // --- Render All Menu Text ---
+        LayoutMenu();
+        for (const MenuText& line : menu_text) {
+            t_rend->RenderText(line.text, line.x, line.y, line.scale, line.color);
         }
 
         // float sliderYOffset = startY;// + (lineSpacing * 5) + 40.0f; // Position sliders below instructions
@@ -794,6 +1340,7 @@ public:
         RenderSlider(vset.sfxSlider);
     }
     void RenderEndScreen() {
+        PROFILE_SCOPE("Game::RenderEndScreen");
         RenderSceneCore();
 
         // Game Over Text overlay
@@ -10,6 +10,15 @@ const float VELOCITY_DAMPING = 100.0f;
 const float RESPONSE_COEF = 0.1f;
 const float GROW_SPEED = 5.0f;
 const float EPS           = 0.0001f;
+const float PHYSICS_TIMESTEP = 1.0f / 60.0f; // fixed physics tick
+
+// Solver tuning, per solver so that the sweep tool can try other values; the
+// defaults are the constants above
+struct PhysicsParams{
+    float velocity_damping = VELOCITY_DAMPING;
+    float response_coef    = RESPONSE_COEF;
+    float grow_speed       = GROW_SPEED;
+};
 
 // Result structure for ray intersection
 struct RayInter{
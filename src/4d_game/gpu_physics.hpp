@@ -0,0 +1,398 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "learnopengl/shader_c.h"
+#include "filesystem.h"
+
+#include "executor.hpp"
+#include "hemisphere_boundary.hpp"
+#include "physics_solver.hpp"
+#include "physics_stats.hpp"
+#include "profiler.hpp"
+
+// One solver slot as the compute kernels see it (std430)
+struct GpuFruit
+{
+    glm::vec4 position;
+    glm::vec4 last_position;
+    glm::vec4 correction;    // contact push of the current substep
+    float     radius;
+    float     target_radius;
+    int32_t   fruit;
+    uint32_t  flags;
+    float     boundary_push; // summed over the update, for measurePhysics()
+    uint32_t  cell;          // broadphase cell of the current substep
+    float     pad[2];
+
+    static constexpr uint32_t PRESENT = 1u; // has_obj
+    static constexpr uint32_t HIDDEN  = 2u;
+    static constexpr uint32_t DYNAMIC = 4u;
+    static constexpr uint32_t GROWING = 8u;
+};
+static_assert(sizeof(GpuFruit) == 80, "GpuFruit must match the std430 layout of the physics shaders");
+
+// PhysicSolver updates as GL 4.3 compute passes. Every substep rebuilds a uniform 4D grid
+// (count, prefix sum, scatter), merges the pairs of same fruits that pick each other,
+// resolves contacts as a Jacobi pass and integrates against the hemisphere bowl; the
+// fruits stay in shader storage buffers between passes. The slots are uploaded before
+// and read back after every update: gameplay code (score, drops, saves, rewind) and the
+// published render snapshots all work on solver.objects, and the GL 3.3 renderer has no
+// storage buffers to read them from.
+//
+// Contacts are summed rather than applied one pair after the other, and merges wait for
+// a pass where both fruits agree, so results are close to the CPU solver's but not bit
+// identical: recordings stay on the CPU. Must be used on the thread whose context it
+// was created in. Other boundaries (props) and the level of detail fall back to the CPU.
+class GpuPhysics : public SolverBackend
+{
+public:
+    static constexpr uint32_t LOCAL_SIZE   = 64;
+    static constexpr uint32_t MAX_GRID_DIM = 16; // cells per axis
+    static constexpr int      MAX_FRUITS   = 16; // size of the fruit tables in physics_merge.cs
+    static_assert(FRUIT_COUNT <= MAX_FRUITS, "grow the fruit tables of physics_merge.cs");
+
+    // The context current on this thread runs compute shaders
+    static bool available() { return GLAD_GL_VERSION_4_3 != 0; }
+
+    ~GpuPhysics() override = default; // GL objects go with release(), while the context is current
+
+    bool init(std::string& error)
+    {
+        if (!available()) {
+            error = "compute shaders need OpenGL 4.3, the context is " + std::string(reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+            return false;
+        }
+        const char* names[PASS_COUNT] = {"physics_grid_count", "physics_grid_scan", "physics_grid_scatter",
+                                         "physics_merge_pairs", "physics_merge", "physics_contact", "physics_integrate"};
+        for (int p = 0; p < PASS_COUNT; ++p) {
+            m_passes[p] = std::make_unique<ComputeShader>(FileSystem::getPath("resources/shaders/" + std::string(names[p]) + ".cs").c_str());
+            GLint linked = GL_FALSE;
+            glGetProgramiv(m_passes[p]->ID, GL_LINK_STATUS, &linked);
+            if (!linked) {
+                error = std::string("could not build ") + names[p] + ".cs";
+                release();
+                return false;
+            }
+        }
+
+        float radius[MAX_FRUITS] = {};
+        int points[MAX_FRUITS] = {};
+        for (int f = 0; f < FRUIT_COUNT; ++f) {
+            radius[f] = fruitPhysics(static_cast<Fruit>(f)).radius;
+            points[f] = fruitPhysics(static_cast<Fruit>(f)).merge_points;
+        }
+        ComputeShader& merge = *m_passes[MERGE];
+        merge.use();
+        merge.setInt("last_fruit", WATERMELON);
+        glUniform1fv(glGetUniformLocation(merge.ID, "fruit_radius"), MAX_FRUITS, radius);
+        glUniform1iv(glGetUniformLocation(merge.ID, "merge_points"), MAX_FRUITS, points);
+
+        glGenBuffers(BUFFER_COUNT, m_buffers);
+        allocate(FRUITS, sizeof(GpuFruit) * MAX_OBJECTS);
+        allocate(ITEMS, sizeof(uint32_t) * MAX_OBJECTS);
+        allocate(COUNTERS, sizeof(Counters));
+        allocate(PARTNER, sizeof(uint32_t) * MAX_OBJECTS);
+        m_cell_capacity = 0;
+        reserveCells(1);
+        m_ready = true;
+        return true;
+    }
+
+    void release()
+    {
+        if (m_buffers[0]) glDeleteBuffers(BUFFER_COUNT, m_buffers);
+        for (int b = 0; b < BUFFER_COUNT; ++b) m_buffers[b] = 0;
+        for (auto& pass : m_passes) {
+            if (pass) glDeleteProgram(pass->ID);
+            pass.reset();
+        }
+        m_ready = false;
+    }
+
+    bool ready() const { return m_ready; }
+
+    // Whether the kernels cover everything the solver would do this tick
+    bool supports(const PhysicSolver& solver, std::string* reason = nullptr) const
+    {
+        if (solver.lod.enabled || solver.lod_far_count) {
+            if (reason) *reason = "the physics level of detail runs on the CPU";
+            return false;
+        }
+        if (solver.boundary.size() != 1 || !dynamic_cast<const HemisphereBoundary*>(solver.boundary[0])) {
+            if (reason) *reason = "only the hemisphere bowl runs on the GPU (static props do not)";
+            return false;
+        }
+        return true;
+    }
+
+    bool update(PhysicSolver& solver, float dt) override
+    {
+        if (!m_ready || !supports(solver)) return false;
+        PROFILE_SCOPE("GpuPhysics::update");
+        const HemisphereBoundary& bowl = *static_cast<const HemisphereBoundary*>(solver.boundary[0]);
+        const uint32_t steps = std::max(1u, solver.sub_steps);
+        const float sub_dt = dt / static_cast<float>(steps);
+
+        upload(solver);
+        configure(solver, bowl, sub_dt);
+        for (int b = 0; b < BUFFER_COUNT; ++b) glBindBufferBase(GL_SHADER_STORAGE_BUFFER, b, m_buffers[b]);
+        const GLuint object_groups = (MAX_OBJECTS + LOCAL_SIZE - 1) / LOCAL_SIZE;
+        for (uint32_t s = 0; s < steps; ++s) {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffers[COUNTS]);
+            glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+            dispatch(GRID_COUNT, object_groups);
+            dispatch(GRID_SCAN, 1);
+            dispatch(GRID_SCATTER, object_groups);
+            dispatch(MERGE_PAIRS, object_groups);
+            dispatch(MERGE, object_groups);
+            dispatch(CONTACT, object_groups);
+            dispatch(INTEGRATE, object_groups);
+        }
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        readback(solver);
+
+        solver.advanced.fill(dt);
+        solver.step_dt.fill(sub_dt);
+        return true;
+    }
+
+private:
+    enum Pass { GRID_COUNT, GRID_SCAN, GRID_SCATTER, MERGE_PAIRS, MERGE, CONTACT, INTEGRATE, PASS_COUNT };
+    // also the shader storage binding points
+    enum Buffer { FRUITS, COUNTS, STARTS, ITEMS, COUNTERS, PARTNER, BUFFER_COUNT };
+
+    struct Counters
+    {
+        int32_t  points;
+        int32_t  merges;
+        uint32_t pairs_tested;
+    };
+
+    void allocate(Buffer b, size_t bytes)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffers[b]);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(bytes), nullptr, GL_DYNAMIC_DRAW);
+    }
+
+    void reserveCells(uint32_t cells)
+    {
+        if (cells <= m_cell_capacity) return;
+        m_cell_capacity = cells;
+        allocate(COUNTS, sizeof(uint32_t) * cells);
+        allocate(STARTS, sizeof(uint32_t) * (cells + 1));
+    }
+
+    void upload(const PhysicSolver& solver)
+    {
+        for (int i = 0; i < MAX_OBJECTS; ++i) {
+            const PhysicsObject& obj = solver.objects[i];
+            GpuFruit& dst = m_staging[i];
+            dst = GpuFruit{};
+            dst.position      = obj.position;
+            dst.last_position = obj.last_position;
+            dst.radius        = obj.radius;
+            dst.target_radius = obj.target_radius;
+            dst.fruit         = obj.fruit;
+            dst.flags = (solver.has_obj[i] ? GpuFruit::PRESENT : 0u) | (obj.hidden ? GpuFruit::HIDDEN : 0u) |
+                        (obj.dynamic ? GpuFruit::DYNAMIC : 0u) | (obj.growing ? GpuFruit::GROWING : 0u);
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffers[FRUITS]);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(m_staging), m_staging.data());
+        const Counters zero{0, 0, 0};
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffers[COUNTERS]);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zero), &zero);
+    }
+
+    void readback(PhysicSolver& solver)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffers[FRUITS]);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(m_staging), m_staging.data());
+        Counters counters{};
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffers[COUNTERS]);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(counters), &counters);
+
+        for (int i = 0; i < MAX_OBJECTS; ++i) {
+            const GpuFruit& src = m_staging[i];
+            PhysicsObject& obj = solver.objects[i];
+            if (!solver.has_obj[i]) continue; // free slots were never touched
+            if (!(src.flags & GpuFruit::PRESENT)) {
+                solver.removeObject(i);
+                continue;
+            }
+            obj.position      = src.position;
+            obj.last_position = src.last_position;
+            obj.radius        = src.radius;
+            obj.target_radius = src.target_radius;
+            obj.fruit         = static_cast<Fruit>(src.fruit);
+            obj.growing       = (src.flags & GpuFruit::GROWING) != 0;
+            solver.boundary_push[i] = src.boundary_push;
+        }
+        solver.total_points += counters.points;
+        solver.just_merged += counters.merges;
+        solver.contact_pairs_tested += counters.pairs_tested;
+    }
+
+    // Cells are as wide as two of the largest fruit this tick can grow into, so every
+    // overlapping pair sits in neighbouring cells. The grid spans the bowl; fruits above
+    // or outside it fall into the border cells.
+    void configure(const PhysicSolver& solver, const HemisphereBoundary& bowl, float sub_dt)
+    {
+        int largest = CHERRY;
+        for (int i = 0; i < MAX_OBJECTS; ++i) {
+            if (solver.has_obj[i]) largest = std::max(largest, static_cast<int>(solver.objects[i].fruit));
+        }
+        const float cell = 2.0f * fruitPhysics(nextFruit(static_cast<Fruit>(largest))).radius;
+        const float half = bowl.radius + bowl.margin + cell * 0.5f;
+        const int dim = static_cast<int>(std::min<float>(MAX_GRID_DIM, std::max(1.0f, std::floor(2.0f * half / cell))));
+        m_cell_total = static_cast<uint32_t>(dim * dim * dim * dim);
+        reserveCells(m_cell_total);
+        const glm::vec4 origin = bowl.center - glm::vec4(half);
+        const float cell_size = 2.0f * half / static_cast<float>(dim);
+
+        for (int p = 0; p < PASS_COUNT; ++p) {
+            ComputeShader& pass = *m_passes[p];
+            pass.use();
+            pass.setInt("object_count", MAX_OBJECTS);
+            pass.setVec4("grid_origin", origin);
+            pass.setFloat("cell_size", cell_size);
+            glUniform4i(glGetUniformLocation(pass.ID, "grid_dims"), dim, dim, dim, dim);
+        }
+        m_passes[GRID_SCAN]->use();
+        m_passes[GRID_SCAN]->setInt("cell_total", static_cast<int>(m_cell_total));
+        m_passes[CONTACT]->use();
+        m_passes[CONTACT]->setFloat("response_coef", solver.params.response_coef);
+        ComputeShader& integrate = *m_passes[INTEGRATE];
+        integrate.use();
+        integrate.setFloat("dt", sub_dt);
+        integrate.setVec4("gravity", solver.gravity);
+        integrate.setFloat("velocity_damping", solver.params.velocity_damping);
+        integrate.setFloat("grow_speed", solver.params.grow_speed);
+        integrate.setVec4("bowl_center", bowl.center);
+        integrate.setFloat("bowl_radius", bowl.radius);
+        integrate.setFloat("bowl_margin", bowl.margin);
+        integrate.setFloat("bowl_cutoff", bowl.cutoffAngle);
+    }
+
+    void dispatch(Pass pass, GLuint groups)
+    {
+        m_passes[pass]->use();
+        glDispatchCompute(groups, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    std::unique_ptr<ComputeShader>       m_passes[PASS_COUNT];
+    GLuint                               m_buffers[BUFFER_COUNT] = {};
+    std::array<GpuFruit, MAX_OBJECTS>    m_staging;
+    uint32_t                             m_cell_capacity = 0;
+    uint32_t                             m_cell_total = 1;
+    bool                                 m_ready = false;
+};
+
+// --validate-gpu-physics <ticks>: drops a seeded fruit sequence into the bowl and runs the
+// GPU kernels against the CPU solver in the current context, which may be Mesa llvmpipe
+// (SUIKA_EGL=1 without a display). Two checks:
+//   lockstep:  every tick both start from the CPU state. On ticks without a merge,
+//              positions must agree within `tolerance`; merges may disagree on at most
+//              1% of the ticks. (A merge tick differs more: the CPU pushes the merged
+//              fruit against its neighbours in the same pass, the GPU one pass later.)
+//   free run:  both play the sequence on their own, which soon diverges; the GPU bowl's
+//              mean deepest overlap may exceed the CPU's by at most 10%.
+// Returns the process exit code.
+struct GpuValidationOptions
+{
+    uint32_t ticks = 3600;
+    uint64_t seed = 1;
+    float    tolerance = 0.01f;
+};
+
+inline int runGpuPhysicsValidation(const GpuValidationOptions& options)
+{
+    using clock = std::chrono::steady_clock;
+    std::cout << "gpu physics validation on " << glGetString(GL_RENDERER) << ", " << glGetString(GL_VERSION) << std::endl;
+    GpuPhysics gpu;
+    std::string error;
+    if (!gpu.init(error)) {
+        std::cerr << "gpu physics: " << error << std::endl;
+        return 1;
+    }
+
+    tp::SerialExecutor serial(false);
+    HemisphereBoundary bowl(glm::vec4(0.0f), 3, 90.0f, 0.1f);
+    PhysicSolver cpu(serial, &bowl), on_gpu(serial, &bowl), cpu_free(serial, &bowl), gpu_free(serial, &bowl);
+    on_gpu.backend = &gpu;
+    gpu_free.backend = &gpu;
+
+    Pcg32 rng(options.seed);
+    auto unit = [&rng]() { return static_cast<float>(rng.next()) * (2.0f / 4294967296.0f) - 1.0f; };
+    SolverState state;
+    float contact_error = 0.0f, merge_error = 0.0f;
+    uint32_t disagreements = 0;
+    uint64_t cpu_unstable = 0, gpu_unstable = 0;
+    double cpu_penetration = 0.0, gpu_penetration = 0.0;
+    double cpu_seconds = 0.0, gpu_seconds = 0.0;
+    for (uint32_t tick = 0; tick < options.ticks; ++tick) {
+        if (tick % 30 == 0) {
+            const PhysicsObject drop(glm::vec4(unit() * 1.5f, 3.0f, unit() * 1.5f, unit() * 1.5f), randomDropFruit(rng), true, false);
+            cpu.addObject(drop);
+            cpu_free.addObject(drop);
+            gpu_free.addObject(drop);
+        }
+
+        cpu.saveState(state);
+        on_gpu.loadState(state);
+        cpu.update(PHYSICS_TIMESTEP);
+        on_gpu.update(PHYSICS_TIMESTEP);
+        bool agree = cpu.total_points == on_gpu.total_points;
+        float error = 0.0f;
+        for (int i = 0; i < MAX_OBJECTS; ++i) {
+            if (cpu.has_obj[i] != on_gpu.has_obj[i] || (cpu.has_obj[i] && cpu.objects[i].fruit != on_gpu.objects[i].fruit)) {
+                agree = false;
+            } else if (cpu.has_obj[i]) {
+                error = std::max(error, glm::length(cpu.objects[i].position - on_gpu.objects[i].position));
+            }
+        }
+        disagreements += agree ? 0 : 1;
+        float& bucket = cpu.just_merged || on_gpu.just_merged ? merge_error : contact_error;
+        bucket = std::max(bucket, error);
+
+        auto start = clock::now();
+        cpu_free.update(PHYSICS_TIMESTEP);
+        cpu_seconds += std::chrono::duration<double>(clock::now() - start).count();
+        start = clock::now();
+        gpu_free.update(PHYSICS_TIMESTEP);
+        gpu_seconds += std::chrono::duration<double>(clock::now() - start).count();
+        const PhysicsStats cpu_stats = measurePhysics(cpu_free);
+        const PhysicsStats gpu_stats = measurePhysics(gpu_free);
+        cpu_unstable += cpu_stats.unstable() ? 1 : 0;
+        gpu_unstable += gpu_stats.unstable() ? 1 : 0;
+        cpu_penetration += cpu_stats.max_penetration;
+        gpu_penetration += gpu_stats.max_penetration;
+    }
+    gpu.release();
+
+    auto count = [](const PhysicSolver& s) { return std::count(s.has_obj.begin(), s.has_obj.end(), true); };
+    const double ticks = std::max(1u, options.ticks);
+    std::printf("lockstep: %u ticks, position error %.5f (%.5f on merge ticks), merges disagree on %u ticks\n",
+                options.ticks, contact_error, merge_error, disagreements);
+    std::printf("free run: cpu %d points, %d fruits, mean deepest overlap %.4f, %llu unstable ticks, %.1f us/tick\n",
+                cpu_free.total_points.load(), static_cast<int>(count(cpu_free)), cpu_penetration / ticks,
+                static_cast<unsigned long long>(cpu_unstable), cpu_seconds / ticks * 1e6);
+    std::printf("          gpu %d points, %d fruits, mean deepest overlap %.4f, %llu unstable ticks, %.1f us/tick\n",
+                gpu_free.total_points.load(), static_cast<int>(count(gpu_free)), gpu_penetration / ticks,
+                static_cast<unsigned long long>(gpu_unstable), gpu_seconds / ticks * 1e6);
+
+    const bool pass = contact_error <= options.tolerance && disagreements <= options.ticks / 100 &&
+                      gpu_penetration <= cpu_penetration * 1.1;
+    std::cout << (pass ? "gpu physics matches the cpu solver" : "gpu physics DIFFERS from the cpu solver") << std::endl;
+    return pass ? 0 : 1;
+}
@@ -2,76 +2,73 @@
 
 #include "boundary.hpp"
 
-
-class HemisphereBoundary : public Boundary {
-public:
-    glm::vec4 center;
-    float radius;
-    float margin;
-    float cutoffAngle;  // radians
-
-    HemisphereBoundary(glm::vec4 center, float radius,
-                       float angleDegrees = 90.0f,
-                       float margin = 0.1f)
-      : center(center), radius(radius), margin(margin)
+// The bowl's contact surface: a shell of thickness 2 * margin around the sphere of
+// `radius`, cut off `cutoff` radians from straight down, with a rounded rim. Shared by
+// HemisphereBoundary and the batched solver, so both keep fruits in the same bowl.
+struct HemisphereShape
+{
+    glm::vec4 center = glm::vec4(0.0f);
+    float cutoff = 0.0f; // radians
+    float inner = 0.0f;  // radius - margin
+    float outer = 0.0f;  // radius + margin
+    float cos_cutoff = 0.0f;
+    float sin_cutoff = 0.0f;
+    float rim_y = 0.0f;
+    float rim_radius = 0.0f;
+
+    HemisphereShape() = default;
+    HemisphereShape(glm::vec4 center_, float radius, float margin, float cutoff_angle)
+        : center(center_), cutoff(cutoff_angle), inner(radius - margin), outer(radius + margin),
+          cos_cutoff(glm::cos(cutoff_angle)), sin_cutoff(glm::sin(cutoff_angle))
     {
-        cutoffAngle = glm::radians(angleDegrees);
+        rim_y = center.y - inner * cos_cutoff;
+        rim_radius = inner * sin_cutoff;
     }
-    void checkSphere(PhysicsObject& obj) const override {
-        const float inner_radius = radius - margin;
-        const float outer_radius = radius + margin;
-        const float required_dist = obj.radius;
 
-        glm::vec4 pos = obj.position;
-        glm::vec4 prev = obj.last_position;
-
-        glm::vec4 offset = pos - center;
-        float dist = glm::length(offset);
-        if (dist < 1e-6f) return;
+    // Pushes a sphere of radius `required_dist` out of the nearest surface (inner shell,
+    // outer shell or rim) and keeps only its tangential velocity. Returns false, changing
+    // nothing, when the sphere does not touch the bowl.
+    bool constrain(glm::vec4& pos, glm::vec4& last_pos, float required_dist) const
+    {
+        const glm::vec4 offset = pos - center;
+        const float dist = glm::length(offset);
+        if (dist < 1e-6f) return false;
 
         glm::vec4 normal = offset / dist;
-        glm::vec4 down = glm::vec4(0, -1, 0, 0);
-        float cos_theta = glm::clamp(glm::dot(normal, down), -1.0f, 1.0f);
-        float angle = glm::acos(cos_theta);
+        const glm::vec4 down = glm::vec4(0, -1, 0, 0);
+        const float cos_theta = glm::clamp(glm::dot(normal, down), -1.0f, 1.0f);
+        const float angle = glm::acos(cos_theta);
 
-        // Clamp normal to cutoffAngle cone (if above it)
-        if (angle > cutoffAngle) {
-            float clamped_cos = glm::cos(cutoffAngle);
+        // Clamp the normal to the cutoff cone
+        if (angle > cutoff) {
             glm::vec4 perp = normal - cos_theta * down;
-            float perp_len = glm::length(perp);
+            const float perp_len = glm::length(perp);
             if (perp_len > 1e-6f) {
                 perp /= perp_len;
-                normal = clamped_cos * down + glm::sqrt(1.0f - clamped_cos * clamped_cos) * perp;
+                normal = cos_cutoff * down + glm::sqrt(1.0f - cos_cutoff * cos_cutoff) * perp;
             } else {
-                normal = glm::vec4(glm::sin(cutoffAngle), -glm::cos(cutoffAngle), 0.0f, 0.0f);
+                normal = glm::vec4(sin_cutoff, -cos_cutoff, 0.0f, 0.0f);
             }
             normal = glm::normalize(normal);
         }
 
-        // Points on inner/outer shell
-        glm::vec4 inner_point = center + normal * inner_radius;
-        glm::vec4 outer_point = center + normal * outer_radius;
+        const glm::vec4 inner_point = center + normal * inner;
+        const glm::vec4 outer_point = center + normal * outer;
 
-        // Rim edge point
-        float rim_y = center.y - inner_radius * glm::cos(cutoffAngle);
-        float rim_rad = inner_radius * glm::sin(cutoffAngle);
+        // Rim edge point, in the horizontal plane of the rim
         glm::vec4 rim_offset = offset;
-        rim_offset.y = 0;  // Flatten to horizontal rim plane
-
-        float rim_len = glm::length(rim_offset);
-        if (rim_len > 1e-6f) rim_offset = rim_offset / rim_len * rim_rad;
-        else rim_offset = glm::vec4(rim_rad, 0, 0, 0); // Default rim direction
-
-        glm::vec4 rim_point = glm::vec4(center.x + rim_offset.x, rim_y, center.z + rim_offset.z, center.w + rim_offset.w);
+        rim_offset.y = 0;
+        const float rim_len = glm::length(rim_offset);
+        if (rim_len > 1e-6f) rim_offset = rim_offset / rim_len * rim_radius;
+        else rim_offset = glm::vec4(rim_radius, 0, 0, 0);
+        const glm::vec4 rim_point = glm::vec4(center.x + rim_offset.x, rim_y, center.z + rim_offset.z, center.w + rim_offset.w);
 
-        // Find closest surface point
-        float d_inner = glm::length(pos - inner_point);
-        float d_outer = glm::length(pos - outer_point);
-        float d_rim   = glm::length(pos - rim_point);
+        const float d_inner = glm::length(pos - inner_point);
+        const float d_outer = glm::length(pos - outer_point);
+        const float d_rim   = glm::length(pos - rim_point);
 
         glm::vec4 closest = inner_point;
         float min_dist = d_inner;
-
         if (d_outer < min_dist) {
             min_dist = d_outer;
             closest = outer_point;
@@ -80,22 +77,37 @@ public:
             min_dist = d_rim;
             closest = rim_point;
         }
+        if (min_dist >= required_dist) return false;
 
-        if (min_dist < required_dist) {
-            glm::vec4 push_dir = pos - closest;
-            float len = glm::length(push_dir);
-            push_dir = (len > 1e-6f) ? push_dir / len : glm::vec4(0, 1, 0, 0);
-            pos = closest + push_dir * required_dist;
-
-            obj.position = pos;
+        glm::vec4 push_dir = pos - closest;
+        const float len = glm::length(push_dir);
+        push_dir = (len > 1e-6f) ? push_dir / len : glm::vec4(0, 1, 0, 0);
+        pos = closest + push_dir * required_dist;
 
-            glm::vec4 velocity = pos - prev;
-            glm::vec4 tangent = velocity - glm::dot(velocity, push_dir) * push_dir;
-            obj.last_position = pos - tangent;
-        }
+        const glm::vec4 velocity = pos - last_pos;
+        const glm::vec4 tangent = velocity - glm::dot(velocity, push_dir) * push_dir;
+        last_pos = pos - tangent;
+        return true;
     }
+};
 
+class HemisphereBoundary : public Boundary {
+public:
+    glm::vec4 center;
+    float radius;
+    float margin;
+    float cutoffAngle;  // radians
 
+    HemisphereBoundary(glm::vec4 center, float radius,
+                       float angleDegrees = 90.0f,
+                       float margin = 0.1f)
+      : center(center), radius(radius), margin(margin)
+    {
+        cutoffAngle = glm::radians(angleDegrees);
+    }
+    void checkSphere(PhysicsObject& obj) const override {
+        HemisphereShape(center, radius, margin, cutoffAngle).constrain(obj.position, obj.last_position, obj.radius);
+    }
 
     RayInter checkRay(float w, const glm::vec3& rayOrigin, const glm::vec3& rayDirection) const override {
         RayInter out;
@@ -0,0 +1,82 @@
+#pragma once
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include <GLFW/glfw3.h>
+
+// How much redrawing the current screen needs
+enum class FrameDemand {
+    Continuous, // gameplay, overlay or trace capture: render every loop iteration
+    Animated,   // slow screen animation (game over camera): a reduced fixed rate
+    Static,     // menu: only after input, resize or expose events
+};
+
+// Event-driven idle mode. Instead of polling and redrawing at the pacing rate, the
+// main loop sleeps in the GLFW event queue while nothing on screen changes, and only
+// wakes a few times per second while the window is minimised.
+class IdleMode {
+public:
+    static constexpr double ANIMATION_FPS = 30.0;
+    static constexpr double STATIC_WAKE = 1.0;     // safety wake-up on a static screen (s)
+    static constexpr double ICONIFIED_WAKE = 0.25; // wake-up period while minimised (s)
+
+    bool enabled = true;
+
+    // SUIKA_IDLE=0 keeps rendering continuously on every screen
+    void Init() {
+        const char* env = std::getenv("SUIKA_IDLE");
+        enabled = !(env && !std::strcmp(env, "0"));
+#ifdef __EMSCRIPTEN__
+        enabled = false; // the browser already throttles requestAnimationFrame
+#endif
+        redraw = true;
+    }
+
+    // Called from input, resize and refresh callbacks
+    void RequestRedraw() { redraw = true; }
+
+    void SetIconified(bool value) {
+        iconified = value;
+        redraw = true;
+    }
+    bool Iconified() const { return iconified; }
+
+    // Blocks until the next frame is due. Returns false when the loop iteration
+    // should be skipped (minimised, or a static screen woke up without a change).
+    bool WaitForFrame(FrameDemand demand) {
+        if (!enabled || (demand == FrameDemand::Continuous && !iconified)) {
+            redraw = false;
+            return true;
+        }
+        if (!redraw) {
+            const double timeout = iconified ? ICONIFIED_WAKE
+                                 : demand == FrameDemand::Animated ? 1.0 / ANIMATION_FPS
+                                 : STATIC_WAKE;
+            WaitEvents(timeout);
+        }
+        if (iconified) return false;
+        const bool draw = redraw || demand != FrameDemand::Static;
+        redraw = false;
+        return draw;
+    }
+
+private:
+    bool redraw = true;
+    bool iconified = false;
+
+    void WaitEvents(double timeout) {
+#if GLFW_VERSION_MAJOR > 3 || (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 2)
+        glfwWaitEventsTimeout(timeout);
+#else
+        // no glfwWaitEventsTimeout before GLFW 3.2: poll in short sleeps instead
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeout);
+        do {
+            glfwPollEvents();
+            if (redraw) return;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        } while (std::chrono::steady_clock::now() < deadline);
+#endif
+    }
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "learnopengl/shader.h"
+#include "ballrenderer.hpp"
+
+// One sphere cross-section to draw: where it sits in its slice, how big the slice cuts it,
+// how far it is from the slice in w, and its layer of the texture array
+struct BallInstance
+{
+    glm::vec4 center_scale; // xyz with the slice's spatial offset, w the projected radius
+    float     w_delta;
+    float     layer;
+};
+
+// Draws spheres with glDrawElementsInstanced from a per-instance buffer: the caller adds
+// the instances of every slice once per frame, uploads them, then draws each slice's range
+// with one call. The shader (pbr_instanced) takes the texture from a 2D array by layer, so
+// neither uniforms nor textures change between fruits.
+class InstancedBallRenderer : public BallRenderer
+{
+public:
+    InstancedBallRenderer(Shader *shader, ShapeType shape_type = ICOSPHERE, int fidelity_ = 1)
+        : BallRenderer(shader, shape_type, fidelity_)
+    {
+        glGenVertexArrays(1, &m_instanced_vao);
+        glGenBuffers(1, &m_instance_vbo);
+        glBindVertexArray(m_instanced_vao);
+
+        // the sphere mesh of the base class
+        glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ebo);
+        glEnableVertexAttribArray(0);
+        glEnableVertexAttribArray(1);
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+
+        glBindBuffer(GL_ARRAY_BUFFER, m_instance_vbo);
+        glEnableVertexAttribArray(3); // center and projected radius
+        glEnableVertexAttribArray(4); // w delta and layer
+        glVertexAttribDivisor(3, 1);
+        glVertexAttribDivisor(4, 1);
+        pointInstances(0);
+
+        glBindVertexArray(0);
+    }
+
+    ~InstancedBallRenderer() override
+    {
+        glDeleteVertexArrays(1, &m_instanced_vao);
+        glDeleteBuffers(1, &m_instance_vbo);
+    }
+
+    // Starts a new frame
+    void clear() { m_instances.clear(); }
+
+    // Index the next add() goes to, to mark where a slice's range starts
+    uint32_t size() const { return static_cast<uint32_t>(m_instances.size()); }
+
+    // Adds the cross-section of a 4D sphere with slice w, unless the slice misses it
+    void add(float w, const glm::vec4& position, float radius, int layer, const glm::vec3& spatial_offset)
+    {
+        const float w_delta = position.w - w;
+        if (std::abs(w_delta) > radius) return;
+        const float projected = std::sqrt(std::max(0.0f, radius * radius - w_delta * w_delta));
+        m_instances.push_back({glm::vec4(glm::vec3(position) + spatial_offset, projected), w_delta, static_cast<float>(layer)});
+    }
+
+    // Sends this frame's instances to the GPU, once, before the first draw
+    void upload()
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, m_instance_vbo);
+        const size_t bytes = m_instances.size() * sizeof(BallInstance);
+        if (bytes > m_capacity) m_capacity = bytes * 2;
+        // orphan last frame's storage instead of waiting for draws that still read it
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(m_capacity), nullptr, GL_STREAM_DRAW);
+        if (bytes) glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(bytes), m_instances.data());
+    }
+
+    // Draws instances [first, first + count) with the shader already in use and the
+    // texture array bound
+    void draw(uint32_t first, uint32_t count, float alpha_mult)
+    {
+        if (count == 0) return;
+        this->shader->setFloat("alpha_mult", alpha_mult);
+        glBindVertexArray(m_instanced_vao);
+        glBindBuffer(GL_ARRAY_BUFFER, m_instance_vbo);
+        pointInstances(first); // GL 3.3 has no base instance
+        glDrawElementsInstanced(GL_TRIANGLES, indices_count, GL_UNSIGNED_INT, 0, static_cast<GLsizei>(count));
+        glBindVertexArray(0);
+    }
+
+private:
+    void pointInstances(uint32_t first)
+    {
+        const size_t base = first * sizeof(BallInstance);
+        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(BallInstance), (void*)(base + offsetof(BallInstance, center_scale)));
+        glVertexAttribPointer(4, 2, GL_FLOAT, GL_FALSE, sizeof(BallInstance), (void*)(base + offsetof(BallInstance, w_delta)));
+    }
+
+    unsigned int              m_instanced_vao = 0;
+    unsigned int              m_instance_vbo = 0;
+    size_t                    m_capacity = 0;
+    std::vector<BallInstance> m_instances;
+};
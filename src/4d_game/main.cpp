@@ -19,6 +19,9 @@
 #include "render_helper.hpp"
 #include "state_helper.hpp"
 #include "physics_solver.hpp"
+#include "render_bench.hpp"
+#include "replay.hpp"
+#include "autoplayer.hpp"
 
 // #include "resource_manager.h"
 
@@ -26,13 +29,9 @@
 
 #include <thread>  // for std::this_thread::sleep_for
 #include <chrono>  // for std::chrono::duration
+#include <cmath>
 
-// At the top of your file
-const float TARGET_FPS = 60.0f;
-const float FRAME_TIME = 1.0f / TARGET_FPS;
-
-// For fixed timestep
-const float FIXED_TIMESTEP = 1.0f / 60.0f; // 60 updates per second
+// For fixed timestep (only used when physics runs on the main thread)
 float fixedUpdateAccumulator = 0.0f;
 
 // GLFW function declarations
@@ -42,6 +41,8 @@ void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
 void cursorPosCallback(GLFWwindow* window, double xpos, double ypos);
 void scrollCallback(GLFWwindow* window, double xoffset, double yoffset);
 void windowSizeCallback(GLFWwindow* window, int windowWidth, int windowHeight);
+void windowRefreshCallback(GLFWwindow* window);
+void windowIconifyCallback(GLFWwindow* window, int iconified);
 
 // The Width of the screen
 const unsigned int SCREEN_WIDTH = 800;
@@ -56,26 +57,112 @@ int main(int argc, char* argv[])
     // std::cout << "GL_RENDERER: " << glGetString(GL_RENDERER) << "\n";
     // std::cout << "GLSL_VERSION: " << glGetString(GL_SHADING_LANGUAGE_VERSION) << "\n";
     std::cout << "Starting 4D Game initialization..." << std::endl;
+    prof::setThreadName("main");
+    uint32_t validate_gpu_ticks = 0;
+    for (int i = 1; i < argc; ++i) {
+        // --trace <file>: capture the whole run as a Chrome trace
+        if (std::string(argv[i]) == "--trace" && i + 1 < argc) {
+            game.StartTrace(argv[++i]);
+        }
+        // --record <file>: log every input for headless replay, --seed <n>: fixed fruit sequence
+        else if (std::string(argv[i]) == "--record" && i + 1 < argc) {
+            game.record_path = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--seed" && i + 1 < argc) {
+            game.fruit_seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        // --save <file>: where the game is saved on pause and exit, --no-save: start fresh, save nothing
+        else if (std::string(argv[i]) == "--save" && i + 1 < argc) {
+            game.save_path = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--no-save") {
+            game.save_path.clear();
+        }
+        // --spectate <endpoint>: stream the bowl to spectator_view (tcp:[host:]port or unix:path)
+        else if (std::string(argv[i]) == "--spectate" && i + 1 < argc) {
+            game.spectate_endpoint = argv[++i];
+        }
+        // --props <file>: static colliders of the level, one "x y z w radius [fruit]" per line
+        else if (std::string(argv[i]) == "--props" && i + 1 < argc) {
+            game.props_path = argv[++i];
+        }
+        // --physics-lod <ticks>: fruits far from the viewed slices step only every <ticks> ticks
+        else if (std::string(argv[i]) == "--physics-lod" && i + 1 < argc) {
+            game.physics_lod = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        // --gpu-physics: step the solver in compute shaders (needs OpenGL 4.3)
+        else if (std::string(argv[i]) == "--gpu-physics") {
+            game.gpu_physics = true;
+        }
+        // --validate-gpu-physics <ticks>: compare the compute shaders with the CPU solver in a
+        // hidden window and exit (with --seed given before it; SUIKA_EGL=1 for llvmpipe)
+        else if (std::string(argv[i]) == "--validate-gpu-physics" && i + 1 < argc) {
+            validate_gpu_ticks = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        // --physics-log <file>: per-tick physics health as CSV, or JSON Lines for .json/.jsonl
+        // (also for --replay when given before it)
+        else if (std::string(argv[i]) == "--physics-log" && i + 1 < argc) {
+            game.physics_log_path = argv[++i];
+        }
+        // --replay <file>: step a recording through the solver as fast as possible, no window
+        else if (std::string(argv[i]) == "--replay" && i + 1 < argc) {
+            return runReplayFile(argv[++i], game.physics_log_path);
+        }
+        // --autoplay <moves>: the bot plays headless and reports rollouts per second
+        // (with --seed and --record given before it)
+        else if (std::string(argv[i]) == "--autoplay" && i + 1 < argc) {
+            return runAutoplay(static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10)), game.fruit_seed, game.record_path);
+        }
+    }
+    // --bench-render <frames>: render offscreen along a scripted path, print timings and exit
+    RenderBenchOptions bench;
+#ifndef __EMSCRIPTEN__
+    parseRenderBenchArgs(argc, argv, bench);
+#endif
     
     try {
         std::cout << "Initializing GLFW..." << std::endl;
         glfwInit();
-        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        // compute shaders need 4.3, which macOS never offers
+#if !defined(__APPLE__) && !defined(__EMSCRIPTEN__)
+        const bool want_compute = game.gpu_physics || validate_gpu_ticks > 0;
+#else
+        const bool want_compute = false;
+#endif
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, want_compute ? 4 : 3);
         glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
         glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 #ifdef __APPLE__
         glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
         glfwWindowHint(GLFW_RESIZABLE, true);
+#ifndef __EMSCRIPTEN__
+        if (bench.frames > 0 || validate_gpu_ticks > 0) {
+            glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+#ifdef GLFW_EGL_CONTEXT_API
+            // EGL works without an X server (e.g. Mesa llvmpipe on CI machines)
+            const char* egl = std::getenv("SUIKA_EGL");
+            if (egl && std::string(egl) == "1") glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+#endif
+            // no sound card required either
+            SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+        }
+#endif
 
         std::cout << "Creating GLFW window..." << std::endl;
         GLFWwindow* window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "game", nullptr, nullptr);
+        if (!window && want_compute && validate_gpu_ticks == 0) {
+            std::cerr << "No OpenGL 4.3 context, physics stays on the CPU" << std::endl;
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+            window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "game", nullptr, nullptr);
+        }
         if (!window) {
             std::cerr << "Failed to create GLFW window" << std::endl;
             glfwTerminate();
             return -1;
         }
         glfwMakeContextCurrent(window);
+        game.PinRenderThread();
 
         std::cout << "Initializing SDL audio..." << std::endl;
         // Initialize SDL audio with error handling for web build
@@ -111,6 +198,16 @@ int main(int argc, char* argv[])
             std::cout << "Failed to initialize GLAD" << std::endl;
             return -1;
         }
+#ifndef __EMSCRIPTEN__
+        if (validate_gpu_ticks > 0) {
+            GpuValidationOptions validation;
+            validation.ticks = validate_gpu_ticks;
+            validation.seed = game.fruit_seed;
+            const int result = runGpuPhysicsValidation(validation);
+            glfwTerminate();
+            return result;
+        }
+#endif
 
         std::cout << "Setting up GLFW callbacks..." << std::endl;
         glfwSetKeyCallback(window, key_callback);
@@ -119,6 +216,8 @@ int main(int argc, char* argv[])
         glfwSetMouseButtonCallback(window, mouseButtonCallback);
         glfwSetCursorPosCallback(window, cursorPosCallback);
         glfwSetScrollCallback(window, scrollCallback);
+        glfwSetWindowRefreshCallback(window, windowRefreshCallback);
+        glfwSetWindowIconifyCallback(window, windowIconifyCallback);
 
         std::cout << "Configuring OpenGL..." << std::endl;
         // OpenGL configuration
@@ -137,6 +236,15 @@ int main(int argc, char* argv[])
         game.Init(window);
         std::cout << "Game initialization completed successfully!" << std::endl;
 
+        if (bench.frames > 0) {
+            const int result = runRenderBenchmark(game, bench);
+            game.StopTrace();
+            game.pacer.Release();
+            game.overlay.Release();
+            glfwTerminate();
+            return result;
+        }
+
         // deltaTime variables
         // -------------------
         float deltaTime = 0.0f;
@@ -144,6 +252,14 @@ int main(int argc, char* argv[])
 
         while (!glfwWindowShouldClose(window))
         {
+            // Idle mode: static screens and minimised windows sleep in the event queue
+            if (!game.idle.WaitForFrame(game.CurrentFrameDemand())) {
+                game.pacer.Suspend();
+                lastFrame = glfwGetTime(); // time spent idle is not simulated
+                continue;
+            }
+            game.pacer.BeginFrame();
+
             // Calculate delta time
             float currentFrame = glfwGetTime();
             float deltaTime = currentFrame - lastFrame;
@@ -154,13 +270,23 @@ int main(int argc, char* argv[])
 
             game.ProcessInput(deltaTime);
 
-            // Fixed update loop
-            fixedUpdateAccumulator += deltaTime;
-            while (fixedUpdateAccumulator >= FIXED_TIMESTEP)
+            // Fixed update loop, only when physics is not on its own thread. The physics
+            // governor bounds the ticks per frame and may slow simulated time down.
+            const float fixedTimestep = game.PhysicsTimestep();
+            fixedUpdateAccumulator = game.PhysicsThreaded() ? 0.0f : fixedUpdateAccumulator + deltaTime * game.PhysicsTimeScale();
+            uint32_t fixedUpdates = 0;
+            while (fixedUpdateAccumulator >= fixedTimestep && fixedUpdates < game.PhysicsCatchUpTicks())
             {
-                game.FixedUpdate(FIXED_TIMESTEP);  // You'll need to add this to your Game class
-                fixedUpdateAccumulator -= FIXED_TIMESTEP;
+                game.FixedUpdate(fixedTimestep);  // You'll need to add this to your Game class
+                fixedUpdateAccumulator -= fixedTimestep;
+                ++fixedUpdates;
+            }
+            if (fixedUpdateAccumulator >= fixedTimestep) {
+                // drop what the budget cannot absorb instead of replaying it next frame
+                game.DropPhysicsTicks(static_cast<uint64_t>(fixedUpdateAccumulator / fixedTimestep));
+                fixedUpdateAccumulator = std::fmod(fixedUpdateAccumulator, fixedTimestep);
             }
+            game.physics_alpha = fixedUpdateAccumulator / fixedTimestep;
             game.Update(deltaTime);  // You'll need to add this to your Game class
 
             // Render
@@ -169,17 +295,25 @@ int main(int argc, char* argv[])
 
             game.Render();
 
-            glfwSwapBuffers(window);
-
-            // Frame rate cap
-            float frameEnd = glfwGetTime();
-            float frameDuration = frameEnd - currentFrame;
-            if (frameDuration < FRAME_TIME)
+            // Swap (timed) and pace the frame according to SUIKA_PACING / SUIKA_FPS
+            {
+                PROFILE_SCOPE("present");
+                game.pacer.Present(window);
+            }
             {
-                std::this_thread::sleep_for(std::chrono::duration<float>(FRAME_TIME - frameDuration));
+                PROFILE_SCOPE("frame pacing");
+                game.pacer.Wait();
             }
-            
         }
+        game.StopTrace();
+        game.SaveGame();
+        game.StopRecording();
+        game.StopSpectating();
+        game.StopPhysicsLog();
+        game.ReleaseGpuPhysics();
+        std::cout << game.pacer.Summary() << std::endl;
+        game.pacer.Release();
+        game.overlay.Release();
 
 
         // delete all resources as loaded using the resource manager
@@ -215,6 +349,7 @@ int WINAPI WinMain(
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
+    game.idle.RequestRedraw();
     // make sure the viewport matches the new window dimensions; note that width and 
     // height will be significantly larger than specified on retina displays.
     glfwGetFramebufferSize(window, &width, &height);
@@ -226,6 +361,7 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
     // // when a user presses the escape key, we set the WindowShouldClose property to true, closing the application
     // if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
     //     glfwSetWindowShouldClose(window, true);
+    game.idle.RequestRedraw();
     if (key >= 0 && key < 1024)
     {
         if (action == GLFW_PRESS)
@@ -239,6 +375,7 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 }
 
 void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
+    game.idle.RequestRedraw();
     game.state.onMouseButton(button, action, game.state.m_xpos, game.state.m_ypos);
     if (game.State == GAME_MENU && button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS){
         // game.ballPlaced=true;
@@ -247,15 +384,11 @@ void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
         // game.ballPlaced=true;
     }
     if (game.State == GAME_ACTIVE && button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
-        RayInter closestResult = getPlacementMouse(&game.state, &game.boundary, game.physics_solver);
+        RayInter closestResult = getPlacementMouse(&game.state, &game.boundary, game.simulation->current());
 
         if (closestResult.hit) {
             // std::cout << "HIT\n";
-            game.physics_solver->addObject(
-                PhysicsObject(glm::vec4(closestResult.point, game.state.w)+ glm::vec4(0,3.0f,0,0),
-                game.nextFruit, true, false)
-            );
-            game.nextFruit = FruitManager::getRandomFruit();
+            game.DropFruit(closestResult.point);
         }
         game.ballPlaced=true;
     }
@@ -264,14 +397,27 @@ void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
 void cursorPosCallback(GLFWwindow* window, double xpos, double ypos) {
     if (!game.state.initialized) game.state.Init(window);
     game.state.onCursorPos(xpos, ypos);
+    // plain hovering changes nothing on the menus, dragging (sliders, camera) does
+    if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS ||
+        glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS) {
+        game.idle.RequestRedraw();
+    }
 }
 
 void scrollCallback(GLFWwindow* window, double xoffset, double yoffset) {
     if (!game.state.initialized) game.state.Init(window);
     game.state.onScroll(yoffset);
+    game.idle.RequestRedraw();
 }
 void windowSizeCallback(GLFWwindow* window, int windowWidth, int windowHeight){
     if (!game.state.initialized) game.state.Init(window);
     game.state.windowHeight = windowHeight;
     game.state.windowWidth = windowWidth;
-}
\ No newline at end of file
+    game.idle.RequestRedraw();
+}
+void windowRefreshCallback(GLFWwindow* window){
+    game.idle.RequestRedraw();
+}
+void windowIconifyCallback(GLFWwindow* window, int iconified){
+    game.SetIconified(iconified != 0);
+}
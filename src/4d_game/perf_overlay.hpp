@@ -0,0 +1,262 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "text_renderer.h"
+#include "frame_pacing.hpp"
+#include "simulation_thread.hpp"
+#include "pool_telemetry.hpp"
+
+enum PerfPhase {
+    PERF_INPUT,
+    PERF_SKYBOX,
+    PERF_TABLE,
+    PERF_BOWL,
+    PERF_UI,
+    PERF_PHASE_COUNT
+};
+
+inline const char* perfPhaseName(PerfPhase phase) {
+    switch (phase) {
+        case PERF_INPUT:  return "input";
+        case PERF_SKYBOX: return "skybox";
+        case PERF_TABLE:  return "table";
+        case PERF_BOWL:   return "bowl";
+        case PERF_UI:     return "ui";
+        default:          return "?";
+    }
+}
+
+// F3 overlay with frame-time graph, CPU/GPU time per phase and simulation counters.
+// While hidden, a phase scope costs one branch and no GL queries are issued.
+class PerfOverlay {
+public:
+    bool visible = false;
+    bool capture = false; // record phase timings without drawing (render benchmark)
+
+    struct Scope {
+        PerfOverlay* overlay;
+        PerfPhase phase;
+        std::chrono::steady_clock::time_point start;
+
+        Scope(PerfOverlay& o, PerfPhase p) : overlay(o.visible || o.capture ? &o : nullptr), phase(p) {
+            if (!overlay) return;
+            start = std::chrono::steady_clock::now();
+            if (phase != PERF_INPUT) overlay->gpu[phase].Begin();
+        }
+        ~Scope() {
+            if (!overlay) return;
+            if (phase != PERF_INPUT) overlay->gpu[phase].End();
+            const float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+            overlay->cpu_ms[phase] += ms; // a phase may run more than once per frame (side slices)
+        }
+    };
+
+    void Init() {
+        for (GpuTimer& timer : gpu) timer.Init();
+    }
+
+    // Timings of the last completed frame
+    float PhaseCpuMs(PerfPhase phase) const { return cpu_last_ms[phase]; }
+    float PhaseGpuMs(PerfPhase phase) const { return gpu[phase].last_ms; }
+    void PollGpu() {
+        for (GpuTimer& timer : gpu) timer.Poll();
+    }
+
+    void Release() {
+        for (GpuTimer& timer : gpu) timer.Release();
+    }
+
+    void Toggle() {
+        visible = !visible;
+        last_tick = 0;
+    }
+
+    // Folds this frame's phase times into the smoothed values and starts a new frame
+    void EndFrame() {
+        if (!visible && !capture) return;
+        for (int i = 0; i < PERF_PHASE_COUNT; i++) {
+            cpu_last_ms[i] = cpu_ms[i];
+            cpu_avg_ms[i] += 0.1f * (cpu_ms[i] - cpu_avg_ms[i]);
+            cpu_ms[i] = 0.0f;
+        }
+    }
+
+    // Counters from the latest physics tick
+    void SampleSimulation(const RenderState& snapshot) {
+        if (!visible) return;
+        if (last_tick != 0 && snapshot.tick >= last_tick) {
+            ticks_per_frame += 0.1f * (static_cast<float>(snapshot.tick - last_tick) - ticks_per_frame);
+        }
+        last_tick = snapshot.tick;
+        tick_avg_ms += 0.1f * (snapshot.tick_ms - tick_avg_ms);
+        contact_pairs = snapshot.contact_pairs;
+        governor = snapshot.governor;
+        time_scale = snapshot.time_scale;
+        rewind_seconds = snapshot.rewind_seconds;
+        rewind_bytes = snapshot.rewind_bytes;
+        snapshot_us += 0.1f * (snapshot.snapshot_us - snapshot_us);
+        lod_far = snapshot.lod_far;
+        physics = snapshot.physics;
+        unstable_ticks = snapshot.unstable_ticks;
+        fruits = 0;
+        for (const RenderObject& obj : snapshot.objects) fruits += obj.active ? 1 : 0;
+    }
+
+    // Search throughput of the bot, sampled after each of its moves
+    void SampleAutoPlayer(double rollouts_per_second, float search_ms) {
+        bot_rollouts_per_second = rollouts_per_second;
+        bot_search_ms = search_ms;
+    }
+
+    // Spectator stream (--spectate), read from the publisher's counters every frame
+    void SampleSpectator(const SpectatorPublisher& publisher) {
+        spectating = true;
+        spectator_viewers = publisher.viewers();
+        spectator_rate = publisher.bytesPerSecond();
+        spectator_frame_bytes = publisher.bytesPerFrame();
+        spectator_encode_us = publisher.encodeMicroseconds();
+    }
+
+    // Executor utilisation over the interval since the previous sample
+    void SamplePool(const tp::PoolStats& stats) {
+        pool_timer = 0.0f;
+        pool_name = stats.backend;
+        pool_threads = stats.thread_count;
+        pool_utilization = stats.utilization();
+        collisions_imbalance = 1.0f;
+        for (const tp::DispatchStats& d : stats.dispatches) {
+            if (d.label == std::string("collisions")) collisions_imbalance = static_cast<float>(d.meanImbalance());
+        }
+    }
+
+    bool PoolSampleDue(float dt) {
+        pool_timer += dt;
+        return visible && pool_timer >= 0.5f;
+    }
+
+    void Draw(TextRenderer* text, unsigned int width, unsigned int height, const FramePacer& pacer) {
+        if (!visible) return;
+        glDisable(GL_DEPTH_TEST);
+        glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f);
+        text->shader->use();
+        text->shader->setMat4("projection", projection);
+
+        const float scale = 0.5f;
+        const float line = 14.0f;
+        const float x = 10.0f;
+        float y = 60.0f;
+        const glm::vec3 color(0.9f, 1.0f, 0.6f);
+        char buf[160];
+
+        const FrameTimeStats stats = pacer.Stats();
+        const FrameTiming& last = pacer.Last();
+        std::snprintf(buf, sizeof(buf), "%.1f fps  frame %.2f ms (sd %.2f p99 %.2f max %.2f)",
+                      stats.mean_ms > 0.0f ? 1000.0f / stats.mean_ms : 0.0f, stats.mean_ms, stats.stddev_ms, stats.p99_ms, stats.max_ms);
+        text->RenderText(buf, x, y, scale, color);
+        y += line;
+        std::snprintf(buf, sizeof(buf), "cpu %.2f  gpu %.2f  present %.2f  wait %.2f ms  [%s]",
+                      last.cpu_ms, last.gpu_ms, last.present_ms, last.wait_ms, pacingModeName(pacer.config.mode));
+        text->RenderText(buf, x, y, scale, color);
+        y += line + 4.0f;
+
+        // Frame-time graph: one stretched '|' glyph per frame, 33 ms full scale
+        const float graph_height = 50.0f;
+        const float bar_width = 2.0f;
+        const std::vector<FrameTiming> frames = pacer.Recent();
+        float bx = x;
+        for (const FrameTiming& t : frames) {
+            const float h = std::max(1.0f, std::min(graph_height, t.frame_ms / 33.3f * graph_height));
+            const glm::vec3 bar_color = t.frame_ms > 17.5f ? glm::vec3(1.0f, 0.3f, 0.2f) : glm::vec3(0.3f, 1.0f, 0.4f);
+            text->RenderTextScale("|", bx, y + graph_height - h, bar_width, h, bar_color);
+            bx += bar_width;
+        }
+        y += graph_height + 6.0f;
+
+        text->RenderText("phase     cpu ms   gpu ms", x, y, scale, color);
+        y += line;
+        for (int i = 0; i < PERF_PHASE_COUNT; i++) {
+            if (i == PERF_INPUT) {
+                std::snprintf(buf, sizeof(buf), "%-8s %7.3f", perfPhaseName(static_cast<PerfPhase>(i)), cpu_avg_ms[i]);
+            } else {
+                std::snprintf(buf, sizeof(buf), "%-8s %7.3f  %7.3f", perfPhaseName(static_cast<PerfPhase>(i)), cpu_avg_ms[i], gpu[i].last_ms);
+            }
+            text->RenderText(buf, x, y, scale, color);
+            y += line;
+        }
+        std::snprintf(buf, sizeof(buf), "physics  %7.3f  (%.2f ticks/frame)", tick_avg_ms, ticks_per_frame);
+        text->RenderText(buf, x, y, scale, color);
+        y += line;
+        std::snprintf(buf, sizeof(buf), "governor %s  time x%.2f", governorLevelName(governor), time_scale);
+        text->RenderText(buf, x, y, scale, governor == GovernorLevel::Normal ? color : glm::vec3(1.0f, 0.5f, 0.2f));
+        y += line;
+        std::snprintf(buf, sizeof(buf), "rewind   %.1f s  %u KB  snapshot %.1f us", rewind_seconds, rewind_bytes / 1024, snapshot_us);
+        text->RenderText(buf, x, y, scale, color);
+        y += line;
+        if (bot_search_ms > 0.0f) {
+            std::snprintf(buf, sizeof(buf), "bot      %.0f rollouts/s  search %.1f ms", bot_rollouts_per_second, bot_search_ms);
+            text->RenderText(buf, x, y, scale, color);
+            y += line;
+        }
+        if (spectating) {
+            std::snprintf(buf, sizeof(buf), "stream   %u viewers  %.1f KB/s  %.0f B/frame  encode %.0f us",
+                          spectator_viewers, spectator_rate / 1024.0, spectator_frame_bytes, spectator_encode_us);
+            text->RenderText(buf, x, y, scale, color);
+            y += line;
+        }
+        y += 4.0f;
+
+        std::snprintf(buf, sizeof(buf), "fruits %d (%u far)  contact pairs %u", fruits, lod_far, contact_pairs);
+        text->RenderText(buf, x, y, scale, color);
+        y += line;
+        std::snprintf(buf, sizeof(buf), "health   KE %.2f  v %.1f  overlap %.2f/%.3f (%u)  wall %.3f  unstable %llu",
+                      physics.kinetic_energy, physics.max_speed, physics.max_penetration, physics.mean_penetration,
+                      physics.contacts, physics.boundary_correction, static_cast<unsigned long long>(unstable_ticks));
+        text->RenderText(buf, x, y, scale, physics.unstable() ? glm::vec3(1.0f, 0.5f, 0.2f) : color);
+        y += line;
+        std::snprintf(buf, sizeof(buf), "pool %s x%u  util %.0f%%  collision imbalance %.2f",
+                      pool_name.c_str(), pool_threads, pool_utilization * 100.0, collisions_imbalance);
+        text->RenderText(buf, x, y, scale, color);
+        glEnable(GL_DEPTH_TEST);
+    }
+
+private:
+    float cpu_ms[PERF_PHASE_COUNT] = {};
+    float cpu_avg_ms[PERF_PHASE_COUNT] = {};
+    float cpu_last_ms[PERF_PHASE_COUNT] = {};
+    GpuTimer gpu[PERF_PHASE_COUNT];
+
+    uint64_t last_tick = 0;
+    float ticks_per_frame = 0.0f;
+    float tick_avg_ms = 0.0f;
+    uint32_t contact_pairs = 0;
+    GovernorLevel governor = GovernorLevel::Normal;
+    float time_scale = 1.0f;
+    float rewind_seconds = 0.0f;
+    uint32_t rewind_bytes = 0;
+    float snapshot_us = 0.0f;
+    uint32_t lod_far = 0;
+    PhysicsStats physics;
+    uint64_t unstable_ticks = 0;
+    double bot_rollouts_per_second = 0.0;
+    float bot_search_ms = 0.0f;
+    bool spectating = false;
+    uint32_t spectator_viewers = 0;
+    double spectator_rate = 0.0;
+    double spectator_frame_bytes = 0.0;
+    float spectator_encode_us = 0.0f;
+    int fruits = 0;
+
+    float pool_timer = 0.0f;
+    std::string pool_name;
+    uint32_t pool_threads = 0;
+    double pool_utilization = 0.0;
+    float collisions_imbalance = 1.0f;
+};
@@ -217,15 +217,57 @@
 // };
 #pragma once
 
-#include <glad/glad.h>
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
 #include <glm/glm.hpp>
 
-#include "texture.h"
 #include "globals.h"
 
-#include "fruit.hpp"
+#include "fruit_data.hpp"
 
 
+// Ray against the 3D cross-section of a 4D sphere at slice w
+inline RayInter testSphereRay(const glm::vec4& position, float radius, float w, const glm::vec3& rayOrigin, const glm::vec3& rayDirection){
+    RayInter out;
+    if (abs(position.w-w)>radius) return out;
+    
+    glm::vec3 oc = rayOrigin - glm::vec3(position);
+    float a = glm::dot(rayDirection, rayDirection);
+    float b = 2.0f * glm::dot(oc, rayDirection);
+    float c = glm::dot(oc, oc) - (radius * radius - (position.w - w)*(position.w - w));
+    
+    float discriminant = b * b - 4 * a * c;
+
+    
+    if (discriminant < 0) {
+        return out; // No intersection, hit remains false
+    }
+    
+    // Calculate the two intersection points
+    float sqrt_discriminant = sqrt(discriminant);
+    float t1 = (-b - sqrt_discriminant) / (2.0f * a);
+    float t2 = (-b + sqrt_discriminant) / (2.0f * a);
+    
+    // We want the closest positive intersection
+    float t = -1.0f;
+    if (t1 > 0 && t2 > 0) {
+        t = std::min(t1, t2); // Both positive, take closest
+    } else if (t1 > 0) {
+        t = t1; // Only t1 is positive
+    } else if (t2 > 0) {
+        t = t2; // Only t2 is positive
+    }
+    
+    if (t > 0) {
+        out.hit = true;
+        out.distance = t;
+        out.point = rayOrigin + t * rayDirection;
+    }
+    
+    return out;
+}
+
 class PhysicsObject
 {
 public:
@@ -247,54 +289,18 @@ public:
     PhysicsObject(glm::vec4 pos, Fruit f, bool dyn, bool hid): position(pos),last_position(pos), fruit(f), acceleration(0.0f, 0.0f, 0.0f, 0.0f),  dynamic(dyn), hidden(hid)
     {
         radius = 0;
-        target_radius = FruitManager::getFruitProperties(fruit).radius;
+        target_radius = fruitPhysics(fruit).radius;
         growing=true;
     }
 
     RayInter testRay(float w, const glm::vec3& rayOrigin, const glm::vec3& rayDirection){
-        RayInter out;
-        if (abs(position.w-w)>radius) return out;
-        
-        glm::vec3 oc = rayOrigin - glm::vec3(position);
-        float a = glm::dot(rayDirection, rayDirection);
-        float b = 2.0f * glm::dot(oc, rayDirection);
-        float c = glm::dot(oc, oc) - (radius * radius - (position.w - w)*(position.w - w));
-        
-        float discriminant = b * b - 4 * a * c;
-
-        
-        if (discriminant < 0) {
-            return out; // No intersection, hit remains false
-        }
-        
-        // Calculate the two intersection points
-        float sqrt_discriminant = sqrt(discriminant);
-        float t1 = (-b - sqrt_discriminant) / (2.0f * a);
-        float t2 = (-b + sqrt_discriminant) / (2.0f * a);
-        
-        // We want the closest positive intersection
-        float t = -1.0f;
-        if (t1 > 0 && t2 > 0) {
-            t = std::min(t1, t2); // Both positive, take closest
-        } else if (t1 > 0) {
-            t = t1; // Only t1 is positive
-        } else if (t2 > 0) {
-            t = t2; // Only t2 is positive
-        }
-        
-        if (t > 0) {
-            out.hit = true;
-            out.distance = t;
-            out.point = rayOrigin + t * rayDirection;
-        }
-        
-        return out;
+        return testSphereRay(position, radius, w, rayOrigin, rayDirection);
     }
     
     void upgrade_fruit(){
-        fruit = FruitManager::getNextFruit(fruit);
+        fruit = nextFruit(fruit);
         // radius=0;
-        target_radius = FruitManager::getFruitProperties(fruit).radius;
+        target_radius = fruitPhysics(fruit).radius;
         growing=true;
     }
     
@@ -304,10 +310,10 @@ public:
         last_position = pos;
     }
 
-    void update(float dt)
+    void update(float dt, const PhysicsParams& params = PhysicsParams())
     {
         if (growing){
-            radius += target_radius * dt * GROW_SPEED;
+            radius += target_radius * dt * params.grow_speed;
             if (radius>target_radius){
                 radius=target_radius;
                 growing=false;
@@ -315,7 +321,7 @@ public:
         }
         glm::vec4 last_update_move = position - last_position;
 
-        glm::vec4 new_position = position + last_update_move + (acceleration - last_update_move * VELOCITY_DAMPING) * (dt * dt);
+        glm::vec4 new_position = position + last_update_move + (acceleration - last_update_move * params.velocity_damping) * (dt * dt);
         last_position           = position;
         position                = new_position;
         acceleration = {0.0f, 0.0f, 0.0f, 0.0f};
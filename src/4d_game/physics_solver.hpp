@@ -4,55 +4,119 @@
 #include "physics_object.hpp"
 // #include "boundary.hpp"
 #include "boundary.hpp"
-#include "threadpool.hpp"
+#include "executor.hpp"
+#include "profiler.hpp"
 #include <glm/glm.hpp>
 #include <vector>
-#include <set>
 #include <array>
+#include <type_traits>
 #include <mutex>
 #include <atomic>
 #include <cmath>
 #include <algorithm>
 
 
+// Everything that defines a solver's simulation, as plain data: saving or restoring it
+// is a copy, so it can be snapshotted every tick (rewind) or cloned (rollouts)
+struct SolverState
+{
+    std::array<PhysicsObject,MAX_OBJECTS> objects;
+    std::array<bool,MAX_OBJECTS> has_obj{};
+    int total_points = 0;
+};
+static_assert(std::is_trivially_copyable<SolverState>::value, "SolverState must stay trivially copyable");
+
+// Optional level of detail along w. Fruits farther than near_distance (plus their radius)
+// from focus_w, and not touching a fruit that is near, form the far group: it is stepped
+// only every `interval` ticks, as one catch-up step of substeps no finer than max_sub_dt.
+// A far fruit that turns near first brings the whole group up to the present, so moving
+// the focus never shows a fruit that lags behind.
+struct SimulationLod
+{
+    bool     enabled = false;
+    float    focus_w = 0.0f;
+    float    near_distance = 1.0f;
+    uint32_t interval = 4;
+    float    max_sub_dt = 2.0f * PHYSICS_TIMESTEP;
+    float    contact_margin = 0.05f; // gap under which a far fruit counts as touching a near one
+};
+
+struct PhysicSolver;
+
+// Runs whole updates somewhere other than the executor (the GPU). update() returns false,
+// having changed nothing, to leave a tick to the CPU passes.
+class SolverBackend {
+public:
+    virtual ~SolverBackend() = default;
+    virtual bool update(PhysicSolver& solver, float dt) = 0;
+};
+
 struct PhysicSolver
 {
     std::array<PhysicsObject,MAX_OBJECTS> objects;
 
+    // Pair locks for the parallel collision pass, not part of the simulated state
     std::array<std::mutex,MAX_OBJECTS> object_locks;
-    std::mutex no_obj_mutex;
 
-    std::array<bool,MAX_OBJECTS> has_obj;
-    std::set<int> no_obj;
+    std::array<bool,MAX_OBJECTS> has_obj{}; // free slots are the ones without an object
     
     std::vector<Boundary*> boundary;
 
     glm::vec4                   gravity = {0.0f, -20.0f, 0.0f, 0.0f};
+    PhysicsParams               params;
 
     std::atomic<int> total_points = 0;
     std::atomic<int> just_merged =0;
+    std::atomic<uint32_t> contact_pairs_tested{0}; // pairs with both slots occupied, last update
+
+    // Bookkeeping of the last update for measurePhysics(), not part of the simulated state
+    std::array<glm::vec4,MAX_OBJECTS> tick_start_position; // where each slot began the update
+    std::array<float,MAX_OBJECTS> boundary_push{};          // distance the bowl moved each slot
+    std::array<float,MAX_OBJECTS> advanced{};               // simulated time each slot moved on
+
+    // Level of detail: the far group is lod_lag ticks behind the others. frozen masks the
+    // slots a pass leaves alone; step_dt is the sub step each slot's Verlet history was
+    // taken with (0 when unknown), so that it is rescaled when the step size changes.
+    SimulationLod                 lod;
+    std::array<bool,MAX_OBJECTS>  lod_far{};
+    std::array<bool,MAX_OBJECTS>  frozen{};
+    std::array<float,MAX_OBJECTS> step_dt{};
+    uint32_t                      lod_lag = 0;
+    uint32_t                      lod_far_count = 0;
     // glm::vec4                   gravity = {0.0f, 0.0f, 0.0f, 0.0f};
 
     // Simulation solving pass count
     uint32_t        sub_steps;
 
-    tp::ThreadPool& thread_pool;
+    tp::Executor& thread_pool;
+    SolverBackend* backend = nullptr; // not owned; must be called on the thread it belongs to
 
-    PhysicSolver(tp::ThreadPool& tp): sub_steps{1}, thread_pool{tp}
+    PhysicSolver(tp::Executor& tp): sub_steps{1}, thread_pool{tp}
     {
-        for(int i=0;i<MAX_OBJECTS;i++) {
-            no_obj.insert(i);
-        }
     }
 
-    PhysicSolver(tp::ThreadPool& tp, Boundary *bound): sub_steps{1}, thread_pool{tp}
+    PhysicSolver(tp::Executor& tp, Boundary *bound): sub_steps{1}, thread_pool{tp}
     {
-        for(int i=0;i<MAX_OBJECTS;i++) {
-            no_obj.insert(i);
-        }
         boundary.push_back(bound);
     }
 
+    void saveState(SolverState& out) const
+    {
+        out.objects = objects;
+        out.has_obj = has_obj;
+        out.total_points = total_points;
+    }
+
+    // The far group's lag is not part of the state: after a restore it steps on from the
+    // restored positions
+    void loadState(const SolverState& in)
+    {
+        objects = in.objects;
+        has_obj = in.has_obj;
+        total_points = in.total_points;
+        resetLod();
+    }
+
     // Checks if two atoms are colliding and if so create a new contact
     void solveContact(uint32_t atom_1_idx, uint32_t atom_2_idx)
     {
@@ -60,7 +124,10 @@ struct PhysicSolver
         PhysicsObject& obj_2 = objects[atom_2_idx];
 
         if (obj_1.hidden || obj_2.hidden) return;
-        if (!obj_1.dynamic && !obj_2.dynamic) return;
+        // a slot the level of detail froze for this pass is an obstacle that does not move
+        const bool moves_1 = obj_1.dynamic && !frozen[atom_1_idx];
+        const bool moves_2 = obj_2.dynamic && !frozen[atom_2_idx];
+        if (!moves_1 && !moves_2) return;
 
         const glm::vec4 o2_o1 = obj_1.position - obj_2.position;
         const float dist2 = glm::dot(o2_o1, o2_o1);
@@ -73,7 +140,7 @@ struct PhysicSolver
                 glm::vec4 vel_1 = obj_1.position - obj_1.last_position;
                 glm::vec4 vel_2 = obj_2.position - obj_2.last_position;
                 
-                total_points += FruitManager::getFruitProperties(obj_2.fruit).merge_points;
+                total_points += fruitPhysics(obj_2.fruit).merge_points;
                 just_merged++;
                 removeObject(atom_2_idx);
                 obj_1.setPosition((obj_1.position + obj_2.position) / 2.0f);
@@ -89,11 +156,11 @@ struct PhysicSolver
             const float penetration = (combined_radius - dist);// / combined_radius;
 
             if (penetration > 0.0f) {
-                const float w1 = obj_1.dynamic ? obj_1.radius*obj_1.radius*obj_1.radius : 0.0f;
-                const float w2 = obj_2.dynamic ? obj_2.radius*obj_2.radius*obj_2.radius : 0.0f;
+                const float w1 = moves_1 ? obj_1.radius*obj_1.radius*obj_1.radius : 0.0f;
+                const float w2 = moves_2 ? obj_2.radius*obj_2.radius*obj_2.radius : 0.0f;
 
-                obj_1.position += o2_o1 * (RESPONSE_COEF * penetration * w2) / ((w1+w2)*dist);
-                obj_2.position -= o2_o1 * (RESPONSE_COEF * penetration * w1) / ((w1+w2)*dist);
+                obj_1.position += o2_o1 * (params.response_coef * penetration * w2) / ((w1+w2)*dist);
+                obj_2.position -= o2_o1 * (params.response_coef * penetration * w1) / ((w1+w2)*dist);
 
                 // if (obj_1.just_spawned || obj_2.just_spawned){
                 //     obj_1.last_position = obj_1.position;
@@ -103,10 +170,11 @@ struct PhysicSolver
         }
     }
 
-    void solveContactSafe(uint32_t i, uint32_t j)
+    // Returns whether the pair was actually tested
+    bool solveContactSafe(uint32_t i, uint32_t j)
     {
-        if (i == j) return;
-        if (!has_obj[i] || !has_obj[j]) return;
+        if (i == j) return false;
+        if (!has_obj[i] || !has_obj[j] || (frozen[i] && frozen[j])) return false;
 
         // Lock consistently to avoid deadlocks
         uint32_t first = std::min(i, j);
@@ -116,98 +184,240 @@ struct PhysicSolver
         std::scoped_lock lock2(object_locks[second]);
 
         solveContact(i, j); // Your original logic
+        return true;
     }
 
     // Find colliding atoms
     void solveCollisions()
     {
+        PROFILE_SCOPE("PhysicSolver::solveCollisions");
+        if (thread_pool.threadCount() == 1) {
+            thread_pool.dispatch(1, [&](uint32_t, uint32_t) { solveCollisionsSerial(); }, "collisions");
+            return;
+        }
         const uint32_t N = static_cast<uint32_t>(objects.size());
-        const uint32_t thread_count = thread_pool.m_thread_count;
 
-        // Total number of (i,j) pairs where i < j
+        // Total number of (i,j) pairs where i < j; the executor decides how to chunk them
         const uint64_t total_pairs = (static_cast<uint64_t>(N) * (N - 1)) / 2;
-        const uint64_t pairs_per_thread = (total_pairs + thread_count - 1) / thread_count;
 
-        std::atomic<uint64_t> pair_index{0};
+        thread_pool.dispatch(static_cast<uint32_t>(total_pairs), [&](uint32_t start_idx, uint32_t end_idx) {
+            uint32_t tested = 0;
+            for (uint64_t k = start_idx; k < end_idx; ++k) {
+                // Map linear index k to (i, j) using triangular number math
+                uint32_t i = static_cast<uint32_t>(
+                    N - 2 - static_cast<uint32_t>(std::floor(std::sqrt(-8.0 * k + 4.0 * N * (N - 1) - 7) / 2.0 - 0.5))
+                );
+                uint32_t j = static_cast<uint32_t>(k + i + 1 - (static_cast<uint64_t>(N) * (N - 1) / 2 - static_cast<uint64_t>((N - i) * (N - i - 1)) / 2));
 
-        for (uint32_t t = 0; t < thread_count; ++t) {
-            thread_pool.addTask([&, t] {
-                uint64_t start_idx = t * pairs_per_thread;
-                uint64_t end_idx = std::min(start_idx + pairs_per_thread, total_pairs);
-
-                for (uint64_t k = start_idx; k < end_idx; ++k) {
-                    // Map linear index k to (i, j) using triangular number math
-                    uint32_t i = static_cast<uint32_t>(
-                        N - 2 - static_cast<uint32_t>(std::floor(std::sqrt(-8.0 * k + 4.0 * N * (N - 1) - 7) / 2.0 - 0.5))
-                    );
-                    uint32_t j = static_cast<uint32_t>(k + i + 1 - (static_cast<uint64_t>(N) * (N - 1) / 2 - static_cast<uint64_t>((N - i) * (N - i - 1)) / 2));
+                tested += solveContactSafe(i, j) ? 1 : 0;
+            }
+            contact_pairs_tested.fetch_add(tested, std::memory_order_relaxed);
+        }, "collisions");
+    }
 
-                    solveContactSafe(i, j);
-                }
-            });
+    // Single-threaded pass (serial executor, cloned rollout solvers): walks only the
+    // occupied slots, without pair locks, in the same (i, j) order as the triangular
+    // dispatch so that serial results stay bit-identical
+    void solveCollisionsSerial()
+    {
+        std::array<uint32_t,MAX_OBJECTS> occupied;
+        uint32_t count = 0;
+        for (uint32_t i = 0; i < MAX_OBJECTS; ++i) {
+            if (has_obj[i]) occupied[count++] = i;
         }
-
-        thread_pool.waitForCompletion();
+        uint32_t tested = 0;
+        for (uint32_t a = 0; a < count; ++a) {
+            for (uint32_t b = a + 1; b < count; ++b) {
+                const uint32_t i = occupied[a];
+                const uint32_t j = occupied[b];
+                if (!has_obj[i] || !has_obj[j]) continue; // merged away earlier in this pass
+                if (frozen[i] && frozen[j]) continue;
+                solveContact(i, j);
+                ++tested;
+            }
+        }
+        contact_pairs_tested.fetch_add(tested, std::memory_order_relaxed);
     }
 
     // Add a new object to the solver
+    // Called between ticks only; takes the lowest free slot
     void addObject(const PhysicsObject& object)
     {
-        std::lock_guard<std::mutex> lock(no_obj_mutex);
-        if (!no_obj.empty()) {
-            int i = *no_obj.begin();
-            no_obj.erase(no_obj.begin());
+        for (int i = 0; i < MAX_OBJECTS; i++) {
+            if (has_obj[i]) continue;
             objects[i] = object;
             has_obj[i] = true;
+            lod_far[i] = false;
+            step_dt[i] = 0.0f;
+            return;
         }
     }
     
+    // Called with the slot's pair lock held during collisions
     void removeObject(int i)
     {
-        std::lock_guard<std::mutex> lock(no_obj_mutex);
-        // auto it = no_obj.find(i);
-        // if (it != no_obj.end()) {
-        //     no_obj.erase(it);
-        // }
-        no_obj.insert(i);
         objects[i].disable();
         has_obj[i] = false;
+        lod_far[i] = false; // the pass that merged it away never touches the far count
     }
 
     void reset(){
         has_obj.fill(false);
-        for(int i=0;i<MAX_OBJECTS;i++) {
-            no_obj.insert(i);
+    }
+
+    // Removes every fruit and the score, as at the start of a game
+    void clear(){
+        for (int i = 0; i < MAX_OBJECTS; ++i) {
+            if (has_obj[i]) removeObject(i);
         }
+        reset();
+        total_points = 0;
+        resetLod();
+    }
+
+    void resetLod()
+    {
+        lod_far.fill(false);
+        frozen.fill(false);
+        step_dt.fill(0.0f);
+        lod_lag = 0;
+        lod_far_count = 0;
     }
 
     void update(float dt)
     {
+        PROFILE_SCOPE("PhysicSolver::update");
         // Perform the sub steps
         const float sub_dt = dt / static_cast<float>(sub_steps);
 
         just_merged=0;
-
+        contact_pairs_tested=0;
+        for (int i = 0; i < MAX_OBJECTS; ++i) tick_start_position[i] = objects[i].position;
+        boundary_push.fill(0.0f);
+
+        if (backend && backend->update(*this, dt)) return;
+        if ((lod.enabled || lod_far_count) && updateLod(dt)) return;
+        advanced.fill(dt);
+        step_dt.fill(sub_dt);
         for (uint32_t i(sub_steps); i--;) {
             solveCollisions();
             updateBoundary_multi(sub_dt);
         }
     }
 
+    // One tick with the far group split off: the near group steps as usual, the far one
+    // only once it is `interval` ticks behind or one of its fruits has to turn near.
+    // Returns false, having done nothing, when every fruit is near.
+    bool updateLod(float dt)
+    {
+        PROFILE_SCOPE("PhysicSolver::updateLod");
+        std::array<bool,MAX_OBJECTS> want_far{};
+        const bool any_far = lod.enabled && classifyLod(want_far);
+        if (!any_far && lod_far_count == 0) return false;
+
+        advanced.fill(0.0f);
+        bool promote = false;
+        for (int i = 0; i < MAX_OBJECTS; ++i) promote |= has_obj[i] && lod_far[i] && !want_far[i];
+        if (promote) stepFar(dt);
+        // fruits join the far group only while it is level with the present
+        lod_far_count = 0;
+        for (int i = 0; i < MAX_OBJECTS; ++i) {
+            if (!has_obj[i]) continue;
+            if (!want_far[i]) lod_far[i] = false;
+            else if (lod_lag == 0) lod_far[i] = true;
+            lod_far_count += lod_far[i] ? 1 : 0;
+        }
+
+        // empty slots are frozen too: nothing can tell whether they moved
+        for (int i = 0; i < MAX_OBJECTS; ++i) frozen[i] = lod_far[i] || !has_obj[i];
+        stepGroup(dt, sub_steps);
+        frozen.fill(false);
+
+        if (lod_far_count > 0 && ++lod_lag >= lod.interval) stepFar(dt);
+        return true;
+    }
+
+    // Far means: the fruit's 4D sphere stays farther than near_distance from the focus
+    // slice, and it does not touch a fruit that is near. Returns whether any fruit is far.
+    bool classifyLod(std::array<bool,MAX_OBJECTS>& want_far) const
+    {
+        std::array<uint32_t,MAX_OBJECTS> near, far;
+        uint32_t near_count = 0, far_count = 0;
+        for (uint32_t i = 0; i < MAX_OBJECTS; ++i) {
+            const PhysicsObject& obj = objects[i];
+            if (!has_obj[i] || obj.hidden) continue;
+            if (std::abs(obj.position.w - lod.focus_w) > lod.near_distance + obj.radius) far[far_count++] = i;
+            else near[near_count++] = i;
+        }
+        bool any = false;
+        for (uint32_t a = 0; a < far_count; ++a) {
+            const PhysicsObject& obj = objects[far[a]];
+            bool touching = false;
+            for (uint32_t b = 0; b < near_count && !touching; ++b) {
+                const float reach = obj.radius + objects[near[b]].radius + lod.contact_margin;
+                const glm::vec4 d = obj.position - objects[near[b]].position;
+                touching = glm::dot(d, d) < reach * reach;
+            }
+            want_far[far[a]] = !touching;
+            any |= !touching;
+        }
+        return any;
+    }
+
+    // Brings the far group up to the present in substeps no finer than the near ones
+    // and no coarser than lod.max_sub_dt
+    void stepFar(float dt)
+    {
+        if (lod_lag == 0) return;
+        PROFILE_SCOPE("PhysicSolver::stepFar");
+        const float span = dt * static_cast<float>(lod_lag);
+        const uint32_t steps = std::min(sub_steps * lod_lag,
+                                        std::max(1u, static_cast<uint32_t>(std::ceil(span / lod.max_sub_dt - 1e-4f))));
+        for (int i = 0; i < MAX_OBJECTS; ++i) frozen[i] = !lod_far[i];
+        stepGroup(span, steps);
+        frozen.fill(false);
+        lod_lag = 0;
+    }
+
+    // Steps the slots that are not frozen by `span` in `steps` substeps
+    void stepGroup(float span, uint32_t steps)
+    {
+        const float sub_dt = span / static_cast<float>(steps);
+        for (int i = 0; i < MAX_OBJECTS; ++i) {
+            if (frozen[i] || !has_obj[i]) continue;
+            // Verlet keeps velocity as the last displacement: scale it to the new step
+            PhysicsObject& obj = objects[i];
+            if (step_dt[i] > 0.0f && step_dt[i] != sub_dt) {
+                obj.last_position = obj.position - (obj.position - obj.last_position) * (sub_dt / step_dt[i]);
+            }
+            step_dt[i] = sub_dt;
+            advanced[i] += span;
+        }
+        for (uint32_t i(steps); i--;) {
+            solveCollisions();
+            updateBoundary_multi(sub_dt);
+        }
+    }
+
     void updateBoundary_multi(float dt)
     {
+        PROFILE_SCOPE("PhysicSolver::updateBoundary_multi");
         thread_pool.dispatch(static_cast<uint32_t>(objects.size()), [&](uint32_t start, uint32_t end) {
             for (uint32_t i = start; i < end; ++i) {
+                if (frozen[i]) continue;
                 objects[i].acceleration += gravity;
-                objects[i].update(dt);
+                objects[i].update(dt, params);
             }
-        });
+        }, "integrate");
         for (const auto& bound_obj : boundary) {
             thread_pool.dispatch(static_cast<uint32_t>(objects.size()), [&](uint32_t start, uint32_t end) {
                 for (uint32_t i = start; i < end; ++i) {
+                    if (frozen[i]) continue;
+                    const glm::vec4 before = objects[i].position;
                     bound_obj->checkSphere(objects[i]);
+                    boundary_push[i] += glm::length(objects[i].position - before);
                 }
-            });
+            }, "boundary");
         }
     }
 };
@@ -0,0 +1,159 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+
+#include <glm/glm.hpp>
+
+#include "globals.h"
+#include "physics_solver.hpp"
+#include "profiler.hpp"
+
+// Health of the bowl after one solver update. Masses are radius cubed, as the solver
+// weighs contacts, and velocities are taken over the whole update: within a step,
+// last_position still holds the fall that the next collision pass undoes. Fruits the
+// level of detail left out of the update keep the velocity of their last step.
+struct PhysicsStats
+{
+    // A tick past either line is counted as unstable (jitter, or a merge that exploded)
+    static constexpr float UNSTABLE_PENETRATION = 1.0f;  // of the smaller radius: a centre inside its neighbour
+    static constexpr float UNSTABLE_SPEED       = 40.0f; // units per second; drops land at about 15
+
+    uint64_t tick = 0;
+    uint32_t objects = 0;
+    double   kinetic_energy = 0.0;
+    double   potential_energy = 0.0; // gravity, relative to the bowl centre
+    double   mass = 0.0;
+    float    max_speed = 0.0f;        // fastest grown fruit (a merge moves the merged one to the midpoint)
+    float    max_penetration = 0.0f;  // deepest overlap of two different fruits, as a fraction of the smaller radius
+    float    mean_penetration = 0.0f; // over the overlapping pairs
+    uint32_t contacts = 0;            // overlapping pairs
+    float    boundary_correction = 0.0f;     // total distance the bowl pushed fruits back
+    float    max_boundary_correction = 0.0f; // largest push on one fruit
+    uint32_t merges = 0;
+
+    bool unstable() const { return max_penetration > UNSTABLE_PENETRATION || max_speed > UNSTABLE_SPEED; }
+
+    // Folds the partial result of another chunk in (mean_penetration holds the sum until finished)
+    void merge(const PhysicsStats& other)
+    {
+        objects += other.objects;
+        kinetic_energy += other.kinetic_energy;
+        potential_energy += other.potential_energy;
+        mass += other.mass;
+        max_speed = std::max(max_speed, other.max_speed);
+        max_penetration = std::max(max_penetration, other.max_penetration);
+        mean_penetration += other.mean_penetration;
+        contacts += other.contacts;
+        boundary_correction += other.boundary_correction;
+        max_boundary_correction = std::max(max_boundary_correction, other.max_boundary_correction);
+    }
+};
+
+// Reduces the solver after an update on its own executor: every chunk takes a range
+// of slots with their pairs to higher slots and folds its partial result in once.
+// Call between ticks, from the thread that steps the solver.
+inline PhysicsStats measurePhysics(const PhysicSolver& solver)
+{
+    PROFILE_SCOPE("measurePhysics");
+    PhysicsStats total;
+    std::mutex total_mutex;
+    solver.thread_pool.dispatch(MAX_OBJECTS, [&](uint32_t start, uint32_t end) {
+        PhysicsStats part;
+        for (uint32_t i = start; i < end; ++i) {
+            const PhysicsObject& a = solver.objects[i];
+            if (!solver.has_obj[i] || a.hidden) continue;
+            ++part.objects;
+            const float moved = solver.advanced[i];
+            glm::vec4 velocity(0.0f);
+            if (moved > 0.0f) velocity = (a.position - solver.tick_start_position[i]) / moved;
+            else if (solver.step_dt[i] > 0.0f) velocity = (a.position - a.last_position) / solver.step_dt[i];
+            const float speed = glm::length(velocity);
+            const double m = static_cast<double>(a.radius) * a.radius * a.radius;
+            part.kinetic_energy += 0.5 * m * speed * speed;
+            part.potential_energy -= m * glm::dot(solver.gravity, a.position);
+            part.mass += m;
+            if (!a.growing) part.max_speed = std::max(part.max_speed, speed);
+            part.boundary_correction += solver.boundary_push[i];
+            part.max_boundary_correction = std::max(part.max_boundary_correction, solver.boundary_push[i]);
+
+            // same fruits merge on contact, growing ones push into their neighbours by design
+            if (a.growing) continue;
+            for (uint32_t j = i + 1; j < MAX_OBJECTS; ++j) {
+                const PhysicsObject& b = solver.objects[j];
+                if (!solver.has_obj[j] || b.hidden || b.growing || a.fruit == b.fruit) continue;
+                const float overlap = a.radius + b.radius - glm::length(a.position - b.position);
+                if (overlap <= 0.0f) continue;
+                const float depth = overlap / std::min(a.radius, b.radius);
+                part.max_penetration = std::max(part.max_penetration, depth);
+                part.mean_penetration += depth;
+                ++part.contacts;
+            }
+        }
+        std::lock_guard<std::mutex> lock(total_mutex);
+        total.merge(part);
+    }, "stats");
+    if (total.contacts) total.mean_penetration /= static_cast<float>(total.contacts);
+    total.merges = static_cast<uint32_t>(solver.just_merged.load(std::memory_order_relaxed));
+    return total;
+}
+
+// One line per tick: CSV, or JSON Lines when the file name ends in .json or .jsonl
+class PhysicsLog
+{
+public:
+    bool open(const std::string& path)
+    {
+        m_out.open(path);
+        if (!m_out) return false;
+        m_path = path;
+        const size_t dot = path.rfind('.');
+        const std::string ext = dot == std::string::npos ? "" : path.substr(dot);
+        m_json = ext == ".json" || ext == ".jsonl";
+        if (!m_json) {
+            m_out << "tick,objects,kinetic_energy,max_speed,max_penetration,mean_penetration,contacts,"
+                     "boundary_correction,max_boundary_correction,merges,unstable\n";
+        }
+        return true;
+    }
+
+    bool isOpen() const { return m_out.is_open(); }
+
+    void write(const PhysicsStats& s)
+    {
+        if (!m_out.is_open()) return;
+        m_unstable += s.unstable() ? 1 : 0;
+        ++m_ticks;
+        if (m_json) {
+            m_out << "{\"tick\": " << s.tick << ", \"objects\": " << s.objects << ", \"kinetic_energy\": " << s.kinetic_energy
+                  << ", \"max_speed\": " << s.max_speed << ", \"max_penetration\": " << s.max_penetration
+                  << ", \"mean_penetration\": " << s.mean_penetration << ", \"contacts\": " << s.contacts
+                  << ", \"boundary_correction\": " << s.boundary_correction
+                  << ", \"max_boundary_correction\": " << s.max_boundary_correction << ", \"merges\": " << s.merges
+                  << ", \"unstable\": " << (s.unstable() ? "true" : "false") << "}\n";
+        } else {
+            m_out << s.tick << ',' << s.objects << ',' << s.kinetic_energy << ',' << s.max_speed << ',' << s.max_penetration
+                  << ',' << s.mean_penetration << ',' << s.contacts << ',' << s.boundary_correction << ','
+                  << s.max_boundary_correction << ',' << s.merges << ',' << (s.unstable() ? 1 : 0) << '\n';
+        }
+    }
+
+    void close()
+    {
+        if (!m_out.is_open()) return;
+        m_out.close();
+        std::cout << "physics log: " << m_ticks << " ticks (" << m_unstable << " unstable) written to " << m_path << std::endl;
+    }
+
+    ~PhysicsLog() { close(); }
+
+private:
+    std::ofstream m_out;
+    std::string   m_path;
+    bool          m_json = false;
+    uint64_t      m_ticks = 0;
+    uint64_t      m_unstable = 0;
+};
@@ -0,0 +1,252 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace tp
+{
+
+inline uint64_t nowNs()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+struct WorkerStats
+{
+    uint32_t id            = 0;
+    uint64_t tasks_run     = 0;
+    uint64_t busy_ns       = 0;
+    uint64_t idle_ns       = 0;
+    uint64_t steals        = 0;
+    uint64_t queue_wait_ns = 0; // time between addTask and a worker picking the task up
+};
+
+// Written by the owning worker only, read by whoever asks for a snapshot
+struct WorkerCounters
+{
+    std::atomic<uint64_t> tasks_run{0};
+    std::atomic<uint64_t> busy_ns{0};
+    std::atomic<uint64_t> idle_ns{0};
+    std::atomic<uint64_t> steals{0};
+    std::atomic<uint64_t> queue_wait_ns{0};
+
+    void recordTask(uint64_t wait_ns, uint64_t run_ns)
+    {
+        tasks_run.fetch_add(1, std::memory_order_relaxed);
+        queue_wait_ns.fetch_add(wait_ns, std::memory_order_relaxed);
+        busy_ns.fetch_add(run_ns, std::memory_order_relaxed);
+    }
+
+    void recordIdle(uint64_t ns)  { idle_ns.fetch_add(ns, std::memory_order_relaxed); }
+    void recordSteal()            { steals.fetch_add(1, std::memory_order_relaxed); }
+
+    WorkerStats load(uint32_t id) const
+    {
+        WorkerStats out;
+        out.id            = id;
+        out.tasks_run     = tasks_run.load(std::memory_order_relaxed);
+        out.busy_ns       = busy_ns.load(std::memory_order_relaxed);
+        out.idle_ns       = idle_ns.load(std::memory_order_relaxed);
+        out.steals        = steals.load(std::memory_order_relaxed);
+        out.queue_wait_ns = queue_wait_ns.load(std::memory_order_relaxed);
+        return out;
+    }
+
+    void reset()
+    {
+        tasks_run = 0;
+        busy_ns = 0;
+        idle_ns = 0;
+        steals = 0;
+        queue_wait_ns = 0;
+    }
+};
+
+// Bucket 0 holds chunks under 1us, bucket k chunks in [2^(k-1), 2^k) us
+constexpr size_t CHUNK_HISTOGRAM_BUCKETS = 24;
+
+struct DispatchStats
+{
+    std::string label;
+    uint64_t    dispatches     = 0;
+    uint64_t    chunks         = 0;
+    uint64_t    total_wall_ns  = 0;
+    uint64_t    last_wall_ns   = 0;
+    double      last_imbalance = 1.0; // slowest chunk / mean chunk of the last dispatch
+    double      max_imbalance  = 1.0;
+    double      imbalance_sum  = 0.0;
+    std::array<uint64_t, CHUNK_HISTOGRAM_BUCKETS> chunk_histogram{};
+
+    static size_t bucketFor(uint64_t ns)
+    {
+        uint64_t us = ns / 1000;
+        size_t bucket = 0;
+        while (us > 0 && bucket + 1 < CHUNK_HISTOGRAM_BUCKETS) {
+            us >>= 1;
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    void record(const uint64_t* chunk_ns, size_t count, uint64_t wall_ns)
+    {
+        ++dispatches;
+        last_wall_ns = wall_ns;
+        total_wall_ns += wall_ns;
+        if (count == 0) return;
+
+        uint64_t sum = 0, slowest = 0;
+        for (size_t i = 0; i < count; ++i) {
+            sum += chunk_ns[i];
+            slowest = std::max(slowest, chunk_ns[i]);
+            ++chunk_histogram[bucketFor(chunk_ns[i])];
+        }
+        chunks += count;
+        const double mean = static_cast<double>(sum) / static_cast<double>(count);
+        last_imbalance = mean > 0.0 ? static_cast<double>(slowest) / mean : 1.0;
+        max_imbalance = std::max(max_imbalance, last_imbalance);
+        imbalance_sum += last_imbalance;
+    }
+
+    double meanImbalance() const
+    {
+        return dispatches > 0 ? imbalance_sum / static_cast<double>(dispatches) : 1.0;
+    }
+};
+
+struct PoolStats
+{
+    std::string                backend;
+    uint32_t                   thread_count = 0;
+    std::vector<WorkerStats>   workers;
+    std::vector<DispatchStats> dispatches;
+
+    // Fraction of worker time spent running tasks
+    double utilization() const
+    {
+        uint64_t busy = 0, idle = 0;
+        for (const WorkerStats& w : workers) {
+            busy += w.busy_ns;
+            idle += w.idle_ns;
+        }
+        return busy + idle > 0 ? static_cast<double>(busy) / static_cast<double>(busy + idle) : 0.0;
+    }
+
+    std::string format() const
+    {
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(2);
+        ss << backend << " x" << thread_count << "  util " << utilization() * 100.0 << "%\n";
+        for (const WorkerStats& w : workers) {
+            const double wait_us = w.tasks_run ? w.queue_wait_ns / 1000.0 / w.tasks_run : 0.0;
+            ss << " w" << w.id << " tasks " << w.tasks_run
+               << " busy " << w.busy_ns / 1e6 << "ms idle " << w.idle_ns / 1e6 << "ms"
+               << " steals " << w.steals << " wait " << wait_us << "us\n";
+        }
+        for (const DispatchStats& d : dispatches) {
+            const double mean_us = d.dispatches ? d.total_wall_ns / 1000.0 / d.dispatches : 0.0;
+            ss << " " << d.label << " n " << d.dispatches << " avg " << mean_us << "us"
+               << " imbalance " << d.last_imbalance << " (avg " << d.meanImbalance()
+               << ", max " << d.max_imbalance << ")\n";
+        }
+        return ss.str();
+    }
+
+    std::string toJson() const
+    {
+        std::stringstream ss;
+        ss << "{\"backend\":\"" << backend << "\",\"threads\":" << thread_count
+           << ",\"utilization\":" << utilization() << ",\"workers\":[";
+        for (size_t i = 0; i < workers.size(); ++i) {
+            const WorkerStats& w = workers[i];
+            ss << (i ? "," : "") << "{\"id\":" << w.id << ",\"tasks\":" << w.tasks_run
+               << ",\"busy_ns\":" << w.busy_ns << ",\"idle_ns\":" << w.idle_ns
+               << ",\"steals\":" << w.steals << ",\"queue_wait_ns\":" << w.queue_wait_ns << "}";
+        }
+        ss << "],\"dispatches\":[";
+        for (size_t i = 0; i < dispatches.size(); ++i) {
+            const DispatchStats& d = dispatches[i];
+            ss << (i ? "," : "") << "{\"label\":\"" << d.label << "\",\"count\":" << d.dispatches
+               << ",\"chunks\":" << d.chunks << ",\"wall_ns\":" << d.total_wall_ns
+               << ",\"imbalance\":" << d.last_imbalance << ",\"imbalance_mean\":" << d.meanImbalance()
+               << ",\"imbalance_max\":" << d.max_imbalance << ",\"histogram_us_log2\":[";
+            for (size_t b = 0; b < d.chunk_histogram.size(); ++b) {
+                ss << (b ? "," : "") << d.chunk_histogram[b];
+            }
+            ss << "]}";
+        }
+        ss << "]}";
+        return ss.str();
+    }
+};
+
+// Per-label dispatch statistics without locking, for a single recording thread.
+// Labels are expected to be string literals, so they are matched by address first
+// and only compared as strings when the address is new.
+struct DispatchTable
+{
+    std::vector<DispatchStats> m_stats;
+    std::vector<const char*>   m_labels; // address each entry was last recorded with
+
+    void record(const char* label, const uint64_t* chunk_ns, size_t count, uint64_t wall_ns)
+    {
+        for (size_t i = 0; i < m_labels.size(); ++i) {
+            if (m_labels[i] == label) {
+                m_stats[i].record(chunk_ns, count, wall_ns);
+                return;
+            }
+        }
+        for (size_t i = 0; i < m_stats.size(); ++i) {
+            if (m_stats[i].label == label) {
+                m_labels[i] = label;
+                m_stats[i].record(chunk_ns, count, wall_ns);
+                return;
+            }
+        }
+        m_stats.emplace_back();
+        m_stats.back().label = label;
+        m_stats.back().record(chunk_ns, count, wall_ns);
+        m_labels.push_back(label);
+    }
+
+    void reset()
+    {
+        m_stats.clear();
+        m_labels.clear();
+    }
+};
+
+// DispatchTable shared by concurrent dispatchers and readers
+struct DispatchRecorder
+{
+    mutable std::mutex m_mutex;
+    DispatchTable      m_table;
+
+    void record(const char* label, const uint64_t* chunk_ns, size_t count, uint64_t wall_ns)
+    {
+        std::lock_guard<std::mutex> lock_guard{m_mutex};
+        m_table.record(label, chunk_ns, count, wall_ns);
+    }
+
+    std::vector<DispatchStats> snapshot() const
+    {
+        std::lock_guard<std::mutex> lock_guard{m_mutex};
+        return m_table.m_stats;
+    }
+
+    void reset()
+    {
+        std::lock_guard<std::mutex> lock_guard{m_mutex};
+        m_table.reset();
+    }
+};
+
+}
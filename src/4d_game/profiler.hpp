@@ -0,0 +1,185 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Scoped CPU profiler. Zones are recorded into per-thread buffers and exported as
+// Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev). While capture is off
+// a zone costs one relaxed atomic load.
+//
+//   PROFILE_SCOPE("solveCollisions");
+//
+// Zone names must outlive the capture (string literals or labels with static storage).
+namespace prof
+{
+
+struct Event
+{
+    const char* name;
+    uint64_t    start_ns;
+    uint64_t    duration_ns;
+};
+
+struct ThreadBuffer
+{
+    uint32_t           tid = 0;
+    std::string        name;
+    std::mutex         mutex; // only contended while exporting
+    std::vector<Event> events;
+};
+
+// Upper bound per thread so a forgotten capture cannot eat all memory (~24 MB per thread)
+constexpr size_t MAX_EVENTS_PER_THREAD = 1u << 20;
+
+struct Registry
+{
+    std::atomic<bool>                          enabled{false};
+    std::mutex                                 mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    uint32_t                                   next_tid = 1;
+    uint64_t                                   epoch_ns = 0;
+};
+
+inline Registry& registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+inline uint64_t clockNs()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+inline ThreadBuffer& threadBuffer()
+{
+    thread_local std::shared_ptr<ThreadBuffer> buffer = []() {
+        auto created = std::make_shared<ThreadBuffer>();
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        created->tid  = reg.next_tid++;
+        created->name = "thread " + std::to_string(created->tid);
+        reg.buffers.push_back(created);
+        return created;
+    }();
+    return *buffer;
+}
+
+inline bool enabled()
+{
+    return registry().enabled.load(std::memory_order_relaxed);
+}
+
+inline void setThreadName(const std::string& name)
+{
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.name = name;
+}
+
+// Drops previous events and starts recording
+inline void startCapture()
+{
+    Registry& reg = registry();
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (auto& buffer : reg.buffers) {
+            std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+            buffer->events.clear();
+        }
+        reg.epoch_ns = clockNs();
+    }
+    reg.enabled.store(true, std::memory_order_relaxed);
+}
+
+inline void stopCapture()
+{
+    registry().enabled.store(false, std::memory_order_relaxed);
+}
+
+inline void record(const char* name, uint64_t start_ns, uint64_t end_ns)
+{
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    if (buffer.events.size() < MAX_EVENTS_PER_THREAD) {
+        buffer.events.push_back(Event{name, start_ns, end_ns - start_ns});
+    }
+}
+
+// Writes every recorded zone as a complete ("X") event, plus thread name metadata
+inline bool writeChromeTrace(const std::string& path)
+{
+    std::ofstream out(path);
+    if (!out) return false;
+
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    for (auto& buffer : reg.buffers) {
+        std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+        out << (first ? "" : ",\n")
+            << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+            << ",\"args\":{\"name\":\"" << buffer->name << "\"}}";
+        first = false;
+        for (const Event& e : buffer->events) {
+            const uint64_t start = e.start_ns >= reg.epoch_ns ? e.start_ns - reg.epoch_ns : 0;
+            // microseconds with ns precision, as the format expects
+            out << ",\n{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+                << ",\"ts\":" << start / 1000 << "." << (start % 1000) / 100 << (start % 100) / 10 << start % 10
+                << ",\"dur\":" << e.duration_ns / 1000 << "." << (e.duration_ns % 1000) / 100
+                << (e.duration_ns % 100) / 10 << e.duration_ns % 10 << "}";
+        }
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
+
+inline size_t eventCount()
+{
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    size_t count = 0;
+    for (auto& buffer : reg.buffers) {
+        std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+        count += buffer->events.size();
+    }
+    return count;
+}
+
+struct Zone
+{
+    const char* name;
+    uint64_t    start_ns;
+
+    explicit Zone(const char* zone_name)
+        : name(enabled() ? zone_name : nullptr), start_ns(name ? clockNs() : 0)
+    {}
+
+    ~Zone()
+    {
+        end();
+    }
+
+    // Closes the zone early, for sequential phases inside one function
+    void end()
+    {
+        if (name) record(name, start_ns, clockNs());
+        name = nullptr;
+    }
+
+    Zone(const Zone&) = delete;
+    Zone& operator=(const Zone&) = delete;
+};
+
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) prof::Zone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
@@ -0,0 +1,221 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include "game.hpp"
+
+// Offscreen render benchmark: renders a fixed number of frames into an FBO along a
+// scripted camera / w path over seeded fruit layouts, without touching the physics.
+//
+//   4d_game --bench-render 600 [--bench-out results.json] [--bench-dump frames/]
+//           [--bench-size 1280x720]
+//
+// main.cpp creates a hidden window for it; SUIKA_EGL=1 asks GLFW for an EGL context,
+// which together with Mesa llvmpipe works on machines without a GPU or display server.
+struct RenderBenchOptions {
+    int frames = 0;            // 0 disables the benchmark
+    int width = 1280;
+    int height = 720;
+    std::string output_path;   // JSON results
+    std::string dump_dir;      // PPM frames for image diffing
+};
+
+inline bool parseRenderBenchArgs(int argc, char* argv[], RenderBenchOptions& opts) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--bench-render" && i + 1 < argc) opts.frames = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--bench-out" && i + 1 < argc) opts.output_path = argv[++i];
+        else if (arg == "--bench-dump" && i + 1 < argc) opts.dump_dir = argv[++i];
+        else if (arg == "--bench-size" && i + 1 < argc) std::sscanf(argv[++i], "%dx%d", &opts.width, &opts.height);
+    }
+    return opts.frames > 0;
+}
+
+// Small deterministic generator so layouts are identical on every platform and stdlib
+struct BenchRng {
+    uint64_t state;
+    explicit BenchRng(uint64_t seed) : state(seed * 0x9E3779B97F4A7C15ull + 1) {}
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return static_cast<uint32_t>(state >> 32);
+    }
+    float uniform(float lo, float hi) { return lo + (hi - lo) * (next() / 4294967296.0f); }
+};
+
+struct BenchLayout {
+    const char* name;
+    int fruit_count;
+    uint64_t seed;
+};
+
+// Fills the lower half of the bowl with non-overlapping fruits (best effort)
+inline RenderState makeBenchLayout(const BenchLayout& layout, float bowl_radius) {
+    RenderState out;
+    BenchRng rng(layout.seed);
+    int placed = 0;
+    for (int attempt = 0; attempt < layout.fruit_count * 200 && placed < layout.fruit_count && placed < MAX_OBJECTS; ++attempt) {
+        const Fruit fruit = static_cast<Fruit>(rng.next() % 6);
+        const float r = fruitPhysics(fruit).radius;
+        const glm::vec4 p(rng.uniform(-1, 1), rng.uniform(-1, 0), rng.uniform(-1, 1), rng.uniform(-1, 1));
+        if (glm::dot(p, p) > 1.0f) continue;
+        const glm::vec4 position = p * std::max(0.0f, bowl_radius - r);
+        bool overlaps = false;
+        for (int i = 0; i < placed && !overlaps; ++i) {
+            const RenderObject& other = out.objects[i];
+            const glm::vec4 d = other.position - position;
+            overlaps = glm::dot(d, d) < (other.radius + r) * (other.radius + r) * 0.8f;
+        }
+        if (overlaps) continue;
+        RenderObject& obj = out.objects[placed++];
+        obj.position = position;
+        obj.radius = r;
+        obj.fruit = fruit;
+        obj.active = true;
+    }
+    return out;
+}
+
+inline bool writeFramePPM(const std::string& path, int width, int height) {
+    std::vector<unsigned char> pixels(static_cast<size_t>(width) * height * 3);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+    std::ofstream out(path, std::ios::binary);
+    if (!out) return false;
+    out << "P6\n" << width << " " << height << "\n255\n";
+    // GL rows are bottom-up, PPM rows top-down
+    for (int y = height - 1; y >= 0; --y) {
+        out.write(reinterpret_cast<const char*>(&pixels[static_cast<size_t>(y) * width * 3]), width * 3);
+    }
+    return static_cast<bool>(out);
+}
+
+inline float percentile(std::vector<float> values, float p) {
+    if (values.empty()) return 0.0f;
+    std::sort(values.begin(), values.end());
+    const size_t index = std::min(values.size() - 1, static_cast<size_t>(p * (values.size() - 1) + 0.5f));
+    return values[index];
+}
+
+inline int runRenderBenchmark(Game& game, const RenderBenchOptions& opts) {
+    const BenchLayout layouts[] = {
+        {"sparse", 10, 1},
+        {"medium", 40, 2},
+        {"full", MAX_OBJECTS, 3},
+    };
+    const int layout_count = static_cast<int>(sizeof(layouts) / sizeof(layouts[0]));
+    std::vector<RenderState> states;
+    for (const BenchLayout& layout : layouts) states.push_back(makeBenchLayout(layout, game.boundary.radius));
+
+    // Render target: the hidden window's default framebuffer is not guaranteed to exist
+    GLuint fbo = 0, color = 0, depth = 0;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glGenRenderbuffers(1, &color);
+    glBindRenderbuffer(GL_RENDERBUFFER, color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, opts.width, opts.height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+    glGenRenderbuffers(1, &depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, opts.width, opts.height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "render benchmark: framebuffer incomplete" << std::endl;
+        return 1;
+    }
+    glViewport(0, 0, opts.width, opts.height);
+
+    game.State = GAME_ACTIVE;
+    game.Width = game.state.windowWidth = opts.width;
+    game.Height = game.state.windowHeight = opts.height;
+    game.state.m_xpos = -1.0f; // keep the placement preview off the bowl
+    game.state.m_ypos = -1.0f;
+    game.overlay.capture = true;
+
+    std::cout << "render benchmark: " << opts.frames << " frames at " << opts.width << "x" << opts.height
+              << " on " << glGetString(GL_RENDERER) << std::endl;
+
+    std::vector<float> frame_ms;
+    std::vector<std::vector<float>> cpu_phase(PERF_PHASE_COUNT), gpu_phase(PERF_PHASE_COUNT);
+    const int warmup = std::min(10, opts.frames / 10);
+    for (int frame = -warmup; frame < opts.frames; ++frame) {
+        // Scripted path: orbit once, sweep w twice and switch layout every third of the run
+        const float t = frame < 0 ? 0.0f : static_cast<float>(frame) / opts.frames;
+        const int layout = std::min(layout_count - 1, static_cast<int>(t * layout_count));
+        game.frame_state = states[layout];
+        game.state.yaw = t * 2.0f * 3.14159265f;
+        game.state.pitch = glm::radians(-20.0f - 15.0f * std::sin(t * 3.14159265f));
+        game.state.radius = 8.0f + 2.0f * std::sin(t * 6.2831853f);
+        game.state.w = game.state.w_min + (game.state.w_max - game.state.w_min) * (0.5f - 0.5f * std::cos(t * 4.0f * 3.14159265f));
+
+        const auto start = std::chrono::steady_clock::now();
+        game.Render();
+        glFinish(); // count the GPU work of this frame, not of whatever was queued before
+        const float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        game.overlay.PollGpu();
+        if (frame < 0) continue;
+
+        frame_ms.push_back(ms);
+        for (int p = PERF_SKYBOX; p < PERF_PHASE_COUNT; ++p) {
+            cpu_phase[p].push_back(game.overlay.PhaseCpuMs(static_cast<PerfPhase>(p)));
+            gpu_phase[p].push_back(game.overlay.PhaseGpuMs(static_cast<PerfPhase>(p)));
+        }
+        if (!opts.dump_dir.empty()) {
+            char name[64];
+            std::snprintf(name, sizeof(name), "/frame_%05d.ppm", frame);
+            writeFramePPM(opts.dump_dir + name, opts.width, opts.height);
+        }
+    }
+    game.overlay.capture = false;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteRenderbuffers(1, &color);
+    glDeleteRenderbuffers(1, &depth);
+    glDeleteFramebuffers(1, &fbo);
+
+    auto mean = [](const std::vector<float>& v) {
+        double sum = 0.0;
+        for (float x : v) sum += x;
+        return v.empty() ? 0.0f : static_cast<float>(sum / v.size());
+    };
+
+    char line[160];
+    std::snprintf(line, sizeof(line), "frame ms  mean %.3f  p50 %.3f  p90 %.3f  p99 %.3f  max %.3f",
+                  mean(frame_ms), percentile(frame_ms, 0.5f), percentile(frame_ms, 0.9f),
+                  percentile(frame_ms, 0.99f), percentile(frame_ms, 1.0f));
+    std::cout << line << std::endl;
+    for (int p = PERF_SKYBOX; p < PERF_PHASE_COUNT; ++p) {
+        std::snprintf(line, sizeof(line), "  %-8s cpu %.3f ms  gpu %.3f ms  (p99 gpu %.3f)", perfPhaseName(static_cast<PerfPhase>(p)),
+                      mean(cpu_phase[p]), mean(gpu_phase[p]), percentile(gpu_phase[p], 0.99f));
+        std::cout << line << std::endl;
+    }
+
+    if (!opts.output_path.empty()) {
+        std::ofstream out(opts.output_path);
+        out << "{\"renderer\":\"" << glGetString(GL_RENDERER) << "\",\"frames\":" << frame_ms.size()
+            << ",\"width\":" << opts.width << ",\"height\":" << opts.height
+            << ",\"frame_ms\":{\"mean\":" << mean(frame_ms) << ",\"p50\":" << percentile(frame_ms, 0.5f)
+            << ",\"p90\":" << percentile(frame_ms, 0.9f) << ",\"p99\":" << percentile(frame_ms, 0.99f)
+            << ",\"max\":" << percentile(frame_ms, 1.0f) << "},\"passes\":{";
+        for (int p = PERF_SKYBOX; p < PERF_PHASE_COUNT; ++p) {
+            out << (p == PERF_SKYBOX ? "" : ",") << "\"" << perfPhaseName(static_cast<PerfPhase>(p)) << "\":{\"cpu_ms\":"
+                << mean(cpu_phase[p]) << ",\"gpu_ms\":" << mean(gpu_phase[p]) << "}";
+        }
+        out << "}}\n";
+        std::cout << "wrote " << opts.output_path << std::endl;
+    }
+    return 0;
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <random>
@@ -107,6 +108,49 @@ inline unsigned int loadTexture(char const * path)
     return textureID;
 }
 
+// Loads 2D images into the layers of one RGBA texture array of size x size, so a single
+// draw can pick a texture per instance. Images of another size are box filtered (or
+// repeated, when smaller); a file that fails to load leaves its layer transparent.
+inline unsigned int loadTextureArray(const std::vector<std::string>& paths, int size)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, size, size, static_cast<GLsizei>(paths.size()), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    std::vector<unsigned char> layer(static_cast<size_t>(size) * size * 4);
+    for (size_t l = 0; l < paths.size(); ++l) {
+        int width, height, nrComponents;
+        unsigned char *data = stbi_load(paths[l].c_str(), &width, &height, &nrComponents, 4);
+        if (!data) {
+            std::fill(layer.begin(), layer.end(), 0);
+        } else {
+            for (int y = 0; y < size; ++y) {
+                const int y0 = y * height / size, y1 = std::max(y0 + 1, (y + 1) * height / size);
+                for (int x = 0; x < size; ++x) {
+                    const int x0 = x * width / size, x1 = std::max(x0 + 1, (x + 1) * width / size);
+                    unsigned int sum[4] = {0, 0, 0, 0};
+                    for (int sy = y0; sy < y1; ++sy)
+                        for (int sx = x0; sx < x1; ++sx)
+                            for (int c = 0; c < 4; ++c) sum[c] += data[(static_cast<size_t>(sy) * width + sx) * 4 + c];
+                    const unsigned int n = static_cast<unsigned int>((y1 - y0) * (x1 - x0));
+                    for (int c = 0; c < 4; ++c) layer[(static_cast<size_t>(y) * size + x) * 4 + c] = static_cast<unsigned char>(sum[c] / n);
+                }
+            }
+        }
+        stbi_image_free(data);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, static_cast<GLint>(l), size, size, 1, GL_RGBA, GL_UNSIGNED_BYTE, layer.data());
+    }
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    return textureID;
+}
+
 inline void renderCube()
 {
     unsigned int cubeVAO = 0;
@@ -0,0 +1,403 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "globals.h"
+#include "fruit_data.hpp"
+#include "physics_object.hpp"
+#include "physics_solver.hpp"
+#include "physics_stats.hpp"
+#include "hemisphere_boundary.hpp"
+#include "rewind.hpp"
+#include "executor_factory.hpp"
+
+// Replay files (.s4dr) log every gameplay input against the physics tick it was
+// applied on, so a session can be stepped again through the solver without a window.
+//
+//   header   "S4DR" u16 version, u16 reserved, f32 timestep, u32 substeps, u64 fruit seed,
+//            f32 bowl radius, f32 bowl angle (degrees), f32 bowl margin
+//   events   varint tick delta, u8 type, payload
+//              DROP     f32 x y z w, u8 fruit  (w is the slice the player dropped on)
+//              RESET    -
+//              SUBSTEPS u8 count               (no longer written; still read)
+//              REWIND   u32 snapshots          (already clamped to the history)
+//              END      i32 points, u64 state checksum
+//
+// All values are little endian. Ticks only count while the game is being played.
+
+enum class ReplayEventType : uint8_t {
+    End      = 0,
+    Drop     = 1,
+    Reset    = 2,
+    SubSteps = 3,
+    Rewind   = 4,
+};
+
+struct ReplayEvent {
+    uint64_t        tick = 0;
+    ReplayEventType type = ReplayEventType::End;
+    glm::vec4       position = glm::vec4(0.0f);
+    Fruit           fruit = CHERRY;
+    uint32_t        sub_steps = 1;
+    uint32_t        rewind_steps = 0;
+};
+
+struct ReplayHeader {
+    static constexpr uint16_t VERSION = 1;
+
+    float    timestep = PHYSICS_TIMESTEP;
+    uint32_t sub_steps = 1;
+    uint64_t seed = 0;
+    float    bowl_radius = 3.0f;
+    float    bowl_angle = 90.0f;
+    float    bowl_margin = 0.1f;
+};
+
+struct Replay {
+    ReplayHeader             header;
+    std::vector<ReplayEvent> events;
+    uint64_t                 end_tick = 0;
+    int                      points = 0;
+    uint64_t                 checksum = 0;
+};
+
+// FNV-1a over the occupied slots, bit exact: any divergence in the solver shows up
+inline uint64_t solverChecksum(const PhysicSolver& solver) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    auto mix = [&hash](const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ull;
+        }
+    };
+    for (int i = 0; i < MAX_OBJECTS; i++) {
+        if (!solver.has_obj[i]) continue;
+        const PhysicsObject& obj = solver.objects[i];
+        const int32_t slot = i;
+        const int32_t fruit = obj.fruit;
+        mix(&slot, sizeof(slot));
+        mix(&fruit, sizeof(fruit));
+        mix(&obj.position, sizeof(obj.position));
+        mix(&obj.last_position, sizeof(obj.last_position));
+    }
+    const int32_t points = solver.total_points;
+    mix(&points, sizeof(points));
+    return hash;
+}
+
+// Appends events as they happen; the owner makes sure calls come from one thread at a time
+class ReplayRecorder {
+public:
+    explicit ReplayRecorder(const ReplayHeader& header) : m_header(header) {}
+
+    void drop(uint64_t tick, const PhysicsObject& object) {
+        event(tick, ReplayEventType::Drop);
+        putFloat(object.position.x);
+        putFloat(object.position.y);
+        putFloat(object.position.z);
+        putFloat(object.position.w);
+        m_data.push_back(static_cast<uint8_t>(object.fruit));
+    }
+
+    void reset(uint64_t tick) {
+        event(tick, ReplayEventType::Reset);
+    }
+
+    void rewind(uint64_t tick, uint32_t steps) {
+        event(tick, ReplayEventType::Rewind);
+        putU32(steps);
+    }
+
+    void finish(uint64_t tick, int points, uint64_t checksum) {
+        if (m_finished) return;
+        event(tick, ReplayEventType::End);
+        putU32(static_cast<uint32_t>(points));
+        putU64(checksum);
+        m_finished = true;
+    }
+
+    bool save(const std::string& path) const {
+        std::vector<uint8_t> header;
+        header.insert(header.end(), {'S', '4', 'D', 'R'});
+        appendU16(header, ReplayHeader::VERSION);
+        appendU16(header, 0);
+        appendFloat(header, m_header.timestep);
+        appendU32(header, m_header.sub_steps);
+        appendU64(header, m_header.seed);
+        appendFloat(header, m_header.bowl_radius);
+        appendFloat(header, m_header.bowl_angle);
+        appendFloat(header, m_header.bowl_margin);
+
+        std::ofstream out(path, std::ios::binary);
+        if (!out) return false;
+        out.write(reinterpret_cast<const char*>(header.data()), header.size());
+        out.write(reinterpret_cast<const char*>(m_data.data()), m_data.size());
+        return static_cast<bool>(out);
+    }
+
+    size_t bytes() const { return m_data.size(); }
+
+    static void appendU16(std::vector<uint8_t>& out, uint16_t v) {
+        for (int i = 0; i < 2; i++) out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+    static void appendU32(std::vector<uint8_t>& out, uint32_t v) {
+        for (int i = 0; i < 4; i++) out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+    static void appendU64(std::vector<uint8_t>& out, uint64_t v) {
+        for (int i = 0; i < 8; i++) out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+    static void appendFloat(std::vector<uint8_t>& out, float v) {
+        uint32_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        appendU32(out, bits);
+    }
+
+private:
+    void event(uint64_t tick, ReplayEventType type) {
+        uint64_t delta = tick - m_last_tick;
+        m_last_tick = tick;
+        // LEB128 varint: a tick delta below 128 costs one byte
+        do {
+            uint8_t byte = delta & 0x7f;
+            delta >>= 7;
+            m_data.push_back(static_cast<uint8_t>(byte | (delta ? 0x80 : 0)));
+        } while (delta);
+        m_data.push_back(static_cast<uint8_t>(type));
+    }
+
+    void putU32(uint32_t v) { appendU32(m_data, v); }
+    void putU64(uint64_t v) { appendU64(m_data, v); }
+    void putFloat(float v) { appendFloat(m_data, v); }
+
+    ReplayHeader         m_header;
+    std::vector<uint8_t> m_data;
+    uint64_t             m_last_tick = 0;
+    bool                 m_finished = false;
+};
+
+class ReplayReader {
+public:
+    explicit ReplayReader(std::vector<uint8_t> data) : m_data(std::move(data)) {}
+
+    bool read(Replay& replay, std::string& error) {
+        if (m_data.size() < 36 || std::memcmp(m_data.data(), "S4DR", 4) != 0) {
+            error = "not a replay file";
+            return false;
+        }
+        m_pos = 4;
+        const uint16_t version = u16();
+        u16();
+        if (version != ReplayHeader::VERSION) {
+            error = "unsupported replay version " + std::to_string(version);
+            return false;
+        }
+        replay.header.timestep = f32();
+        replay.header.sub_steps = u32();
+        replay.header.seed = u64();
+        replay.header.bowl_radius = f32();
+        replay.header.bowl_angle = f32();
+        replay.header.bowl_margin = f32();
+
+        uint64_t tick = 0;
+        while (m_pos < m_data.size()) {
+            ReplayEvent e;
+            tick += varint();
+            e.tick = tick;
+            e.type = static_cast<ReplayEventType>(u8());
+            switch (e.type) {
+                case ReplayEventType::Drop:
+                    e.position.x = f32();
+                    e.position.y = f32();
+                    e.position.z = f32();
+                    e.position.w = f32();
+                    e.fruit = static_cast<Fruit>(u8());
+                    if (e.fruit >= FRUIT_COUNT) m_overrun = true;
+                    break;
+                case ReplayEventType::SubSteps:
+                    e.sub_steps = u8();
+                    break;
+                case ReplayEventType::Rewind:
+                    e.rewind_steps = u32();
+                    break;
+                case ReplayEventType::Reset:
+                    break;
+                case ReplayEventType::End:
+                    replay.end_tick = tick;
+                    replay.points = static_cast<int32_t>(u32());
+                    replay.checksum = u64();
+                    return finish(error);
+                default:
+                    error = "unknown event type " + std::to_string(static_cast<int>(e.type));
+                    return false;
+            }
+            if (m_overrun) break;
+            replay.events.push_back(e);
+        }
+        if (m_overrun) {
+            error = "corrupt replay";
+            return false;
+        }
+        // a session that crashed before writing END still replays up to its last input
+        replay.end_tick = tick;
+        error = "replay has no end marker";
+        return true;
+    }
+
+private:
+    bool finish(std::string& error) {
+        if (m_overrun) error = "corrupt replay";
+        return !m_overrun;
+    }
+
+    uint8_t u8() {
+        if (m_pos >= m_data.size()) {
+            m_overrun = true;
+            return 0;
+        }
+        return m_data[m_pos++];
+    }
+    uint16_t u16() { return static_cast<uint16_t>(u8() | (u8() << 8)); }
+    uint32_t u32() {
+        uint32_t v = 0;
+        for (int i = 0; i < 4; i++) v |= static_cast<uint32_t>(u8()) << (8 * i);
+        return v;
+    }
+    uint64_t u64() {
+        uint64_t v = 0;
+        for (int i = 0; i < 8; i++) v |= static_cast<uint64_t>(u8()) << (8 * i);
+        return v;
+    }
+    float f32() {
+        const uint32_t bits = u32();
+        float v;
+        std::memcpy(&v, &bits, sizeof(v));
+        return v;
+    }
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const uint8_t byte = u8();
+            v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return v;
+        }
+        m_overrun = true;
+        return 0;
+    }
+
+    std::vector<uint8_t> m_data;
+    size_t               m_pos = 0;
+    bool                 m_overrun = false;
+};
+
+inline bool loadReplay(const std::string& path, Replay& replay, std::string& error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return ReplayReader(std::move(data)).read(replay, error);
+}
+
+struct ReplayResult {
+    uint64_t ticks = 0;
+    uint64_t drops = 0;
+    double   seconds = 0.0;
+    int      points = 0;
+    uint64_t checksum = 0;
+};
+
+// Steps the replay through a fresh solver as fast as possible, nothing is rendered.
+// With a log, the health of every tick is measured and written too.
+inline ReplayResult playReplay(const Replay& replay, tp::Executor& executor, PhysicsLog* log = nullptr) {
+    HemisphereBoundary boundary(glm::vec4(0.0f), replay.header.bowl_radius, replay.header.bowl_angle, replay.header.bowl_margin);
+    PhysicSolver solver(executor, &boundary);
+    solver.sub_steps = replay.header.sub_steps;
+    // rewinds restore quantized snapshots, so playback keeps the same history
+    SnapshotRing history(rewindCapacity(replay.header.timestep));
+    SolverState snapshot;
+
+    ReplayResult result;
+    const auto start = std::chrono::steady_clock::now();
+    size_t next = 0;
+    for (uint64_t tick = 0; tick < replay.end_tick; ++tick) {
+        for (; next < replay.events.size() && replay.events[next].tick == tick; ++next) {
+            const ReplayEvent& e = replay.events[next];
+            switch (e.type) {
+                case ReplayEventType::Drop:
+                    solver.addObject(PhysicsObject(e.position, e.fruit, true, false));
+                    ++result.drops;
+                    break;
+                case ReplayEventType::Reset:
+                    solver.clear();
+                    history.clear();
+                    break;
+                case ReplayEventType::SubSteps:
+                    solver.sub_steps = e.sub_steps;
+                    break;
+                case ReplayEventType::Rewind:
+                    if (history.rewind(e.rewind_steps, snapshot)) solver.loadState(snapshot);
+                    break;
+                case ReplayEventType::End:
+                    break;
+            }
+        }
+        solver.update(replay.header.timestep);
+        if (log) {
+            PhysicsStats stats = measurePhysics(solver);
+            stats.tick = tick + 1;
+            log->write(stats);
+        }
+        solver.saveState(snapshot);
+        history.capture(snapshot);
+        ++result.ticks;
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.points = solver.total_points;
+    result.checksum = solverChecksum(solver);
+    return result;
+}
+
+// 4d_game --replay <file>: headless playback, prints throughput and whether the final
+// state matches the recording. Runs on the serial executor unless SUIKA_EXECUTOR says
+// otherwise; only serial stepping is bit-reproducible, which is why the game also records
+// on the serial executor (Game::StartRecording). A physics log path (--physics-log
+// before --replay) writes the per-tick health of the playback.
+inline int runReplayFile(const std::string& path, const std::string& physics_log_path = "") {
+    Replay replay;
+    std::string error;
+    if (!loadReplay(path, replay, error)) {
+        std::cerr << "replay: " << error << std::endl;
+        return 1;
+    }
+    if (!error.empty()) std::cerr << "replay: " << error << ", playing " << replay.end_tick << " ticks" << std::endl;
+
+    const tp::PoolConfig config = tp::PoolConfig::fromEnvironment("serial");
+    std::unique_ptr<tp::Executor> executor = tp::makeExecutor(config.backend, tp::planPlacement(tp::CpuTopology::discover(), config));
+
+    PhysicsLog log;
+    if (!physics_log_path.empty() && !log.open(physics_log_path)) {
+        std::cerr << "replay: cannot write " << physics_log_path << std::endl;
+        return 1;
+    }
+    const ReplayResult result = playReplay(replay, *executor, log.isOpen() ? &log : nullptr);
+    log.close();
+    std::cout << "replayed " << result.ticks << " ticks (" << result.drops << " drops) in " << result.seconds * 1000.0
+              << " ms on " << executor->name() << ", " << (result.seconds > 0.0 ? result.ticks / result.seconds : 0.0)
+              << " ticks/s" << std::endl;
+    std::cout << "points " << result.points << ", checksum " << std::hex << result.checksum << std::dec << std::endl;
+    if (!error.empty()) return 0;
+    const bool match = result.points == replay.points && result.checksum == replay.checksum;
+    std::cout << (match ? "final state matches the recording" : "final state differs from the recording (recorded points "
+                  + std::to_string(replay.points) + ")") << std::endl;
+    return match ? 0 : 2;
+}
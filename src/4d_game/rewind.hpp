@@ -0,0 +1,228 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "globals.h"
+#include "physics_solver.hpp"
+
+const float REWIND_HISTORY_SECONDS = 5.0f; // how far back the ring reaches
+const float REWIND_STEP_SECONDS = 3.0f;    // how far one rewind goes
+
+inline uint32_t rewindCapacity(float timestep)
+{
+    return static_cast<uint32_t>(std::ceil(REWIND_HISTORY_SECONDS / timestep));
+}
+
+// Ring of solver snapshots, one per tick, for rewinding the bowl. Each snapshot is
+// quantized to fixed point and stored as varint deltas against the previous one,
+// with a full keyframe every KEYFRAME_INTERVAL ticks to decode from. A bowl at rest
+// costs about a dozen bytes per fruit and tick; five seconds of a full bowl stay
+// well under a megabyte. Restoring quantizes positions to 1/16384 of a unit.
+class SnapshotRing
+{
+public:
+    static constexpr uint32_t KEYFRAME_INTERVAL = 60;
+    static constexpr float    SCALE = 16384.0f;
+    static constexpr int      VALUES = 10; // position xyzw, last position xyzw, radius, target radius
+
+    explicit SnapshotRing(uint32_t capacity)
+        : m_entries(capacity + KEYFRAME_INTERVAL) // room for a whole keyframe group on top
+    {}
+
+    void clear()
+    {
+        m_head = 0;
+        m_count = 0;
+        m_since_key = 0;
+    }
+
+    // Snapshots available to rewind to (including the newest)
+    uint32_t size() const { return m_count; }
+
+    size_t bytes() const
+    {
+        size_t total = 0;
+        for (uint32_t k = 0; k < m_count; k++) total += entry(k).data.size();
+        return total;
+    }
+
+    void capture(const SolverState& state)
+    {
+        if (m_count == m_entries.size()) evictGroup();
+        const bool key = m_count == 0 || m_since_key >= KEYFRAME_INTERVAL;
+        Entry& e = m_entries[(m_head + m_count) % m_entries.size()];
+        ++m_count;
+        e.key = key;
+        e.data.clear(); // keeps its capacity, so steady state capture does not allocate
+
+        Quantized q;
+        quantize(state, q);
+        encode(q, key ? nullptr : &m_last, e.data);
+        m_last = q;
+        m_since_key = key ? 1 : m_since_key + 1;
+    }
+
+    // How many snapshots a rewind by `steps` can actually go back
+    uint32_t reachable(uint32_t steps) const { return m_count == 0 ? 0 : std::min(steps, m_count - 1); }
+
+    // Goes back `steps` snapshots (clamped to the oldest), drops everything newer and
+    // returns the state to continue from. False when the ring is empty.
+    bool rewind(uint32_t steps, SolverState& out)
+    {
+        if (m_count == 0) return false;
+        const uint32_t target = m_count - 1 - reachable(steps);
+        uint32_t key = target;
+        while (!entry(key).key) --key; // the oldest entry is always a keyframe
+
+        Quantized q;
+        for (uint32_t k = key; k <= target; k++) {
+            decode(entry(k).data, k == key ? nullptr : &q, q);
+        }
+        dequantize(q, out);
+
+        m_count = target + 1;
+        m_last = q;
+        m_since_key = target - key + 1;
+        return true;
+    }
+
+private:
+    struct Entry
+    {
+        bool                 key = false;
+        std::vector<uint8_t> data;
+    };
+
+    struct Quantized
+    {
+        int32_t value[MAX_OBJECTS][VALUES];
+        uint8_t flags[MAX_OBJECTS]; // bit 0 present, 1 dynamic, 2 hidden, 3 growing
+        uint8_t fruit[MAX_OBJECTS];
+        int32_t points;
+    };
+
+    Entry& entry(uint32_t k) { return m_entries[(m_head + k) % m_entries.size()]; }
+    const Entry& entry(uint32_t k) const { return m_entries[(m_head + k) % m_entries.size()]; }
+
+    // Drops the oldest keyframe and the deltas that depend on it
+    void evictGroup()
+    {
+        do {
+            m_head = (m_head + 1) % m_entries.size();
+            --m_count;
+        } while (m_count > 0 && !entry(0).key);
+    }
+
+    static int32_t fixed(float v) { return static_cast<int32_t>(std::lround(v * SCALE)); }
+
+    static void quantize(const SolverState& state, Quantized& q)
+    {
+        for (int i = 0; i < MAX_OBJECTS; i++) {
+            const PhysicsObject& obj = state.objects[i];
+            if (!state.has_obj[i]) {
+                q.flags[i] = 0;
+                q.fruit[i] = 0;
+                std::memset(q.value[i], 0, sizeof(q.value[i]));
+                continue;
+            }
+            q.flags[i] = static_cast<uint8_t>(1 | (obj.dynamic ? 2 : 0) | (obj.hidden ? 4 : 0) | (obj.growing ? 8 : 0));
+            q.fruit[i] = static_cast<uint8_t>(obj.fruit);
+            int32_t* v = q.value[i];
+            for (int c = 0; c < 4; c++) {
+                v[c] = fixed(obj.position[c]);
+                v[4 + c] = fixed(obj.last_position[c]);
+            }
+            v[8] = fixed(obj.radius);
+            v[9] = fixed(obj.target_radius);
+        }
+        q.points = state.total_points;
+    }
+
+    static void dequantize(const Quantized& q, SolverState& state)
+    {
+        for (int i = 0; i < MAX_OBJECTS; i++) {
+            state.has_obj[i] = (q.flags[i] & 1) != 0;
+            PhysicsObject& obj = state.objects[i];
+            obj.acceleration = glm::vec4(0.0f);
+            if (!state.has_obj[i]) {
+                obj.hidden = true;
+                continue;
+            }
+            const int32_t* v = q.value[i];
+            for (int c = 0; c < 4; c++) {
+                obj.position[c] = v[c] / SCALE;
+                obj.last_position[c] = v[4 + c] / SCALE;
+            }
+            obj.radius = v[8] / SCALE;
+            obj.target_radius = v[9] / SCALE;
+            obj.dynamic = (q.flags[i] & 2) != 0;
+            obj.hidden = (q.flags[i] & 4) != 0;
+            obj.growing = (q.flags[i] & 8) != 0;
+            obj.fruit = static_cast<Fruit>(q.fruit[i]);
+        }
+        state.total_points = q.points;
+    }
+
+    // Zigzag varints of the difference to the base (or to zero for keyframes)
+    static void putVarint(std::vector<uint8_t>& out, int32_t delta)
+    {
+        uint32_t z = (static_cast<uint32_t>(delta) << 1) ^ static_cast<uint32_t>(delta >> 31);
+        while (z >= 0x80) {
+            out.push_back(static_cast<uint8_t>(z | 0x80));
+            z >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(z));
+    }
+
+    static int32_t getVarint(const uint8_t*& p)
+    {
+        uint32_t z = 0;
+        for (int shift = 0;; shift += 7) {
+            const uint8_t byte = *p++;
+            z |= static_cast<uint32_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) break;
+        }
+        return static_cast<int32_t>((z >> 1) ^ (0u - (z & 1)));
+    }
+
+    static void encode(const Quantized& q, const Quantized* base, std::vector<uint8_t>& out)
+    {
+        for (int i = 0; i < MAX_OBJECTS; i++) {
+            out.push_back(q.flags[i]);
+            if (!(q.flags[i] & 1)) continue;
+            out.push_back(q.fruit[i]);
+            for (int c = 0; c < VALUES; c++) {
+                putVarint(out, q.value[i][c] - (base ? base->value[i][c] : 0));
+            }
+        }
+        putVarint(out, q.points - (base ? base->points : 0));
+    }
+
+    // base may alias out: every value is read before it is overwritten
+    static void decode(const std::vector<uint8_t>& data, const Quantized* base, Quantized& out)
+    {
+        const uint8_t* p = data.data();
+        for (int i = 0; i < MAX_OBJECTS; i++) {
+            out.flags[i] = *p++;
+            if (!(out.flags[i] & 1)) {
+                out.fruit[i] = 0;
+                std::memset(out.value[i], 0, sizeof(out.value[i]));
+                continue;
+            }
+            out.fruit[i] = *p++;
+            for (int c = 0; c < VALUES; c++) {
+                out.value[i][c] = (base ? base->value[i][c] : 0) + getVarint(p);
+            }
+        }
+        out.points = (base ? base->points : 0) + getVarint(p);
+    }
+
+    std::vector<Entry> m_entries;
+    uint32_t           m_head = 0;
+    uint32_t           m_count = 0;
+    uint32_t           m_since_key = 0;
+    Quantized          m_last; // quantized newest snapshot, base of the next delta
+};
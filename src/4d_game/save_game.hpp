@@ -0,0 +1,314 @@
+#pragma once
+#include <cfloat>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <io.h>
+#elif !defined(__EMSCRIPTEN__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <glm/glm.hpp>
+
+#include "globals.h"
+#include "fruit_data.hpp"
+#include "physics_solver.hpp"
+
+// Save-game format (.s4ds). Little-endian, fixed-size records, so loading is a map of
+// the file plus a header check; records are read in place, nothing is parsed field by
+// field. The layout is the in-memory layout of the structs below:
+//
+//   SaveHeader                         (header_size bytes)
+//   SaveObject[object_count]           (at objects_offset, 16-byte aligned)
+//
+// The object count is not limited to one bowl, so larger arenas use the same format.
+// Files are written to a temporary name and renamed over the old save, so a crash
+// mid-write never leaves a truncated save behind.
+
+const char     SAVE_MAGIC[4] = {'S', '4', 'D', 'S'};
+const uint32_t SAVE_VERSION = 1;
+const uint32_t SAVE_BYTE_ORDER = 0x01020304; // reads back swapped on a big-endian host
+
+// Camera and w slice, the part of ViewState worth resuming
+struct SaveView
+{
+    float w;
+    float yaw;
+    float pitch;
+    float radius;
+};
+
+struct SaveHeader
+{
+    char     magic[4];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t header_size;
+    uint32_t object_size;
+    uint32_t object_count;
+    uint64_t objects_offset;
+    uint64_t checksum;    // over the object records
+    uint64_t rng_state;   // fruit sequence (Pcg32) to continue from
+    uint64_t rng_inc;
+    int32_t  total_points;
+    int32_t  high_score;
+    uint32_t next_fruit;
+    uint32_t sub_steps;
+    float    timestep;
+    SaveView view;
+    uint32_t reserved[5];
+};
+
+struct SaveObject
+{
+    float    position[4];
+    float    last_position[4];
+    float    radius;
+    float    target_radius;
+    uint32_t slot;
+    uint8_t  fruit;
+    uint8_t  flags; // 2 dynamic, 4 hidden, 8 growing (BatchSolver's bits)
+    uint8_t  pad[2];
+};
+
+static_assert(sizeof(SaveHeader) == 112, "SaveHeader layout is part of the file format");
+static_assert(sizeof(SaveObject) == 48, "SaveObject layout is part of the file format");
+static_assert(std::is_trivially_copyable<SaveHeader>::value && std::is_trivially_copyable<SaveObject>::value,
+              "save records are written and mapped as raw bytes");
+
+// 64-bit words at a time: a 100k-fruit save hashes in about a millisecond
+inline uint64_t saveChecksum(const void* data, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = 0xcbf29ce484222325ull;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, 8);
+        hash = (hash ^ word) * 0x100000001b3ull;
+        hash ^= hash >> 29;
+    }
+    for (; i < size; ++i) hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    return hash;
+}
+
+inline SaveHeader makeSaveHeader()
+{
+    SaveHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SAVE_MAGIC, sizeof(header.magic));
+    header.version = SAVE_VERSION;
+    header.byte_order = SAVE_BYTE_ORDER;
+    header.header_size = sizeof(SaveHeader);
+    header.object_size = sizeof(SaveObject);
+    header.objects_offset = (sizeof(SaveHeader) + 15) & ~uint64_t(15);
+    return header;
+}
+
+// The occupied slots of a solver as save records
+inline void packSaveObjects(const SolverState& state, std::vector<SaveObject>& out)
+{
+    out.clear();
+    for (int i = 0; i < MAX_OBJECTS; i++) {
+        if (!state.has_obj[i]) continue;
+        const PhysicsObject& obj = state.objects[i];
+        SaveObject record;
+        std::memset(&record, 0, sizeof(record));
+        for (int c = 0; c < 4; c++) {
+            record.position[c] = obj.position[c];
+            record.last_position[c] = obj.last_position[c];
+        }
+        record.radius = obj.radius;
+        record.target_radius = obj.target_radius;
+        record.slot = static_cast<uint32_t>(i);
+        record.fruit = static_cast<uint8_t>(obj.fruit);
+        record.flags = static_cast<uint8_t>((obj.dynamic ? 2 : 0) | (obj.hidden ? 4 : 0) | (obj.growing ? 8 : 0));
+        out.push_back(record);
+    }
+}
+
+// Records back into a solver state; slots beyond the solver's capacity are dropped
+inline void unpackSaveObjects(const SaveObject* records, uint32_t count, SolverState& state)
+{
+    state.has_obj.fill(false);
+    for (uint32_t n = 0; n < count; ++n) {
+        const SaveObject& record = records[n];
+        if (record.slot >= MAX_OBJECTS || record.fruit >= FRUIT_COUNT) continue;
+        PhysicsObject& obj = state.objects[record.slot];
+        obj.position = glm::vec4(record.position[0], record.position[1], record.position[2], record.position[3]);
+        obj.last_position = glm::vec4(record.last_position[0], record.last_position[1], record.last_position[2], record.last_position[3]);
+        obj.acceleration = glm::vec4(0.0f);
+        obj.radius = record.radius;
+        obj.target_radius = record.target_radius;
+        obj.fruit = static_cast<Fruit>(record.fruit);
+        obj.dynamic = (record.flags & 2) != 0;
+        obj.hidden = (record.flags & 4) != 0;
+        obj.growing = (record.flags & 8) != 0;
+        state.has_obj[record.slot] = true;
+    }
+}
+
+// Writes header and records to `path` atomically: temporary file, flush to disk, rename
+inline bool writeSaveFile(const std::string& path, SaveHeader header, const SaveObject* objects, uint32_t count, std::string& error)
+{
+    header.object_count = count;
+    header.checksum = saveChecksum(objects, static_cast<size_t>(count) * sizeof(SaveObject));
+    const std::string tmp = path + ".tmp";
+    FILE* file = std::fopen(tmp.c_str(), "wb");
+    if (!file) {
+        error = "cannot create " + tmp;
+        return false;
+    }
+    static const char zeros[16] = {};
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && std::fwrite(zeros, 1, header.objects_offset - sizeof(header), file) == header.objects_offset - sizeof(header);
+    ok = ok && (count == 0 || std::fwrite(objects, sizeof(SaveObject), count, file) == count);
+    ok = ok && std::fflush(file) == 0;
+#if defined(_WIN32)
+    ok = ok && FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file))));
+#elif !defined(__EMSCRIPTEN__)
+    ok = ok && fsync(fileno(file)) == 0;
+#endif
+    ok = (std::fclose(file) == 0) && ok;
+    if (!ok) {
+        std::remove(tmp.c_str());
+        error = "cannot write " + tmp;
+        return false;
+    }
+#if defined(_WIN32)
+    ok = MoveFileExA(tmp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    ok = std::rename(tmp.c_str(), path.c_str()) == 0;
+#endif
+    if (!ok) {
+        std::remove(tmp.c_str());
+        error = "cannot replace " + path;
+    }
+    return ok;
+}
+
+// Read-only view of a save file: mapped where the platform allows, read into memory otherwise
+class SaveFile
+{
+public:
+    SaveFile() = default;
+    SaveFile(const SaveFile&) = delete;
+    SaveFile& operator=(const SaveFile&) = delete;
+    ~SaveFile() { close(); }
+
+    // Maps the file and checks header, sizes and checksum. Records are not touched
+    // beyond the checksum pass.
+    bool open(const std::string& path, std::string& error)
+    {
+        close();
+        if (!map(path, error)) return false;
+        if (m_size < sizeof(SaveHeader)) return fail("not a save file (too short)", error);
+        const SaveHeader& h = header();
+        if (std::memcmp(h.magic, SAVE_MAGIC, sizeof(h.magic)) != 0) return fail("not a save file", error);
+        if (h.byte_order != SAVE_BYTE_ORDER) return fail("save file byte order does not match this machine", error);
+        if (h.version != SAVE_VERSION) return fail("unsupported save version " + std::to_string(h.version), error);
+        if (h.header_size < sizeof(SaveHeader) || h.object_size != sizeof(SaveObject) || h.objects_offset % 16 != 0) {
+            return fail("save file layout does not match this build", error);
+        }
+        const uint64_t bytes = static_cast<uint64_t>(h.object_count) * sizeof(SaveObject);
+        if (h.objects_offset > m_size || bytes > m_size - h.objects_offset) return fail("save file is truncated", error);
+        if (saveChecksum(objects(), bytes) != h.checksum) return fail("save file is corrupted (checksum)", error);
+        return true;
+    }
+
+    const SaveHeader& header() const { return *reinterpret_cast<const SaveHeader*>(m_data); }
+    const SaveObject* objects() const { return reinterpret_cast<const SaveObject*>(m_data + header().objects_offset); }
+    uint32_t objectCount() const { return header().object_count; }
+
+    void close()
+    {
+#if defined(_WIN32)
+        if (m_data) UnmapViewOfFile(m_data);
+        if (m_mapping) CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+        m_mapping = nullptr;
+        m_file = INVALID_HANDLE_VALUE;
+#elif !defined(__EMSCRIPTEN__)
+        if (m_data) munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+        m_buffer.clear();
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+private:
+    bool fail(const std::string& message, std::string& error)
+    {
+        error = message;
+        close();
+        return false;
+    }
+
+    bool map(const std::string& path, std::string& error)
+    {
+#if defined(_WIN32)
+        m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE) return fail("cannot open " + path, error);
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0) return fail("cannot map " + path, error);
+        m_size = static_cast<size_t>(size.QuadPart);
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!m_mapping) return fail("cannot map " + path, error);
+        m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!m_data) return fail("cannot map " + path, error);
+        return true;
+#elif !defined(__EMSCRIPTEN__)
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return fail("cannot open " + path, error);
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            return fail("cannot map " + path, error);
+        }
+        void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // the mapping keeps the file alive
+        if (data == MAP_FAILED) return fail("cannot map " + path, error);
+        m_data = static_cast<const uint8_t*>(data);
+        m_size = static_cast<size_t>(st.st_size);
+        return true;
+#else
+        // no mmap on the web file system: one read into an aligned buffer
+        FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file) return fail("cannot open " + path, error);
+        std::fseek(file, 0, SEEK_END);
+        const long size = std::ftell(file);
+        std::fseek(file, 0, SEEK_SET);
+        m_buffer.resize(size > 0 ? (static_cast<size_t>(size) + 15) / 16 : 0);
+        const bool ok = size > 0 && std::fread(m_buffer.data(), 1, static_cast<size_t>(size), file) == static_cast<size_t>(size);
+        std::fclose(file);
+        if (!ok) return fail("cannot read " + path, error);
+        m_data = reinterpret_cast<const uint8_t*>(m_buffer.data());
+        m_size = static_cast<size_t>(size);
+        return true;
+#endif
+    }
+
+    const uint8_t* m_data = nullptr;
+    size_t         m_size = 0;
+    struct alignas(16) Block { uint8_t bytes[16]; };
+    std::vector<Block> m_buffer; // read fallback
+#if defined(_WIN32)
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+#endif
+};
@@ -0,0 +1,140 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+
+// How far the governor has backed off from full-quality, real-time physics
+enum class GovernorLevel : uint8_t {
+    Normal,          // every tick, lost time is caught up (bounded)
+    NoCatchUp,       // time lost to a stall is dropped instead of replayed in a burst
+    SlowMotion,      // ticks are spaced out: the game runs slower than real time
+};
+
+inline const char* governorLevelName(GovernorLevel level)
+{
+    switch (level) {
+        case GovernorLevel::Normal:     return "normal";
+        case GovernorLevel::NoCatchUp:  return "no catch-up";
+        case GovernorLevel::SlowMotion: return "slow motion";
+    }
+    return "?";
+}
+
+// Keeps the cost of physics inside a time budget per tick. Tick costs are smoothed,
+// and the governor steps one level down after a sustained overrun and one level back
+// up after a sustained calm period, so short hitches do not make it oscillate.
+// Every level change is printed and published with the render state.
+class SimulationGovernor
+{
+public:
+    static constexpr uint32_t DEGRADE_TICKS = 15;  // overrun this long before degrading
+    static constexpr uint32_t RECOVER_TICKS = 120; // calm this long before recovering
+    static constexpr float    MIN_TIME_SCALE = 0.25f;
+    static constexpr uint32_t CATCH_UP_TICKS = 4;  // bounded catch-up at normal levels
+
+    // Budget defaults to 75% of the tick period; SUIKA_PHYSICS_BUDGET=<ms> overrides it
+    void configure(float timestep)
+    {
+        m_budget_ms = timestep * 1000.0f * 0.75f;
+        if (const char* budget = std::getenv("SUIKA_PHYSICS_BUDGET")) {
+            const float ms = static_cast<float>(std::atof(budget));
+            if (ms > 0.0f) m_budget_ms = ms;
+        }
+    }
+
+    // Feeds the cost of one solver update
+    void recordTick(float tick_ms)
+    {
+        m_cost_ms += 0.1f * (tick_ms - m_cost_ms);
+        ++m_ticks_since_drop_report;
+
+        if (m_level == GovernorLevel::SlowMotion) {
+            // spacing ticks out does not make them cheaper, it bounds their share of wall time
+            m_time_scale = std::max(MIN_TIME_SCALE, std::min(1.0f, m_budget_ms / std::max(m_cost_ms, 1e-3f)));
+        }
+
+        if (m_cost_ms > m_budget_ms) {
+            m_calm = 0;
+            if (++m_over >= DEGRADE_TICKS) degrade();
+        } else if (m_cost_ms < m_budget_ms * 0.5f) {
+            m_over = 0;
+            if (++m_calm >= RECOVER_TICKS) recover();
+        } else {
+            m_over = 0;
+            m_calm = 0;
+        }
+    }
+
+    // Ticks skipped because the simulation fell too far behind
+    void recordDropped(uint64_t ticks)
+    {
+        m_dropped += ticks;
+        m_unreported_drops += ticks;
+        // at most one line per second of ticks, even when every tick is late
+        if (m_ticks_since_drop_report < 60) return;
+        std::cout << "physics governor: dropped " << m_unreported_drops << " ticks of simulation time ("
+                  << m_dropped << " total)" << std::endl;
+        m_unreported_drops = 0;
+        m_ticks_since_drop_report = 0;
+    }
+
+    GovernorLevel level() const { return m_level; }
+    float timeScale() const { return m_level == GovernorLevel::SlowMotion ? m_time_scale : 1.0f; }
+    float costMs() const { return m_cost_ms; }
+    float budgetMs() const { return m_budget_ms; }
+    uint64_t droppedTicks() const { return m_dropped; }
+
+    // How many ticks a late loop may run back to back before dropping the rest
+    uint32_t catchUpTicks() const { return m_level >= GovernorLevel::NoCatchUp ? 1 : CATCH_UP_TICKS; }
+
+private:
+    void degrade()
+    {
+        m_over = 0;
+        switch (m_level) {
+            case GovernorLevel::Normal:
+                setLevel(GovernorLevel::NoCatchUp);
+                break;
+            case GovernorLevel::NoCatchUp:
+                m_time_scale = std::max(MIN_TIME_SCALE, std::min(1.0f, m_budget_ms / m_cost_ms));
+                setLevel(GovernorLevel::SlowMotion);
+                break;
+            case GovernorLevel::SlowMotion:
+                break;
+        }
+    }
+
+    void recover()
+    {
+        m_calm = 0;
+        switch (m_level) {
+            case GovernorLevel::Normal:
+                break;
+            case GovernorLevel::NoCatchUp:
+                setLevel(GovernorLevel::Normal);
+                break;
+            case GovernorLevel::SlowMotion:
+                m_time_scale = 1.0f;
+                setLevel(GovernorLevel::NoCatchUp);
+                break;
+        }
+    }
+
+    void setLevel(GovernorLevel level)
+    {
+        m_level = level;
+        std::cout << "physics governor: " << governorLevelName(m_level) << " (tick " << m_cost_ms
+                  << " ms, budget " << m_budget_ms << " ms, time x" << timeScale() << ")" << std::endl;
+    }
+
+    GovernorLevel m_level                   = GovernorLevel::Normal;
+    float         m_budget_ms               = 12.5f;
+    float         m_cost_ms                 = 0.0f;
+    float         m_time_scale              = 1.0f;
+    uint32_t      m_over                    = 0;
+    uint32_t      m_calm                    = 0;
+    uint64_t      m_dropped                 = 0;
+    uint64_t      m_unreported_drops        = 0;
+    uint32_t      m_ticks_since_drop_report = 60;
+};
@@ -0,0 +1,433 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "globals.h"
+#include "physics_solver.hpp"
+#include "physics_stats.hpp"
+#include "triple_buffer.hpp"
+#include "simulation_governor.hpp"
+#include "replay.hpp"
+#include "rewind.hpp"
+#include "spectator.hpp"
+#include "profiler.hpp"
+
+// What the renderer needs to know about one solver slot
+struct RenderObject
+{
+    glm::vec4 position = glm::vec4(0.0f);
+    float     radius   = 0.0f;
+    Fruit     fruit    = Fruit::CHERRY;
+    bool      active   = false; // slot holds a visible fruit
+
+    RayInter testRay(float w, const glm::vec3& rayOrigin, const glm::vec3& rayDirection) const {
+        if (!active) return RayInter();
+        return testSphereRay(position, radius, w, rayOrigin, rayDirection);
+    }
+};
+
+// Snapshot of the solver published after every physics tick
+struct RenderState
+{
+    std::array<RenderObject, MAX_OBJECTS> objects;
+    uint64_t tick          = 0;
+    double   time          = 0.0;  // steady clock seconds when the tick finished
+    float    tick_ms       = 0.0f; // cost of the last solver update
+    uint32_t contact_pairs = 0;    // occupied pairs tested in the last solver update
+    int      total_points  = 0;
+    uint64_t merges        = 0; // monotonic, so a reader that skips ticks still sees every merge
+    GovernorLevel governor   = GovernorLevel::Normal;
+    float         time_scale = 1.0f; // below 1 while the governor runs physics in slow motion
+    uint32_t      catch_up   = SimulationGovernor::CATCH_UP_TICKS; // ticks a late loop may run back to back
+    float         snapshot_us    = 0.0f; // cost of the last rewind snapshot
+    uint32_t      rewind_bytes   = 0;    // memory held by the rewind history
+    float         rewind_seconds = 0.0f; // how far back a rewind can currently go
+    uint32_t      lod_far = 0;           // fruits the level of detail steps at the reduced rate
+    PhysicsStats  physics;               // health of the last solver update
+    uint64_t      unstable_ticks = 0;    // monotonic, like merges
+};
+
+inline double simulationClock()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Blends two ticks for display. Slots that appeared, disappeared or changed fruit
+// (a merge reuses the slot) snap to the newer tick instead of sliding.
+inline void interpolateRenderState(const RenderState& previous, const RenderState& current, float alpha, RenderState& out)
+{
+    out = current;
+    for (int i = 0; i < MAX_OBJECTS; i++) {
+        const RenderObject& a = previous.objects[i];
+        const RenderObject& b = current.objects[i];
+        if (!a.active || !b.active || a.fruit != b.fruit) continue;
+        out.objects[i].position = glm::mix(a.position, b.position, alpha);
+        out.objects[i].radius   = glm::mix(a.radius, b.radius, alpha);
+    }
+}
+
+// Steps the solver at a fixed rate on its own thread and publishes RenderStates
+// through a triple buffer, so neither the renderer nor the simulation ever waits
+// on the other. Gameplay input (drops) is queued and applied at the next tick.
+// Without threads (web builds) the owner calls step() from its own fixed-update loop.
+class SimulationThread
+{
+public:
+    SimulationThread(PhysicSolver& solver, float timestep)
+        : m_solver(solver), m_timestep(timestep), m_history(rewindCapacity(timestep))
+    {
+        m_governor.configure(timestep);
+        m_solver.saveState(m_snapshot);
+        shareLocked(m_snapshot);
+        capture(m_states.back());
+        m_states.publish();
+        m_states.update();
+        m_previous = m_states.front();
+    }
+
+    ~SimulationThread() { stop(); }
+
+    void start()
+    {
+#ifndef WEB_BUILD
+        if (m_thread.joinable()) return;
+        m_running = true;
+        m_thread = std::thread([this]() {
+            prof::setThreadName("simulation");
+            run();
+        });
+#endif
+    }
+
+    void stop()
+    {
+        m_running = false;
+        if (m_thread.joinable()) m_thread.join();
+    }
+
+    bool threaded() const { return m_thread.joinable(); }
+
+    // The solver only advances while the game is being played
+    void setActive(bool active) { m_active.store(active, std::memory_order_relaxed); }
+
+    // The slice the player looks at, for the solver's level of detail; read at every tick
+    void setLodFocus(float w) { m_lod_focus.store(w, std::memory_order_relaxed); }
+
+    void drop(const PhysicsObject& object)
+    {
+        std::lock_guard<std::mutex> lock(m_command_mutex);
+        m_pending_drops.push_back(object);
+    }
+
+    // For rare whole-solver operations (load, props, backend switch): runs between
+    // ticks and republishes, so it may wait for the tick in flight. Per-frame readers
+    // use latestState() or tryBetweenTicks() instead.
+    template <typename F>
+    void withSolver(F&& f)
+    {
+        std::lock_guard<std::mutex> lock(m_solver_mutex);
+        f(m_solver);
+        republishLocked();
+    }
+
+    // Clears the solver for a new game (recorded as a reset in replays)
+    void resetSolver()
+    {
+        std::lock_guard<std::mutex> lock(m_solver_mutex);
+        m_solver.clear();
+        m_history.clear();
+        if (m_recorder) m_recorder->reset(m_tick - m_record_base);
+        republishLocked();
+    }
+
+    // Logs every input from the next tick on, starting from an empty bowl. The caller
+    // keeps the recorder alive until stopRecording().
+    void startRecording(ReplayRecorder* recorder)
+    {
+        std::lock_guard<std::mutex> lock(m_solver_mutex);
+        m_recorder = recorder;
+        m_record_base = m_tick;
+        m_solver.clear();
+        m_history.clear();
+        republishLocked();
+    }
+
+    void stopRecording()
+    {
+        std::lock_guard<std::mutex> lock(m_solver_mutex);
+        if (!m_recorder) return;
+        m_recorder->finish(m_tick - m_record_base, m_solver.total_points, solverChecksum(m_solver));
+        m_recorder = nullptr;
+    }
+
+    // Hands every tick to a spectator stream from the next tick on; the publisher
+    // outlives the call to stopSpectating()
+    void startSpectating(SpectatorPublisher* publisher)
+    {
+        std::lock_guard<std::mutex> lock(m_solver_mutex);
+        m_spectator = publisher;
+    }
+
+    void stopSpectating()
+    {
+        std::lock_guard<std::mutex> lock(m_solver_mutex);
+        m_spectator = nullptr;
+    }
+
+    // Writes the health of every tick from the next one on; the caller keeps the log
+    // open until stopPhysicsLog()
+    void startPhysicsLog(PhysicsLog* log)
+    {
+        std::lock_guard<std::mutex> lock(m_solver_mutex);
+        m_physics_log = log;
+    }
+
+    void stopPhysicsLog()
+    {
+        std::lock_guard<std::mutex> lock(m_solver_mutex);
+        m_physics_log = nullptr;
+    }
+
+    // Physics health is a pairwise pass over every slot: it only runs while a physics
+    // log is open or this is on (the overlay shows it), and unstable ticks count only then
+    void measureHealth(bool on) { m_measure_health.store(on, std::memory_order_relaxed); }
+
+    // Steps the bowl back up to `seconds` (as far as the history reaches).
+    // Returns false when there is nothing to go back to.
+    bool rewind(float seconds)
+    {
+        std::lock_guard<std::mutex> lock(m_solver_mutex);
+        const uint32_t steps = m_history.reachable(static_cast<uint32_t>(std::lround(seconds / m_timestep)));
+        if (steps == 0 || !m_history.rewind(steps, m_snapshot)) return false;
+        m_solver.loadState(m_snapshot);
+        if (m_recorder) m_recorder->rewind(m_tick - m_record_base, steps);
+        shareLocked(m_snapshot);
+        publishLocked();
+        return true;
+    }
+
+    // Runs f between ticks without touching the solver state (e.g. reading executor
+    // stats), unless a tick is in flight: then it returns false without waiting and the
+    // caller tries again on a later frame
+    template <typename F>
+    bool tryBetweenTicks(F&& f)
+    {
+        std::unique_lock<std::mutex> lock(m_solver_mutex, std::try_to_lock);
+        if (!lock.owns_lock()) return false;
+        f();
+        return true;
+    }
+
+    // Any thread: the solver state after the last tick or solver operation. Only waits
+    // for a copy, never for a tick.
+    void latestState(SolverState& out) const
+    {
+        std::lock_guard<std::mutex> lock(m_shared_mutex);
+        out = m_shared;
+    }
+
+    // One tick on the calling thread, used when there is no simulation thread.
+    // The caller is also the reader here, so it takes the new state right away and
+    // previous() stays exactly one tick behind.
+    void step()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_solver_mutex);
+            tickLocked();
+        }
+        acquire();
+    }
+
+    // Fixed-update loop without a simulation thread: reports ticks it had to skip
+    void dropTicks(uint64_t ticks)
+    {
+        std::lock_guard<std::mutex> lock(m_solver_mutex);
+        m_governor.recordDropped(ticks);
+    }
+
+    // Render thread: picks up the newest published state, if any. Call once per
+    // frame so every pass of that frame sees the same tick.
+    const RenderState& acquire()
+    {
+        if (m_states.fresh()) {
+            m_previous = m_states.front();
+            m_states.update();
+        }
+        return m_states.front();
+    }
+
+    // Render thread: the state returned by the last acquire()
+    const RenderState& current() const { return m_states.front(); }
+
+    // Render thread: the state acquire() returned before current()
+    const RenderState& previous() const { return m_previous; }
+
+    // Render thread: how far the wall clock has moved from previous() towards current().
+    // Rendering one tick behind the simulation keeps this inside [0, 1] without extrapolating.
+    float interpolationAlpha(double now) const
+    {
+        const double span = current().time - m_previous.time;
+        if (span <= 0.0) return 1.0f;
+        return static_cast<float>(glm::clamp((now - current().time) / span, 0.0, 1.0));
+    }
+
+    float timestep() const { return m_timestep; }
+
+private:
+    void run()
+    {
+        using clock = std::chrono::steady_clock;
+        const auto base_period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<float>(m_timestep));
+        auto next_tick = clock::now() + base_period;
+        while (m_running) {
+            std::this_thread::sleep_until(next_tick);
+            uint32_t catch_up;
+            float time_scale;
+            {
+                std::lock_guard<std::mutex> lock(m_solver_mutex);
+                tickLocked();
+                catch_up = m_governor.catchUpTicks();
+                time_scale = m_governor.timeScale();
+            }
+            // In slow motion the same timestep is simulated less often
+            const auto period = std::chrono::duration_cast<clock::duration>(base_period / time_scale);
+            next_tick += period;
+            // Drop time we cannot catch up on instead of bursting ticks after a stall
+            const auto now = clock::now();
+            if (now > next_tick + catch_up * period) {
+                const uint64_t dropped = static_cast<uint64_t>((now - next_tick) / period);
+                next_tick = now + period;
+                if (m_active.load(std::memory_order_relaxed)) {
+                    std::lock_guard<std::mutex> lock(m_solver_mutex);
+                    m_governor.recordDropped(dropped);
+                }
+            }
+        }
+    }
+
+    void tickLocked()
+    {
+        if (!m_active.load(std::memory_order_relaxed)) return;
+        PROFILE_SCOPE("SimulationThread::tick");
+        {
+            std::lock_guard<std::mutex> lock(m_command_mutex);
+            for (const PhysicsObject& object : m_pending_drops) {
+                if (m_recorder) m_recorder->drop(m_tick - m_record_base, object);
+                m_solver.addObject(object);
+            }
+            m_pending_drops.clear();
+        }
+        m_solver.lod.focus_w = m_lod_focus.load(std::memory_order_relaxed);
+        const double update_start = simulationClock();
+        m_solver.update(m_timestep);
+        m_tick_ms = static_cast<float>((simulationClock() - update_start) * 1000.0);
+        m_governor.recordTick(m_tick_ms);
+        m_merges += static_cast<uint64_t>(m_solver.just_merged.load());
+        if (m_physics_log || m_measure_health.load(std::memory_order_relaxed)) {
+            m_physics = measurePhysics(m_solver);
+            m_physics.tick = m_tick + 1;
+            m_unstable_ticks += m_physics.unstable() ? 1 : 0;
+            if (m_physics_log) m_physics_log->write(m_physics);
+        }
+        {
+            PROFILE_SCOPE("SimulationThread::snapshot");
+            const double snapshot_start = simulationClock();
+            m_solver.saveState(m_snapshot);
+            m_history.capture(m_snapshot);
+            shareLocked(m_snapshot);
+            m_snapshot_us = static_cast<float>((simulationClock() - snapshot_start) * 1e6);
+        }
+        ++m_tick;
+        m_tick_time = simulationClock();
+        if (m_spectator) m_spectator->capture(m_tick, m_solver);
+        publishLocked();
+    }
+
+    void shareLocked(const SolverState& state)
+    {
+        std::lock_guard<std::mutex> lock(m_shared_mutex);
+        m_shared = state;
+    }
+
+    // After an operation outside a tick changed the solver
+    void republishLocked()
+    {
+        m_solver.saveState(m_snapshot);
+        shareLocked(m_snapshot);
+        publishLocked();
+    }
+
+    void publishLocked()
+    {
+        PROFILE_SCOPE("SimulationThread::publish");
+        capture(m_states.back());
+        m_states.publish();
+    }
+
+    void capture(RenderState& out) const
+    {
+        for (int i = 0; i < MAX_OBJECTS; i++) {
+            const PhysicsObject& obj = m_solver.objects[i];
+            RenderObject& dst = out.objects[i];
+            dst.active   = m_solver.has_obj[i] && !obj.hidden;
+            dst.position = obj.position;
+            dst.radius   = obj.radius;
+            dst.fruit    = obj.fruit;
+        }
+        out.tick          = m_tick;
+        out.time          = m_tick_time;
+        out.tick_ms       = m_tick_ms;
+        out.contact_pairs = m_solver.contact_pairs_tested;
+        out.total_points  = m_solver.total_points;
+        out.merges        = m_merges;
+        out.governor      = m_governor.level();
+        out.time_scale    = m_governor.timeScale();
+        out.catch_up      = m_governor.catchUpTicks();
+        out.snapshot_us    = m_snapshot_us;
+        out.rewind_bytes   = static_cast<uint32_t>(m_history.bytes());
+        out.rewind_seconds = m_history.reachable(UINT32_MAX) * m_timestep;
+        out.lod_far        = m_solver.lod_far_count;
+        out.physics        = m_physics;
+        out.unstable_ticks = m_unstable_ticks;
+    }
+
+    PhysicSolver&                  m_solver;
+    float                          m_timestep;
+    SimulationGovernor             m_governor; // guarded by m_solver_mutex
+    tp::TripleBuffer<RenderState>  m_states;
+    RenderState                    m_previous; // reader side only
+
+    std::thread                    m_thread;
+    std::atomic<bool>              m_running{false};
+    std::atomic<bool>              m_active{false};
+    std::atomic<float>             m_lod_focus{0.0f};
+    std::atomic<bool>              m_measure_health{false};
+
+    std::mutex                     m_solver_mutex;  // held for a whole tick
+    std::mutex                     m_command_mutex; // guards m_pending_drops only
+    mutable std::mutex             m_shared_mutex;  // guards m_shared, held only to copy it
+    SolverState                    m_shared;        // latest state, for latestState()
+    std::vector<PhysicsObject>     m_pending_drops;
+    ReplayRecorder*                m_recorder = nullptr; // guarded by m_solver_mutex
+    SpectatorPublisher*            m_spectator = nullptr; // guarded by m_solver_mutex
+    PhysicsLog*                    m_physics_log = nullptr; // guarded by m_solver_mutex
+    SnapshotRing                   m_history;  // rewind snapshots, guarded by m_solver_mutex
+    SolverState                    m_snapshot; // scratch for capture and restore
+    float                          m_snapshot_us = 0.0f;
+    uint64_t                       m_record_base = 0;    // tick the recording started on
+
+    uint64_t                       m_tick      = 0;
+    double                         m_tick_time = 0.0;
+    float                          m_tick_ms   = 0.0f;
+    uint64_t                       m_merges    = 0;
+    PhysicsStats                   m_physics;
+    uint64_t                       m_unstable_ticks = 0;
+};
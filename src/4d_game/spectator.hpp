@@ -0,0 +1,249 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spectator_codec.hpp"
+#include "spectator_net.hpp"
+#include "profiler.hpp"
+
+// Streams the bowl to spectator processes (4d_game --spectate <endpoint>, viewed with
+// spectator_view). The simulation thread only quantizes each tick into a small queue;
+// encoding and socket I/O happen on the publisher's own thread, so neither the frame
+// nor the tick waits on a viewer. Every frame is encoded once and shared by all
+// viewers. A viewer that falls behind has its backlog dropped and picks up again at
+// the next keyframe, instead of holding memory or the game back.
+class SpectatorPublisher
+{
+public:
+    static constexpr uint32_t KEYFRAME_INTERVAL = 60;       // ticks between keyframes
+    static constexpr size_t   QUEUE_FRAMES      = 16;       // oldest tick is dropped beyond this
+    static constexpr size_t   VIEWER_BACKLOG    = 256 * 1024; // bytes queued for a viewer before it is resynced
+
+    SpectatorPublisher(const std::string& endpoint, float timestep) : m_endpoint_text(endpoint), m_timestep(timestep) {}
+    SpectatorPublisher(const SpectatorPublisher&) = delete;
+    SpectatorPublisher& operator=(const SpectatorPublisher&) = delete;
+    ~SpectatorPublisher() { stop(); }
+
+    bool start(std::string& error)
+    {
+        if (!net::parseEndpoint(m_endpoint_text, m_endpoint, error)) return false;
+        if (!net::startup()) {
+            error = "cannot initialize sockets";
+            return false;
+        }
+        m_listener = net::listen(m_endpoint, error);
+        if (m_listener == net::INVALID) return false;
+        m_running = true;
+        m_thread = std::thread([this]() {
+            prof::setThreadName("spectator");
+            run();
+        });
+        return true;
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_running) return;
+            m_running = false;
+        }
+        m_wake.notify_one();
+        if (m_thread.joinable()) m_thread.join();
+        for (Viewer& viewer : m_viewers) net::close(viewer.socket);
+        m_viewers.clear();
+        net::close(m_listener);
+        m_listener = net::INVALID;
+#if !defined(_WIN32)
+        if (m_endpoint.unix_socket) ::unlink(m_endpoint.path.c_str());
+#endif
+    }
+
+    // Simulation thread, once per tick: a copy into the queue, nothing else
+    void capture(uint64_t tick, const PhysicSolver& solver)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_queued == QUEUE_FRAMES) {
+                m_queue_head = (m_queue_head + 1) % QUEUE_FRAMES; // the next delta skips a tick
+                --m_queued;
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+            m_queue[(m_queue_head + m_queued) % QUEUE_FRAMES].capture(tick, solver);
+            ++m_queued;
+        }
+        m_wake.notify_one();
+    }
+
+    std::string endpoint() const { return m_endpoint.describe(); }
+    uint32_t viewers() const { return m_viewer_count.load(std::memory_order_relaxed); }
+    // Encoded stream per viewer over the last second
+    double bytesPerSecond() const { return m_rate.load(std::memory_order_relaxed); }
+    double bytesPerFrame() const { return m_frame_bytes.load(std::memory_order_relaxed); }
+    float encodeMicroseconds() const { return m_encode_us.load(std::memory_order_relaxed); }
+    uint64_t droppedTicks() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Viewer
+    {
+        net::Socket socket = net::INVALID;
+        std::deque<std::shared_ptr<const std::vector<uint8_t>>> outbox;
+        size_t offset = 0; // into outbox.front()
+        size_t queued = 0; // bytes in outbox not yet sent
+        bool   waiting = true; // for a keyframe to start decoding from
+    };
+
+    void run()
+    {
+        using clock = std::chrono::steady_clock;
+        std::vector<SpectatorFrame> frames;
+        auto window_start = clock::now();
+        size_t window_bytes = 0;
+        uint64_t window_frames = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait_for(lock, std::chrono::milliseconds(20), [this]() { return !m_running || m_queued > 0; });
+                if (!m_running) break;
+                frames.resize(m_queued);
+                for (size_t k = 0; k < m_queued; ++k) frames[k] = m_queue[(m_queue_head + k) % QUEUE_FRAMES];
+                m_queue_head = (m_queue_head + m_queued) % QUEUE_FRAMES;
+                m_queued = 0;
+            }
+            PROFILE_SCOPE("SpectatorPublisher::publish");
+            acceptViewers();
+            // A new or resynced viewer gets a keyframe right away, even while the game is paused
+            if (frames.empty() && m_need_key && m_have_frame) frames.push_back(m_last);
+            for (const SpectatorFrame& frame : frames) {
+                const bool key = m_need_key || m_since_key >= KEYFRAME_INTERVAL;
+                const auto start = clock::now();
+                auto message = std::make_shared<std::vector<uint8_t>>();
+                message->reserve(512);
+                spectatorMessageHeader(0, *message);
+                m_codec.encode(frame, key, *message);
+                const uint32_t size = static_cast<uint32_t>(message->size() - 4);
+                for (int i = 0; i < 4; i++) (*message)[i] = static_cast<uint8_t>(size >> (8 * i));
+                m_encode_us.store(std::chrono::duration<float, std::micro>(clock::now() - start).count(), std::memory_order_relaxed);
+                m_since_key = key ? 1 : m_since_key + 1;
+                m_need_key = false;
+                m_last = frame;
+                m_have_frame = true;
+                window_bytes += message->size();
+                ++window_frames;
+                broadcast(message, key);
+            }
+            flush();
+            const double elapsed = std::chrono::duration<double>(clock::now() - window_start).count();
+            if (elapsed >= 1.0) {
+                m_rate.store(window_bytes / elapsed, std::memory_order_relaxed);
+                if (window_frames) m_frame_bytes.store(static_cast<double>(window_bytes) / window_frames, std::memory_order_relaxed);
+                window_start = clock::now();
+                window_bytes = 0;
+                window_frames = 0;
+            }
+        }
+    }
+
+    void acceptViewers()
+    {
+        for (;;) {
+            const net::Socket socket = net::accept(m_listener, m_endpoint);
+            if (socket == net::INVALID) break;
+            Viewer viewer;
+            viewer.socket = socket;
+            auto hello = std::make_shared<std::vector<uint8_t>>();
+            spectatorHello(m_timestep, *hello);
+            viewer.queued = hello->size();
+            viewer.outbox.push_back(std::move(hello));
+            m_viewers.push_back(std::move(viewer));
+            m_need_key = true;
+            std::cout << "spectator connected (" << m_viewers.size() << " watching)" << std::endl;
+        }
+        m_viewer_count.store(static_cast<uint32_t>(m_viewers.size()), std::memory_order_relaxed);
+    }
+
+    void broadcast(const std::shared_ptr<const std::vector<uint8_t>>& message, bool key)
+    {
+        for (Viewer& viewer : m_viewers) {
+            if (viewer.waiting && !key) continue;
+            viewer.waiting = false;
+            if (viewer.queued > VIEWER_BACKLOG) {
+                // keep only a message already partly on the wire, then resync
+                while (viewer.outbox.size() > (viewer.offset > 0 ? 1u : 0u)) viewer.outbox.pop_back();
+                viewer.queued = viewer.outbox.empty() ? 0 : viewer.outbox.front()->size() - viewer.offset;
+                viewer.waiting = true;
+                m_need_key = true;
+                continue;
+            }
+            viewer.outbox.push_back(message);
+            viewer.queued += message->size();
+        }
+    }
+
+    void flush()
+    {
+        for (size_t v = 0; v < m_viewers.size();) {
+            Viewer& viewer = m_viewers[v];
+            bool alive = true;
+            while (!viewer.outbox.empty()) {
+                const std::vector<uint8_t>& front = *viewer.outbox.front();
+                const long sent = net::send(viewer.socket, front.data() + viewer.offset, front.size() - viewer.offset);
+                if (sent < 0) {
+                    alive = false;
+                    break;
+                }
+                if (sent == 0) break;
+                viewer.offset += static_cast<size_t>(sent);
+                viewer.queued -= static_cast<size_t>(sent);
+                if (viewer.offset < front.size()) break;
+                viewer.outbox.pop_front();
+                viewer.offset = 0;
+            }
+            if (alive) {
+                ++v;
+                continue;
+            }
+            net::close(viewer.socket);
+            m_viewers.erase(m_viewers.begin() + static_cast<std::ptrdiff_t>(v));
+            std::cout << "spectator disconnected (" << m_viewers.size() << " watching)" << std::endl;
+        }
+        m_viewer_count.store(static_cast<uint32_t>(m_viewers.size()), std::memory_order_relaxed);
+    }
+
+    std::string   m_endpoint_text;
+    net::Endpoint m_endpoint;
+    float         m_timestep;
+    net::Socket   m_listener = net::INVALID;
+    std::thread   m_thread;
+
+    std::mutex              m_mutex; // guards the queue and m_running
+    std::condition_variable m_wake;
+    bool                    m_running = false;
+    std::array<SpectatorFrame, QUEUE_FRAMES> m_queue;
+    size_t                  m_queue_head = 0;
+    size_t                  m_queued = 0;
+
+    // publisher thread only
+    SpectatorCodec      m_codec;
+    SpectatorFrame      m_last;
+    bool                m_have_frame = false;
+    bool                m_need_key = true;
+    uint32_t            m_since_key = 0;
+    std::vector<Viewer> m_viewers;
+
+    std::atomic<uint32_t> m_viewer_count{0};
+    std::atomic<double>   m_rate{0.0};
+    std::atomic<double>   m_frame_bytes{0.0};
+    std::atomic<float>    m_encode_us{0.0f};
+    std::atomic<uint64_t> m_dropped{0};
+};
@@ -0,0 +1,432 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "globals.h"
+#include "physics_solver.hpp"
+
+// Spectator stream encoding. Every tick the visible fruits are quantized to 1/1024 of
+// a unit and coded against a prediction from the previous frames (a fruit moving
+// steadily, or at rest, costs almost nothing), and the residuals are entropy coded
+// with adaptive models and a range coder. A keyframe resets the models and the
+// prediction, so a viewer can start decoding at any keyframe.
+//
+// A message on the wire is a u32 little-endian payload size followed by the payload:
+//   hello     u8 0, "S4DV", u8 version, f32 timestep, f32 scale, u16 slots
+//   keyframe  u8 1, u64 tick, range coded frame
+//   delta     u8 2, range coded frame (tick delta first)
+
+const uint8_t  SPECTATOR_VERSION = 1;
+const uint8_t  SPECTATOR_HELLO = 0;
+const uint8_t  SPECTATOR_KEYFRAME = 1;
+const uint8_t  SPECTATOR_DELTA = 2;
+const uint32_t SPECTATOR_MAX_MESSAGE = 1u << 20;
+
+struct SpectatorSlot
+{
+    int32_t position[4] = {0, 0, 0, 0}; // x, y, z, w in 1/SCALE units
+    int32_t radius  = 0;
+    uint8_t fruit   = 0;
+    bool    present = false; // a visible fruit occupies the slot
+};
+
+struct SpectatorFrame
+{
+    static constexpr float SCALE = 1024.0f;
+
+    uint64_t tick   = 0;
+    int32_t  points = 0;
+    std::array<SpectatorSlot, MAX_OBJECTS> slots;
+
+    void capture(uint64_t frame_tick, const PhysicSolver& solver)
+    {
+        tick = frame_tick;
+        points = solver.total_points;
+        for (int i = 0; i < MAX_OBJECTS; i++) {
+            const PhysicsObject& obj = solver.objects[i];
+            SpectatorSlot& slot = slots[i];
+            slot.present = solver.has_obj[i] && !obj.hidden;
+            if (!slot.present) continue;
+            for (int c = 0; c < 4; c++) slot.position[c] = static_cast<int32_t>(std::lround(obj.position[c] * SCALE));
+            slot.radius = static_cast<int32_t>(std::lround(obj.radius * SCALE));
+            slot.fruit = static_cast<uint8_t>(obj.fruit);
+        }
+    }
+
+    glm::vec4 position(int slot) const
+    {
+        const int32_t* p = slots[slot].position;
+        return glm::vec4(p[0], p[1], p[2], p[3]) / SCALE;
+    }
+
+    float radius(int slot) const { return slots[slot].radius / SCALE; }
+};
+
+// Carry-less range coder (Subbotin): 32-bit low/range, byte-wise output
+class RangeEncoder
+{
+public:
+    explicit RangeEncoder(std::vector<uint8_t>& out) : m_out(out) {}
+
+    // total must stay below 2^16
+    void encode(uint32_t cum, uint32_t freq, uint32_t total)
+    {
+        m_range /= total;
+        m_low += cum * m_range;
+        m_range *= freq;
+        normalize();
+    }
+
+    void encodeBits(uint32_t value, int bits)
+    {
+        while (bits > 16) {
+            encode(value & 0xffff, 1, 1u << 16);
+            value >>= 16;
+            bits -= 16;
+        }
+        if (bits > 0) encode(value, 1, 1u << bits);
+    }
+
+    void finish()
+    {
+        for (int i = 0; i < 4; i++) {
+            m_out.push_back(static_cast<uint8_t>(m_low >> 24));
+            m_low <<= 8;
+        }
+    }
+
+private:
+    static constexpr uint32_t TOP = 1u << 24;
+    static constexpr uint32_t BOTTOM = 1u << 16;
+
+    void normalize()
+    {
+        for (;;) {
+            if ((m_low ^ (m_low + m_range)) >= TOP) {
+                if (m_range >= BOTTOM) break;
+                m_range = (0u - m_low) & (BOTTOM - 1);
+            }
+            m_out.push_back(static_cast<uint8_t>(m_low >> 24));
+            m_low <<= 8;
+            m_range <<= 8;
+        }
+    }
+
+    std::vector<uint8_t>& m_out;
+    uint32_t m_low = 0;
+    uint32_t m_range = 0xffffffffu;
+};
+
+class RangeDecoder
+{
+public:
+    RangeDecoder(const uint8_t* data, size_t size) : m_data(data), m_size(size)
+    {
+        for (int i = 0; i < 4; i++) m_code = (m_code << 8) | next();
+    }
+
+    uint32_t frequency(uint32_t total)
+    {
+        m_range /= total;
+        const uint32_t value = (m_code - m_low) / m_range;
+        return std::min(value, total - 1);
+    }
+
+    void decode(uint32_t cum, uint32_t freq)
+    {
+        m_low += cum * m_range;
+        m_range *= freq;
+        for (;;) {
+            if ((m_low ^ (m_low + m_range)) >= TOP) {
+                if (m_range >= BOTTOM) break;
+                m_range = (0u - m_low) & (BOTTOM - 1);
+            }
+            m_code = (m_code << 8) | next();
+            m_low <<= 8;
+            m_range <<= 8;
+        }
+    }
+
+    uint32_t decodeBits(int bits)
+    {
+        uint32_t value = 0;
+        int shift = 0;
+        while (bits > 16) {
+            const uint32_t chunk = frequency(1u << 16);
+            decode(chunk, 1);
+            value |= chunk << shift;
+            shift += 16;
+            bits -= 16;
+        }
+        if (bits > 0) {
+            const uint32_t chunk = frequency(1u << bits);
+            decode(chunk, 1);
+            value |= chunk << shift;
+        }
+        return value;
+    }
+
+    // Read past the end of the data (the frame was cut short)
+    bool overrun() const { return m_pos > m_size + 4; }
+
+private:
+    static constexpr uint32_t TOP = 1u << 24;
+    static constexpr uint32_t BOTTOM = 1u << 16;
+
+    uint8_t next()
+    {
+        const uint8_t byte = m_pos < m_size ? m_data[m_pos] : 0;
+        ++m_pos;
+        return byte;
+    }
+
+    const uint8_t* m_data;
+    size_t   m_size;
+    size_t   m_pos = 0;
+    uint32_t m_low = 0;
+    uint32_t m_code = 0;
+    uint32_t m_range = 0xffffffffu;
+};
+
+// Adaptive frequency model over N symbols
+template <uint32_t N>
+class AdaptiveModel
+{
+public:
+    AdaptiveModel() { reset(); }
+
+    void reset()
+    {
+        m_freq.fill(1);
+        m_total = N;
+    }
+
+    void encode(RangeEncoder& enc, uint32_t symbol)
+    {
+        uint32_t cum = 0;
+        for (uint32_t s = 0; s < symbol; s++) cum += m_freq[s];
+        enc.encode(cum, m_freq[symbol], m_total);
+        update(symbol);
+    }
+
+    uint32_t decode(RangeDecoder& dec)
+    {
+        const uint32_t target = dec.frequency(m_total);
+        uint32_t cum = 0;
+        uint32_t symbol = 0;
+        while (cum + m_freq[symbol] <= target) cum += m_freq[symbol++];
+        dec.decode(cum, m_freq[symbol]);
+        update(symbol);
+        return symbol;
+    }
+
+private:
+    static constexpr uint32_t INCREMENT = 32;
+    static constexpr uint32_t LIMIT = 1u << 13;
+
+    void update(uint32_t symbol)
+    {
+        m_freq[symbol] += INCREMENT;
+        m_total += INCREMENT;
+        if (m_total <= LIMIT) return;
+        m_total = 0;
+        for (uint32_t& f : m_freq) {
+            f = (f + 1) / 2;
+            m_total += f;
+        }
+    }
+
+    std::array<uint32_t, N> m_freq;
+    uint32_t m_total = N;
+};
+
+// Signed integers as an adaptive bit length class plus the raw bits below the top one
+class ValueModel
+{
+public:
+    void reset() { m_length.reset(); }
+
+    void encode(RangeEncoder& enc, int32_t value)
+    {
+        const uint32_t u = (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31); // zigzag
+        uint32_t length = 0;
+        while (length < 32 && (u >> length) != 0) ++length;
+        m_length.encode(enc, length);
+        if (length > 1) enc.encodeBits(u & ((1u << (length - 1)) - 1), static_cast<int>(length - 1));
+    }
+
+    int32_t decode(RangeDecoder& dec)
+    {
+        const uint32_t length = m_length.decode(dec);
+        uint32_t u = 0;
+        if (length > 0) u = (length > 1 ? dec.decodeBits(static_cast<int>(length - 1)) : 0) | (1u << (length - 1));
+        return static_cast<int32_t>((u >> 1) ^ (0u - (u & 1)));
+    }
+
+private:
+    AdaptiveModel<33> m_length;
+};
+
+// Frame coder, used the same way on both ends: the encoder and every decoder that
+// started from the same keyframe hold identical models and history.
+class SpectatorCodec
+{
+public:
+    void reset()
+    {
+        m_kind.fill(AdaptiveModel<3>());
+        m_fruit.reset();
+        for (ValueModel& m : m_residual) m.reset();
+        for (ValueModel& m : m_absolute) m.reset();
+        m_radius_residual.reset();
+        m_radius_absolute.reset();
+        m_points.reset();
+        m_tick.reset();
+        m_prev = SpectatorFrame();
+        m_prev_kind.fill(EMPTY);
+        m_synced = false;
+    }
+
+    // Appends one message payload (type byte onwards) for `frame`
+    void encode(const SpectatorFrame& frame, bool keyframe, std::vector<uint8_t>& out)
+    {
+        if (keyframe || !m_synced) {
+            keyframe = true;
+            reset();
+            out.push_back(SPECTATOR_KEYFRAME);
+            for (int i = 0; i < 8; i++) out.push_back(static_cast<uint8_t>(frame.tick >> (8 * i)));
+        } else {
+            out.push_back(SPECTATOR_DELTA);
+        }
+        RangeEncoder enc(out);
+        if (!keyframe) m_tick.encode(enc, static_cast<int32_t>(frame.tick - m_prev.tick));
+        m_points.encode(enc, frame.points - m_prev.points);
+        for (int i = 0; i < MAX_OBJECTS; i++) {
+            const SpectatorSlot& slot = frame.slots[i];
+            const SpectatorSlot& prev = m_prev.slots[i];
+            const uint8_t kind = !slot.present ? EMPTY : (prev.present && prev.fruit == slot.fruit ? MOVING : ADDED);
+            m_kind[m_prev_kind[i]].encode(enc, kind);
+            if (kind == ADDED) {
+                m_fruit.encode(enc, slot.fruit);
+                for (int c = 0; c < 4; c++) m_absolute[c].encode(enc, slot.position[c]);
+                m_radius_absolute.encode(enc, slot.radius);
+            } else if (kind == MOVING) {
+                for (int c = 0; c < 4; c++) m_residual[c].encode(enc, slot.position[c] - predict(i, c));
+                m_radius_residual.encode(enc, slot.radius - prev.radius);
+            }
+            advance(i, kind, slot);
+        }
+        enc.finish();
+        m_prev.tick = frame.tick;
+        m_prev.points = frame.points;
+        m_synced = true;
+    }
+
+    // Decodes one message payload into `frame` (which must be the frame decoded last).
+    // False for a delta before the first keyframe or a malformed message.
+    bool decode(const uint8_t* data, size_t size, SpectatorFrame& frame)
+    {
+        if (size < 1) return false;
+        size_t pos = 1;
+        if (data[0] == SPECTATOR_KEYFRAME) {
+            if (size < 9) return false;
+            reset();
+            uint64_t tick = 0;
+            for (int i = 0; i < 8; i++) tick |= static_cast<uint64_t>(data[1 + i]) << (8 * i);
+            m_prev.tick = tick;
+            pos = 9;
+        } else if (data[0] != SPECTATOR_DELTA || !m_synced) {
+            return false;
+        }
+        RangeDecoder dec(data + pos, size - pos);
+        if (data[0] == SPECTATOR_DELTA) m_prev.tick += static_cast<uint64_t>(static_cast<int64_t>(m_tick.decode(dec)));
+        m_prev.points += m_points.decode(dec);
+        for (int i = 0; i < MAX_OBJECTS; i++) {
+            SpectatorSlot slot;
+            const SpectatorSlot& prev = m_prev.slots[i];
+            const uint32_t kind = m_kind[m_prev_kind[i]].decode(dec);
+            if (kind == ADDED) {
+                slot.present = true;
+                slot.fruit = static_cast<uint8_t>(m_fruit.decode(dec));
+                for (int c = 0; c < 4; c++) slot.position[c] = m_absolute[c].decode(dec);
+                slot.radius = m_radius_absolute.decode(dec);
+            } else if (kind == MOVING) {
+                slot.present = true;
+                slot.fruit = prev.fruit;
+                for (int c = 0; c < 4; c++) slot.position[c] = predict(i, c) + m_residual[c].decode(dec);
+                slot.radius = prev.radius + m_radius_residual.decode(dec);
+            }
+            advance(i, static_cast<uint8_t>(kind), slot);
+        }
+        if (dec.overrun()) {
+            m_synced = false;
+            return false;
+        }
+        m_synced = true;
+        frame = m_prev;
+        return true;
+    }
+
+private:
+    enum : uint8_t { EMPTY = 0, MOVING = 1, ADDED = 2 };
+
+    // Constant velocity for a fruit seen in the last two frames, else where it was
+    int32_t predict(int slot, int c) const
+    {
+        const int32_t p = m_prev.slots[slot].position[c];
+        if (m_prev_kind[slot] != MOVING) return p;
+        return p + (p - m_prev2[slot].position[c]);
+    }
+
+    void advance(int i, uint8_t kind, const SpectatorSlot& slot)
+    {
+        m_prev2[i] = m_prev.slots[i];
+        m_prev.slots[i] = slot;
+        m_prev_kind[i] = kind;
+    }
+
+    std::array<AdaptiveModel<3>, 3> m_kind; // context: the slot's kind in the previous frame
+    AdaptiveModel<FRUIT_COUNT>      m_fruit;
+    std::array<ValueModel, 4>       m_residual;
+    std::array<ValueModel, 4>       m_absolute;
+    ValueModel                      m_radius_residual;
+    ValueModel                      m_radius_absolute;
+    ValueModel                      m_points;
+    ValueModel                      m_tick;
+
+    SpectatorFrame                         m_prev; // last frame coded
+    std::array<SpectatorSlot, MAX_OBJECTS> m_prev2;
+    std::array<uint8_t, MAX_OBJECTS>       m_prev_kind{};
+    bool                                   m_synced = false;
+};
+
+// Message framing: u32 little-endian payload size, then the payload
+inline void spectatorMessageHeader(uint32_t size, std::vector<uint8_t>& out)
+{
+    for (int i = 0; i < 4; i++) out.push_back(static_cast<uint8_t>(size >> (8 * i)));
+}
+
+inline void spectatorHello(float timestep, std::vector<uint8_t>& out)
+{
+    const size_t start = out.size();
+    spectatorMessageHeader(0, out);
+    out.push_back(SPECTATOR_HELLO);
+    out.insert(out.end(), {'S', '4', 'D', 'V'});
+    out.push_back(SPECTATOR_VERSION);
+    const float scale = SpectatorFrame::SCALE;
+    uint8_t bytes[8];
+    std::memcpy(bytes, &timestep, 4);
+    std::memcpy(bytes + 4, &scale, 4);
+    out.insert(out.end(), bytes, bytes + 8);
+    out.push_back(static_cast<uint8_t>(MAX_OBJECTS & 0xff));
+    out.push_back(static_cast<uint8_t>(MAX_OBJECTS >> 8));
+    const uint32_t size = static_cast<uint32_t>(out.size() - start - 4);
+    for (int i = 0; i < 4; i++) out[start + i] = static_cast<uint8_t>(size >> (8 * i));
+}
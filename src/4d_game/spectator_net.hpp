@@ -0,0 +1,242 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// Minimal stream sockets for the spectator stream: TCP everywhere, Unix domain sockets
+// outside Windows. Endpoints are written "tcp:<port>", "tcp:<host>:<port>" or
+// "unix:<path>"; a bare port number means TCP on localhost.
+namespace net
+{
+
+#if defined(_WIN32)
+using Socket = SOCKET;
+const Socket INVALID = INVALID_SOCKET;
+#else
+using Socket = int;
+const Socket INVALID = -1;
+#endif
+
+struct Endpoint
+{
+    bool        unix_socket = false;
+    std::string host = "127.0.0.1";
+    uint16_t    port = 0;
+    std::string path;
+
+    std::string describe() const { return unix_socket ? "unix:" + path : "tcp:" + host + ":" + std::to_string(port); }
+};
+
+inline bool parseEndpoint(const std::string& text, Endpoint& out, std::string& error)
+{
+    out = Endpoint();
+    if (text.rfind("unix:", 0) == 0) {
+#if defined(_WIN32)
+        error = "unix sockets are not supported on this platform";
+        return false;
+#else
+        out.unix_socket = true;
+        out.path = text.substr(5);
+        if (out.path.empty() || out.path.size() >= sizeof(sockaddr_un::sun_path)) {
+            error = "bad unix socket path in " + text;
+            return false;
+        }
+        return true;
+#endif
+    }
+    std::string rest = text.rfind("tcp:", 0) == 0 ? text.substr(4) : text;
+    const size_t colon = rest.rfind(':');
+    if (colon != std::string::npos) {
+        out.host = rest.substr(0, colon);
+        rest = rest.substr(colon + 1);
+    }
+    char* end = nullptr;
+    const long port = std::strtol(rest.c_str(), &end, 10);
+    if (rest.empty() || *end != '\0' || port <= 0 || port > 65535 || out.host.empty()) {
+        error = "bad endpoint " + text + " (expected tcp:[host:]port or unix:path)";
+        return false;
+    }
+    out.port = static_cast<uint16_t>(port);
+    return true;
+}
+
+inline bool startup()
+{
+#if defined(_WIN32)
+    WSADATA data;
+    return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+#else
+    return true;
+#endif
+}
+
+inline void close(Socket s)
+{
+    if (s == INVALID) return;
+#if defined(_WIN32)
+    closesocket(s);
+#else
+    ::close(s);
+#endif
+}
+
+inline bool setNonBlocking(Socket s)
+{
+#if defined(_WIN32)
+    u_long on = 1;
+    return ioctlsocket(s, FIONBIO, &on) == 0;
+#else
+    const int flags = fcntl(s, F_GETFL, 0);
+    return flags >= 0 && fcntl(s, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+// Small frames go out right away instead of waiting to be coalesced
+inline void setLowLatency(Socket s, const Endpoint& endpoint)
+{
+    if (endpoint.unix_socket) return;
+    int on = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&on), sizeof(on));
+#if defined(__APPLE__)
+    setsockopt(s, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+}
+
+inline bool resolve(const Endpoint& endpoint, sockaddr_storage& addr, socklen_t& size, std::string& error)
+{
+    std::memset(&addr, 0, sizeof(addr));
+#if !defined(_WIN32)
+    if (endpoint.unix_socket) {
+        sockaddr_un* un = reinterpret_cast<sockaddr_un*>(&addr);
+        un->sun_family = AF_UNIX;
+        std::memcpy(un->sun_path, endpoint.path.c_str(), endpoint.path.size() + 1);
+        size = sizeof(sockaddr_un);
+        return true;
+    }
+#endif
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(endpoint.host.c_str(), std::to_string(endpoint.port).c_str(), &hints, &result) != 0 || !result) {
+        error = "cannot resolve " + endpoint.host;
+        return false;
+    }
+    std::memcpy(&addr, result->ai_addr, result->ai_addrlen);
+    size = static_cast<socklen_t>(result->ai_addrlen);
+    freeaddrinfo(result);
+    return true;
+}
+
+// Non-blocking listening socket
+inline Socket listen(const Endpoint& endpoint, std::string& error)
+{
+    sockaddr_storage addr;
+    socklen_t size = 0;
+    if (!resolve(endpoint, addr, size, error)) return INVALID;
+    const Socket s = socket(addr.ss_family, SOCK_STREAM, 0);
+    if (s == INVALID) {
+        error = "cannot create a socket";
+        return INVALID;
+    }
+    if (endpoint.unix_socket) {
+#if !defined(_WIN32)
+        ::unlink(endpoint.path.c_str()); // left behind by an earlier run
+#endif
+    } else {
+        int on = 1;
+        setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&on), sizeof(on));
+    }
+    if (::bind(s, reinterpret_cast<sockaddr*>(&addr), size) != 0 || ::listen(s, 8) != 0 || !setNonBlocking(s)) {
+        error = "cannot listen on " + endpoint.describe();
+        close(s);
+        return INVALID;
+    }
+    return s;
+}
+
+// Next pending connection as a non-blocking socket, INVALID when there is none
+inline Socket accept(Socket listener, const Endpoint& endpoint)
+{
+    const Socket s = ::accept(listener, nullptr, nullptr);
+    if (s == INVALID) return INVALID;
+    setNonBlocking(s);
+    setLowLatency(s, endpoint);
+    return s;
+}
+
+// Blocking client connection
+inline Socket connect(const Endpoint& endpoint, std::string& error)
+{
+    sockaddr_storage addr;
+    socklen_t size = 0;
+    if (!resolve(endpoint, addr, size, error)) return INVALID;
+    const Socket s = socket(addr.ss_family, SOCK_STREAM, 0);
+    if (s == INVALID || ::connect(s, reinterpret_cast<sockaddr*>(&addr), size) != 0) {
+        error = "cannot connect to " + endpoint.describe();
+        close(s);
+        return INVALID;
+    }
+    setLowLatency(s, endpoint);
+    return s;
+}
+
+// Bytes sent, 0 when the socket buffer is full, -1 when the peer is gone
+inline long send(Socket s, const uint8_t* data, size_t size)
+{
+#if defined(_WIN32)
+    const int sent = ::send(s, reinterpret_cast<const char*>(data), static_cast<int>(size), 0);
+    if (sent == SOCKET_ERROR) return WSAGetLastError() == WSAEWOULDBLOCK ? 0 : -1;
+    return sent;
+#else
+#if defined(MSG_NOSIGNAL)
+    const ssize_t sent = ::send(s, data, size, MSG_NOSIGNAL);
+#else
+    const ssize_t sent = ::send(s, data, size, 0);
+#endif
+    if (sent < 0) return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+    return static_cast<long>(sent);
+#endif
+}
+
+// Blocking read of exactly `size` bytes; false on error or end of stream
+inline bool receive(Socket s, uint8_t* data, size_t size)
+{
+    while (size > 0) {
+#if defined(_WIN32)
+        const int got = ::recv(s, reinterpret_cast<char*>(data), static_cast<int>(size), 0);
+#else
+        const ssize_t got = ::recv(s, data, size, 0);
+        if (got < 0 && errno == EINTR) continue;
+#endif
+        if (got <= 0) return false;
+        data += got;
+        size -= static_cast<size_t>(got);
+    }
+    return true;
+}
+
+}
@@ -13,7 +13,7 @@
 
 #include <glm/gtc/matrix_transform.hpp>
 #include "hemisphere_boundary.hpp"
-#include "physics_solver.hpp"
+#include "simulation_thread.hpp"
 
 #include "learnopengl/shader.h"
 #include "learnopengl/filesystem.h"
@@ -143,7 +143,7 @@ struct ViewState {
     
 };
 
-inline RayInter getPlacementMouse(ViewState *state, HemisphereBoundary *boundary, PhysicSolver *physics_solver){
+inline RayInter getPlacementMouse(ViewState *state, HemisphereBoundary *boundary, const RenderState& snapshot){
     float winX = state->m_xpos;
     float winY = state->windowHeight - state->m_ypos;
     glm::mat4 view_matrix = state->getViewMatrix();
@@ -178,8 +178,8 @@ inline RayInter getPlacementMouse(ViewState *state, HemisphereBoundary *boundary
     // 5) Intersection test
     RayInter closestResult = boundary->checkRay(state->w,ray_origin,ray_direction);
     for (int i = 0; i < MAX_OBJECTS; ++i) {
-        if (!physics_solver->has_obj[i]) continue;
-        auto result = physics_solver->objects[i].testRay(state->w, ray_origin, ray_direction);
+        if (!snapshot.objects[i].active) continue;
+        auto result = snapshot.objects[i].testRay(state->w, ray_origin, ray_direction);
         if (result.hit && result.distance < closestResult.distance) {
             closestResult = result;
         }
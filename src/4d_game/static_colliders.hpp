@@ -0,0 +1,182 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "boundary.hpp"
+
+// A sphere that never moves: an obstacle fruit, a peg or a decorative prop
+struct StaticCollider
+{
+    glm::vec4 center = glm::vec4(0.0f);
+    float     radius = 0.0f;
+    int       fruit  = -1; // drawn as this fruit, or as a plain prop when negative
+};
+
+// Static colliders, kept out of the solver's slots: the solver generates pairs only
+// between its objects, and every dynamic object queries this set through the boundary
+// pass. A uniform 4D grid is built once, so a query looks at the few cells around the
+// object, however many props the level has; static-static pairs never exist.
+// Call build() after the last add() and before the solver steps.
+class StaticColliders : public Boundary {
+public:
+    void add(const StaticCollider& collider)
+    {
+        m_colliders.push_back(collider);
+        m_built = false;
+    }
+
+    void clear()
+    {
+        m_colliders.clear();
+        m_cell_keys.clear();
+        m_cell_start.clear();
+        m_items.clear();
+        m_built = false;
+    }
+
+    // Buckets every collider in the cell of its center. Cells are at least as wide as the
+    // reach of the largest fruit into the largest collider, so a query spans at most three
+    // cells per axis.
+    void build()
+    {
+        m_max_radius = 0.0f;
+        for (const StaticCollider& c : m_colliders) m_max_radius = std::max(m_max_radius, c.radius);
+        float max_fruit = 0.0f;
+        for (int f = 0; f < FRUIT_COUNT; ++f) max_fruit = std::max(max_fruit, fruitPhysics(static_cast<Fruit>(f)).radius);
+        m_cell = std::max(2.0f * m_max_radius, max_fruit + m_max_radius);
+
+        std::vector<std::pair<uint64_t, uint32_t>> keyed(m_colliders.size());
+        for (uint32_t i = 0; i < m_colliders.size(); ++i) keyed[i] = {cellKey(cellOf(m_colliders[i].center)), i};
+        std::sort(keyed.begin(), keyed.end());
+
+        m_cell_keys.clear();
+        m_cell_start.clear();
+        m_items.resize(keyed.size());
+        for (uint32_t k = 0; k < keyed.size(); ++k) {
+            if (m_cell_keys.empty() || m_cell_keys.back() != keyed[k].first) {
+                m_cell_keys.push_back(keyed[k].first);
+                m_cell_start.push_back(k);
+            }
+            m_items[k] = keyed[k].second;
+        }
+        m_cell_start.push_back(static_cast<uint32_t>(keyed.size()));
+        m_built = true;
+    }
+
+    bool built() const { return m_built; }
+    size_t size() const { return m_colliders.size(); }
+    const std::vector<StaticCollider>& colliders() const { return m_colliders; }
+
+    // Pushes the object out of every collider it overlaps, keeping its tangential motion
+    // (the same response as the bowl's wall)
+    void checkSphere(PhysicsObject& obj) const override {
+        if (!m_built || m_items.empty() || obj.hidden || !obj.dynamic) return;
+        const float reach = obj.radius + m_max_radius;
+        const std::array<int32_t, 4> lo = cellOf(obj.position - glm::vec4(reach));
+        const std::array<int32_t, 4> hi = cellOf(obj.position + glm::vec4(reach));
+        for (int32_t x = lo[0]; x <= hi[0]; ++x)
+            for (int32_t y = lo[1]; y <= hi[1]; ++y)
+                for (int32_t z = lo[2]; z <= hi[2]; ++z)
+                    for (int32_t w = lo[3]; w <= hi[3]; ++w) {
+                        const auto it = std::lower_bound(m_cell_keys.begin(), m_cell_keys.end(), cellKey({x, y, z, w}));
+                        if (it == m_cell_keys.end() || *it != cellKey({x, y, z, w})) continue;
+                        const size_t cell = static_cast<size_t>(it - m_cell_keys.begin());
+                        for (uint32_t k = m_cell_start[cell]; k < m_cell_start[cell + 1]; ++k) {
+                            resolve(obj, m_colliders[m_items[k]]);
+                        }
+                    }
+    }
+
+    // Nearest collider hit at slice w
+    RayInter checkRay(float w, const glm::vec3& rayOrigin, const glm::vec3& rayDirection) const override {
+        RayInter best;
+        for (const StaticCollider& c : m_colliders) {
+            const RayInter hit = testSphereRay(c.center, c.radius, w, rayOrigin, rayDirection);
+            if (hit.hit && (!best.hit || hit.distance < best.distance)) best = hit;
+        }
+        return best;
+    }
+
+    // Props file: one collider per line, "x y z w radius [fruit]"; # starts a comment.
+    // A fruit index takes that fruit's radius when the radius is 0.
+    bool load(const std::string& path, std::string& error)
+    {
+        std::ifstream in(path);
+        if (!in) {
+            error = "cannot open " + path;
+            return false;
+        }
+        std::string line;
+        int line_number = 0;
+        while (std::getline(in, line)) {
+            ++line_number;
+            const size_t hash = line.find('#');
+            if (hash != std::string::npos) line.erase(hash);
+            std::istringstream fields(line);
+            StaticCollider c;
+            if (!(fields >> c.center.x)) continue; // blank
+            if (!(fields >> c.center.y >> c.center.z >> c.center.w >> c.radius)) {
+                error = path + ":" + std::to_string(line_number) + ": expected x y z w radius [fruit]";
+                return false;
+            }
+            if (fields >> c.fruit) {
+                if (c.fruit < 0 || c.fruit >= FRUIT_COUNT) {
+                    error = path + ":" + std::to_string(line_number) + ": no fruit " + std::to_string(c.fruit);
+                    return false;
+                }
+                if (c.radius <= 0.0f) c.radius = fruitPhysics(static_cast<Fruit>(c.fruit)).radius;
+            }
+            if (c.radius <= 0.0f) {
+                error = path + ":" + std::to_string(line_number) + ": radius must be positive";
+                return false;
+            }
+            add(c);
+        }
+        build();
+        return true;
+    }
+
+private:
+    static void resolve(PhysicsObject& obj, const StaticCollider& c)
+    {
+        const glm::vec4 offset = obj.position - c.center;
+        const float required = obj.radius + c.radius;
+        const float dist2 = glm::dot(offset, offset);
+        if (dist2 >= required * required) return;
+        const float dist = std::sqrt(dist2);
+        const glm::vec4 normal = dist > 1e-6f ? offset / dist : glm::vec4(0, 1, 0, 0);
+        obj.position = c.center + normal * required;
+        const glm::vec4 velocity = obj.position - obj.last_position;
+        obj.last_position = obj.position - (velocity - glm::dot(velocity, normal) * normal);
+    }
+
+    std::array<int32_t, 4> cellOf(const glm::vec4& p) const
+    {
+        return {static_cast<int32_t>(std::floor(p.x / m_cell)), static_cast<int32_t>(std::floor(p.y / m_cell)),
+                static_cast<int32_t>(std::floor(p.z / m_cell)), static_cast<int32_t>(std::floor(p.w / m_cell))};
+    }
+
+    // 16 bits per axis, ample for a bowl measured in cells
+    static uint64_t cellKey(const std::array<int32_t, 4>& c)
+    {
+        uint64_t key = 0;
+        for (int32_t v : c) key = (key << 16) | static_cast<uint16_t>(v + 32768);
+        return key;
+    }
+
+    std::vector<StaticCollider> m_colliders;
+    std::vector<uint64_t>       m_cell_keys;  // sorted, one per occupied cell
+    std::vector<uint32_t>       m_cell_start; // into m_items, with a final end marker
+    std::vector<uint32_t>       m_items;      // collider indices grouped by cell
+    float                       m_cell = 1.0f;
+    float                       m_max_radius = 0.0f;
+    bool                        m_built = false;
+};
@@ -1,43 +1,115 @@
 #pragma once
+#include <condition_variable>
 #include <functional>
 #include <queue>
 #include <vector>
 #include <thread>
 #include <mutex>
 #include <atomic>
+#include <memory>
+#include <algorithm>
+#include <string>
+#include <sstream>
 
-#ifdef __EMSCRIPTEN__
-// For web builds, disable threading and use synchronous execution
-#define WEB_BUILD
-#endif
+#include "cpu_topology.hpp"
+#include "pool_telemetry.hpp"
+#include "executor.hpp"
 
 namespace tp
 {
 
+struct QueuedTask
+{
+    std::function<void()> m_callback    = nullptr;
+    uint64_t              m_enqueued_ns = 0;
+};
+
+// Lets idle workers sleep instead of spinning. A worker that found no task for SPIN_NS
+// parks on a condition variable until the next submission. Workers read the epoch before
+// looking for work and submitters bump it after queueing, so a task queued between the
+// look and the park still wakes the worker. Submitters only take the mutex when someone sleeps.
+struct WorkerParking
+{
+    // Covers the gaps between the dispatches of one tick, so workers only park between ticks
+    static constexpr uint64_t SPIN_NS = 200000;
+
+    std::mutex              m_mutex;
+    std::condition_variable m_wake;
+    std::atomic<uint32_t>   m_epoch{0};
+    std::atomic<uint32_t>   m_sleepers{0};
+
+    uint32_t epoch() const { return m_epoch.load(); }
+
+    void notify(bool all = false)
+    {
+        m_epoch.fetch_add(1);
+        if (m_sleepers.load() == 0) return;
+        { std::lock_guard<std::mutex> lock_guard{m_mutex}; }
+        if (all) m_wake.notify_all();
+        else m_wake.notify_one();
+    }
+
+    // Sleeps until something was submitted after `seen` was read, or running turns false
+    void park(uint32_t seen, const std::atomic<bool>& running)
+    {
+        PROFILE_SCOPE("parked");
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_sleepers.fetch_add(1);
+        m_wake.wait(lock, [&]{ return m_epoch.load() != seen || !running; });
+        m_sleepers.fetch_sub(1);
+    }
+};
+
+// Spins (yielding) for WorkerParking::SPIN_NS after the last task, then parks
+struct IdleBackoff
+{
+    uint64_t m_empty_since = 0;
+
+    void idle(WorkerParking& parking, uint32_t seen, const std::atomic<bool>& running)
+    {
+        const uint64_t now = nowNs();
+        if (m_empty_since == 0) m_empty_since = now;
+        if (now - m_empty_since < WorkerParking::SPIN_NS) {
+            std::this_thread::yield();
+            return;
+        }
+        parking.park(seen, running);
+        m_empty_since = 0;
+    }
+
+    void busy() { m_empty_since = 0; }
+};
+
 struct TaskQueue
 {
-    std::queue<std::function<void()>> m_tasks;
+    std::queue<QueuedTask>            m_tasks;
     std::mutex                        m_mutex;
     std::atomic<uint32_t>             m_remaining_tasks = 0;
+    WorkerParking                     m_parking;
 
     template<typename TCallback>
     void addTask(TCallback&& callback)
     {
-        std::lock_guard<std::mutex> lock_guard{m_mutex};
-        m_tasks.push(std::forward<TCallback>(callback));
-        m_remaining_tasks++;
+        const uint64_t enqueued_ns = nowNs();
+        {
+            std::lock_guard<std::mutex> lock_guard{m_mutex};
+            m_tasks.push(QueuedTask{std::forward<TCallback>(callback), enqueued_ns});
+            m_remaining_tasks++;
+        }
+        m_parking.notify();
     }
 
-    void getTask(std::function<void()>& target_callback)
+    bool getTask(QueuedTask& target_task)
     {
         {
             std::lock_guard<std::mutex> lock_guard{m_mutex};
             if (m_tasks.empty()) {
-                return;
+                return false;
             }
-            target_callback = std::move(m_tasks.front());
+            target_task = std::move(m_tasks.front());
             m_tasks.pop();
         }
+        return true;
     }
 
     static void wait()
@@ -58,76 +130,56 @@ struct TaskQueue
     }
 };
 
-#ifdef WEB_BUILD
-// Web-compatible worker that doesn't use threads
-struct Worker
-{
-    uint32_t              m_id      = 0;
-    std::function<void()> m_task    = nullptr;
-    bool                  m_running = true;
-    TaskQueue*            m_queue   = nullptr;
-
-    Worker() = default;
-
-    Worker(TaskQueue& queue, uint32_t id)
-        : m_id{id}
-        , m_queue{&queue}
-    {
-        // No thread creation for web builds
-    }
-
-    void run()
-    {
-        // Synchronous execution for web builds
-        while (m_running) {
-            m_queue->getTask(m_task);
-            if (m_task == nullptr) {
-                break; // No more tasks
-            } else {
-                m_task();
-                m_queue->workDone();
-                m_task = nullptr;
-            }
-        }
-    }
-
-    void stop()
-    {
-        m_running = false;
-        // No thread to join in web builds
-    }
-};
-#else
 // Native worker with actual threading
 struct Worker
 {
     uint32_t              m_id      = 0;
     std::thread           m_thread;
-    std::function<void()> m_task    = nullptr;
-    bool                  m_running = true;
+    QueuedTask            m_task;
+    std::atomic<bool>     m_running{true};
     TaskQueue*            m_queue   = nullptr;
+    int                   m_pin_cpu = -1;    // requested cpu, -1 leaves placement to the OS
+    std::atomic<bool>     m_pinned{false};   // set by the worker thread, read by placementReport
+    std::atomic<int>      m_last_cpu{-1};    // cpu the last task ran on
+    WorkerCounters        m_counters;
 
     Worker() = default;
 
-    Worker(TaskQueue& queue, uint32_t id)
+    Worker(TaskQueue& queue, uint32_t id, int pin_cpu = -1)
         : m_id{id}
         , m_queue{&queue}
+        , m_pin_cpu{pin_cpu}
     {
         m_thread = std::thread([this](){
+            prof::setThreadName("pool worker " + std::to_string(m_id));
+            m_pinned.store(pinCurrentThread(m_pin_cpu), std::memory_order_relaxed);
+            m_last_cpu = currentCpu();
             run();
         });
     }
 
     void run()
     {
+        uint64_t idle_since = nowNs();
+        IdleBackoff backoff;
         while (m_running) {
-            m_queue->getTask(m_task);
-            if (m_task == nullptr) {
-                TaskQueue::wait();
+            const uint32_t seen = m_queue->m_parking.epoch();
+            if (!m_queue->getTask(m_task)) {
+                backoff.idle(m_queue->m_parking, seen, m_running);
             } else {
-                m_task();
+                backoff.busy();
+                const uint64_t start = nowNs();
+                {
+                    PROFILE_SCOPE("task");
+                    m_task.m_callback();
+                }
+                const uint64_t end = nowNs();
+                m_counters.recordIdle(start - idle_since);
+                m_counters.recordTask(start - m_task.m_enqueued_ns, end - start);
                 m_queue->workDone();
-                m_task = nullptr;
+                m_task.m_callback = nullptr;
+                m_last_cpu.store(currentCpu(), std::memory_order_relaxed);
+                idle_since = end;
             }
         }
     }
@@ -135,69 +187,120 @@ struct Worker
     void stop()
     {
         m_running = false;
+        m_queue->m_parking.notify(true);
         m_thread.join();
     }
 };
-#endif
 
-struct ThreadPool
+// Shared-queue pool: every worker pulls from one mutex-protected FIFO
+struct ThreadPool : Executor
 {
     uint32_t            m_thread_count = 0;
     TaskQueue           m_queue;
-    std::vector<Worker> m_workers;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    DispatchRecorder    m_dispatch_stats;
 
+    // pin_cpus[i] pins worker i to that logical cpu (-1 or a missing entry leaves it unpinned)
     explicit
-    ThreadPool(uint32_t thread_count)
+    ThreadPool(uint32_t thread_count, const std::vector<int>& pin_cpus = {})
         : m_thread_count{thread_count}
     {
         m_workers.reserve(thread_count);
         for (uint32_t i{thread_count}; i--;) {
-            m_workers.emplace_back(m_queue, static_cast<uint32_t>(m_workers.size()));
-        }
-        
-        #ifdef WEB_BUILD
-        // For web builds, run all workers synchronously
-        for (Worker& worker : m_workers) {
-            worker.run();
+            const size_t id = m_workers.size();
+            m_workers.push_back(std::make_unique<Worker>(m_queue, static_cast<uint32_t>(id), id < pin_cpus.size() ? pin_cpus[id] : -1));
         }
-        #endif
     }
 
-    virtual ~ThreadPool()
+    ~ThreadPool() override
     {
-        for (Worker& worker : m_workers) {
-            worker.stop();
+        for (auto& worker : m_workers) {
+            worker->stop();
         }
     }
 
-    template<typename TCallback>
-    void addTask(TCallback&& callback)
+    const char* name() const override { return "pool"; }
+    uint32_t threadCount() const override { return m_thread_count; }
+
+    void addTask(std::function<void()> callback) override
     {
-        m_queue.addTask(std::forward<TCallback>(callback));
+        m_queue.addTask(std::move(callback));
     }
 
-    void waitForCompletion() const
+    void waitForCompletion() override
     {
         m_queue.waitForCompletion();
     }
 
-    template<typename TCallback>
-    void dispatch(uint32_t element_count, TCallback&& callback)
+    // One line per worker: requested cpu, the cpu it last ran on and the core it belongs to
+    std::string placementReport(const CpuTopology& topo) const override
     {
-        const uint32_t batch_size = element_count / m_thread_count;
-        for (uint32_t i{0}; i < m_thread_count; ++i) {
-            const uint32_t start = batch_size * i;
-            const uint32_t end   = start + batch_size;
-            addTask([start, end, &callback](){ callback(start, end); });
+        std::stringstream ss;
+        for (const auto& worker_ptr : m_workers) {
+            const Worker& worker = *worker_ptr;
+            ss << "worker " << worker.m_id;
+            const int cpu = worker.m_last_cpu.load(std::memory_order_relaxed);
+            ss << (worker.m_pinned.load(std::memory_order_relaxed) ? " pinned to cpu " : " unpinned, on cpu ") << cpu;
+            if (const LogicalCpu* info = cpu >= 0 ? topo.find(static_cast<uint32_t>(cpu)) : nullptr) {
+                ss << " (pkg " << info->package_id << " core " << info->core_id
+                   << (info->kind == CoreKind::Efficiency ? " E" : " P")
+                   << (info->smt_index > 0 ? " smt" : "") << ")";
+            }
+            ss << "\n";
         }
+        return ss.str();
+    }
 
-        if (batch_size * m_thread_count < element_count) {
-            const uint32_t start = batch_size * m_thread_count;
-            callback(start, element_count);
+    // Snapshot of the worker counters and per-label dispatch statistics
+    PoolStats stats() const override
+    {
+        PoolStats out;
+        out.backend      = "pool";
+        out.thread_count = m_thread_count;
+        for (const auto& worker : m_workers) {
+            out.workers.push_back(worker->m_counters.load(worker->m_id));
         }
+        out.dispatches = m_dispatch_stats.snapshot();
+        return out;
+    }
 
-        waitForCompletion();
+    void resetStats() override
+    {
+        for (auto& worker : m_workers) {
+            worker->m_counters.reset();
+        }
+        m_dispatch_stats.reset();
+    }
+
+    void dispatch(uint32_t element_count,
+                  const std::function<void(uint32_t, uint32_t)>& callback,
+                  const char* label = "dispatch") override
+    {
+        const uint64_t dispatch_start = nowNs();
+
+        // Balanced split: chunk sizes differ by at most one element, so adding
+        // workers never leaves a large remainder for the calling thread
+        const uint32_t task_count = std::min(m_thread_count, element_count);
+        // per call, so concurrent or nested dispatches never share the chunk timings
+        std::vector<uint64_t> chunk_durations(task_count, 0);
+        for (uint32_t i{0}; i < task_count; ++i) {
+            const uint32_t start = static_cast<uint32_t>(static_cast<uint64_t>(element_count) * i / task_count);
+            const uint32_t end   = static_cast<uint32_t>(static_cast<uint64_t>(element_count) * (i + 1) / task_count);
+            uint64_t* chunk_ns = &chunk_durations[i];
+            addTask([start, end, chunk_ns, &callback, label](){
+                PROFILE_SCOPE(label);
+                const uint64_t chunk_start = nowNs();
+                callback(start, end);
+                *chunk_ns = nowNs() - chunk_start;
+            });
+        }
+
+        {
+            PROFILE_SCOPE("dispatch wait");
+            waitForCompletion();
+        }
+        m_dispatch_stats.record(label, chunk_durations.data(), chunk_durations.size(), nowNs() - dispatch_start);
     }
 };
 
-}
\ No newline at end of file
+}
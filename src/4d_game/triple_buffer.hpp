@@ -0,0 +1,45 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace tp
+{
+
+// Single producer / single consumer triple buffer. The writer always has a private
+// back slot, the reader a private front slot, and the third slot is swapped between
+// them with one atomic exchange. Neither side ever waits for the other; the reader
+// simply keeps the last value until a newer one has been published.
+template <typename T>
+struct TripleBuffer
+{
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t FRESH_BIT  = 0x4; // set when the shared slot holds an unread value
+
+    T                    m_slots[3];
+    uint8_t              m_back  = 0; // owned by the writer
+    uint8_t              m_front = 1; // owned by the reader
+    std::atomic<uint8_t> m_shared{2};
+
+    // Writer side: fill back(), then publish()
+    T& back() { return m_slots[m_back]; }
+
+    void publish()
+    {
+        m_back = m_shared.exchange(static_cast<uint8_t>(m_back | FRESH_BIT), std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Reader side: true when update() would replace front()
+    bool fresh() const { return (m_shared.load(std::memory_order_relaxed) & FRESH_BIT) != 0; }
+
+    // Reader side: returns true when front() changed
+    bool update()
+    {
+        if (!(m_shared.load(std::memory_order_relaxed) & FRESH_BIT)) return false;
+        m_front = m_shared.exchange(m_front, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    const T& front() const { return m_slots[m_front]; }
+};
+
+}
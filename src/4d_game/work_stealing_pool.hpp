@@ -0,0 +1,241 @@
+#pragma once
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <sstream>
+#include <vector>
+
+#include "threadpool.hpp"
+
+namespace tp
+{
+
+// Per-worker deque: the owner pops from the back (most recently pushed, still hot in
+// cache), thieves take from the front. A small mutex per deque keeps this simple; the
+// locks are almost never contended because every worker mostly touches its own deque.
+struct StealingQueue
+{
+    std::deque<QueuedTask> m_tasks;
+    std::mutex             m_mutex;
+
+    void push(QueuedTask&& task)
+    {
+        std::lock_guard<std::mutex> lock_guard{m_mutex};
+        m_tasks.push_back(std::move(task));
+    }
+
+    bool pop(QueuedTask& target_task)
+    {
+        std::lock_guard<std::mutex> lock_guard{m_mutex};
+        if (m_tasks.empty()) return false;
+        target_task = std::move(m_tasks.back());
+        m_tasks.pop_back();
+        return true;
+    }
+
+    bool steal(QueuedTask& target_task)
+    {
+        std::lock_guard<std::mutex> lock_guard{m_mutex};
+        if (m_tasks.empty()) return false;
+        target_task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+        return true;
+    }
+};
+
+struct WorkStealingPool : Executor
+{
+    struct StealingWorker
+    {
+        uint32_t          m_id      = 0;
+        std::thread       m_thread;
+        std::atomic<bool> m_running{true};
+        int               m_pin_cpu = -1;
+        std::atomic<bool> m_pinned{false};
+        std::atomic<int>  m_last_cpu{-1};
+        WorkerCounters    m_counters;
+    };
+
+    // dispatch() cuts work into this many chunks per thread so that thieves have
+    // something to take when one chunk turns out to be expensive
+    static constexpr uint32_t CHUNKS_PER_THREAD = 4;
+
+    uint32_t                                     m_thread_count = 0;
+    std::vector<std::unique_ptr<StealingQueue>>  m_queues;
+    std::vector<std::unique_ptr<StealingWorker>> m_workers;
+    std::atomic<uint32_t>                        m_remaining_tasks{0};
+    std::atomic<uint32_t>                        m_next_queue{0};
+    WorkerParking                                m_parking;
+    DispatchRecorder                             m_dispatch_stats;
+
+    explicit
+    WorkStealingPool(uint32_t thread_count, const std::vector<int>& pin_cpus = {})
+        : m_thread_count{std::max(1u, thread_count)}
+    {
+        for (uint32_t i = 0; i < m_thread_count; ++i) {
+            m_queues.push_back(std::make_unique<StealingQueue>());
+        }
+        for (uint32_t i = 0; i < m_thread_count; ++i) {
+            auto worker = std::make_unique<StealingWorker>();
+            worker->m_id      = i;
+            worker->m_pin_cpu = i < pin_cpus.size() ? pin_cpus[i] : -1;
+            StealingWorker* raw = worker.get();
+            m_workers.push_back(std::move(worker));
+            raw->m_thread = std::thread([this, raw](){
+                prof::setThreadName("steal worker " + std::to_string(raw->m_id));
+                raw->m_pinned.store(pinCurrentThread(raw->m_pin_cpu), std::memory_order_relaxed);
+                raw->m_last_cpu = currentCpu();
+                run(*raw);
+            });
+        }
+    }
+
+    ~WorkStealingPool() override
+    {
+        for (auto& worker : m_workers) {
+            worker->m_running = false;
+        }
+        m_parking.notify(true);
+        for (auto& worker : m_workers) {
+            worker->m_thread.join();
+        }
+    }
+
+    const char* name() const override { return "steal"; }
+    uint32_t threadCount() const override { return m_thread_count; }
+
+    void addTask(std::function<void()> callback) override
+    {
+        // Round-robin external submissions over the worker deques
+        const uint32_t target = m_next_queue.fetch_add(1, std::memory_order_relaxed) % m_thread_count;
+        m_remaining_tasks++;
+        m_queues[target]->push(QueuedTask{std::move(callback), nowNs()});
+        m_parking.notify();
+    }
+
+    // The calling thread helps by stealing instead of spinning idle
+    void waitForCompletion() override
+    {
+        QueuedTask task;
+        uint32_t victim = 0;
+        while (m_remaining_tasks > 0) {
+            if (m_queues[victim]->steal(task)) {
+                PROFILE_SCOPE("task (caller)");
+                task.m_callback();
+                task.m_callback = nullptr;
+                m_remaining_tasks--;
+            } else {
+                victim = (victim + 1) % m_thread_count;
+                if (victim == 0) std::this_thread::yield();
+            }
+        }
+    }
+
+    void dispatch(uint32_t element_count,
+                  const std::function<void(uint32_t, uint32_t)>& callback,
+                  const char* label = "dispatch") override
+    {
+        const uint64_t dispatch_start = nowNs();
+
+        const uint32_t task_count = std::min(m_thread_count * CHUNKS_PER_THREAD, element_count);
+        // per call, so concurrent or nested dispatches never share the chunk timings
+        std::vector<uint64_t> chunk_durations(task_count, 0);
+        for (uint32_t i{0}; i < task_count; ++i) {
+            const uint32_t start = static_cast<uint32_t>(static_cast<uint64_t>(element_count) * i / task_count);
+            const uint32_t end   = static_cast<uint32_t>(static_cast<uint64_t>(element_count) * (i + 1) / task_count);
+            uint64_t* chunk_ns = &chunk_durations[i];
+            // contiguous chunks land on the same deque so each worker starts on neighbouring data
+            const uint32_t target = static_cast<uint32_t>(static_cast<uint64_t>(i) * m_thread_count / task_count);
+            m_remaining_tasks++;
+            m_queues[target]->push(QueuedTask{[start, end, chunk_ns, &callback, label](){
+                PROFILE_SCOPE(label);
+                const uint64_t chunk_start = nowNs();
+                callback(start, end);
+                *chunk_ns = nowNs() - chunk_start;
+            }, dispatch_start});
+        }
+        m_parking.notify(true);
+
+        {
+            PROFILE_SCOPE("dispatch wait");
+            waitForCompletion();
+        }
+        m_dispatch_stats.record(label, chunk_durations.data(), chunk_durations.size(), nowNs() - dispatch_start);
+    }
+
+    PoolStats stats() const override
+    {
+        PoolStats out;
+        out.backend      = name();
+        out.thread_count = m_thread_count;
+        for (const auto& worker : m_workers) {
+            out.workers.push_back(worker->m_counters.load(worker->m_id));
+        }
+        out.dispatches = m_dispatch_stats.snapshot();
+        return out;
+    }
+
+    void resetStats() override
+    {
+        for (auto& worker : m_workers) {
+            worker->m_counters.reset();
+        }
+        m_dispatch_stats.reset();
+    }
+
+    std::string placementReport(const CpuTopology& topo) const override
+    {
+        std::stringstream ss;
+        for (const auto& worker : m_workers) {
+            const int cpu = worker->m_last_cpu.load(std::memory_order_relaxed);
+            ss << "steal worker " << worker->m_id
+               << (worker->m_pinned.load(std::memory_order_relaxed) ? " pinned to cpu " : " unpinned, on cpu ") << cpu;
+            if (const LogicalCpu* info = cpu >= 0 ? topo.find(static_cast<uint32_t>(cpu)) : nullptr) {
+                ss << " (pkg " << info->package_id << " core " << info->core_id
+                   << (info->kind == CoreKind::Efficiency ? " E" : " P") << ")";
+            }
+            ss << "\n";
+        }
+        return ss.str();
+    }
+
+private:
+    void run(StealingWorker& self)
+    {
+        StealingQueue& own = *m_queues[self.m_id];
+        QueuedTask task;
+        uint64_t idle_since = nowNs();
+        IdleBackoff backoff;
+        while (self.m_running) {
+            const uint32_t seen = m_parking.epoch();
+            bool found = own.pop(task);
+            for (uint32_t k = 1; !found && k < m_thread_count; ++k) {
+                found = m_queues[(self.m_id + k) % m_thread_count]->steal(task);
+                if (found) self.m_counters.recordSteal();
+            }
+            if (!found) {
+                backoff.idle(m_parking, seen, self.m_running);
+                continue;
+            }
+            backoff.busy();
+
+            const uint64_t start = nowNs();
+            {
+                PROFILE_SCOPE("task");
+                task.m_callback();
+            }
+            const uint64_t end = nowNs();
+            task.m_callback = nullptr;
+            self.m_counters.recordIdle(start - idle_since);
+            self.m_counters.recordTask(start - task.m_enqueued_ns, end - start);
+            self.m_last_cpu.store(currentCpu(), std::memory_order_relaxed);
+            m_remaining_tasks--;
+            idle_since = end;
+        }
+    }
+};
+
+}
@@ -0,0 +1,154 @@
+/*******************************************************************
+** Throughput benchmark for the batched multi-world solver.
+**
+** Steps thousands of independent bowls in lockstep with random
+** drops (a world that loses a fruit over the rim starts over) and
+** reports fruit-steps per second. A few worlds are mirrored on
+** serial PhysicSolvers fed the same drops, and their final states
+** must match the batch bit for bit.
+**
+** usage: batch_bench [--worlds N] [--ticks N] [--backend serial|pool|steal]
+**                    [--threads N] [--validate N] [--json out.json]
+******************************************************************/
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "executor_factory.hpp"
+#include "batch_solver.hpp"
+#include "replay.hpp"
+
+namespace
+{
+
+const float DROP_SECONDS = 0.5f;
+const float LOSS_Y = -3.0f;
+
+std::unique_ptr<tp::Executor> makeBackend(const std::string& backend, uint32_t threads)
+{
+    tp::ThreadPlacement placement;
+    placement.worker_cpus.assign(threads, -1);
+    return tp::makeExecutor(backend, placement);
+}
+
+// Random drop of a random small fruit anywhere over the bowl
+PhysicsObject randomDrop(Pcg32& rng, const HemisphereBoundary& bowl)
+{
+    const Fruit fruit = randomDropFruit(rng);
+    const float reach = bowl.radius - bowl.margin - fruitPhysics(fruit).radius;
+    auto unit = [&rng]() { return static_cast<float>(rng.next()) * (2.0f / 4294967296.0f) - 1.0f; };
+    for (;;) {
+        const glm::vec3 p(unit(), unit(), unit());
+        if (glm::dot(p, p) > 1.0f) continue;
+        return PhysicsObject(glm::vec4(p.x * reach, 3.0f, p.y * reach, p.z * reach), fruit, true, false);
+    }
+}
+
+bool lost(const SolverState& state)
+{
+    for (int i = 0; i < MAX_OBJECTS; ++i) {
+        if (state.has_obj[i] && state.objects[i].position.y < LOSS_Y) return true;
+    }
+    return false;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t worlds = 4096;
+    uint32_t ticks = 600;
+    uint32_t validate = 4;
+    uint32_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string backend = "steal";
+    std::string json_path;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--worlds") && i + 1 < argc) worlds = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--ticks") && i + 1 < argc) ticks = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--backend") && i + 1 < argc) backend = argv[++i];
+        else if (!std::strcmp(argv[i], "--threads") && i + 1 < argc) threads = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--validate") && i + 1 < argc) validate = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--json") && i + 1 < argc) json_path = argv[++i];
+        else {
+            std::cerr << "usage: " << argv[0] << " [--worlds N] [--ticks N] [--backend serial|pool|steal]"
+                      << " [--threads N] [--validate N] [--json out.json]" << std::endl;
+            return 1;
+        }
+    }
+    worlds = std::max(1u, worlds);
+    validate = std::min(validate, worlds);
+
+    std::unique_ptr<tp::Executor> executor = makeBackend(backend, threads);
+    HemisphereBoundary bowl(glm::vec4(0.0f), 3, 90.0f, 0.1f); // same bowl as the game
+    BatchSolver batch(*executor, worlds, bowl);
+
+    // Reference solvers for the validated worlds
+    tp::SerialExecutor serial(false);
+    std::vector<std::unique_ptr<PhysicSolver>> reference;
+    for (uint32_t w = 0; w < validate; ++w) reference.push_back(std::make_unique<PhysicSolver>(serial, &bowl));
+
+    std::vector<Pcg32> rngs;
+    for (uint32_t w = 0; w < worlds; ++w) rngs.emplace_back(1234, w);
+
+    const uint32_t drop_ticks = static_cast<uint32_t>(DROP_SECONDS / PHYSICS_TIMESTEP + 0.5f);
+    SolverState state;
+    uint64_t games_lost = 0;
+    double step_seconds = 0.0;
+    for (uint32_t t = 0; t < ticks; ++t) {
+        // Drops and restarts are applied between timed updates
+        if (t % drop_ticks == 0) {
+            for (uint32_t w = 0; w < worlds; ++w) {
+                batch.saveWorld(w, state);
+                if (lost(state)) {
+                    batch.clearWorld(w);
+                    if (w < validate) reference[w]->clear();
+                    ++games_lost;
+                }
+                const PhysicsObject drop = randomDrop(rngs[w], bowl);
+                batch.addObject(w, drop);
+                if (w < validate) reference[w]->addObject(drop);
+            }
+        }
+        const auto start = std::chrono::steady_clock::now();
+        batch.update(PHYSICS_TIMESTEP);
+        step_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        for (const auto& solver : reference) solver->update(PHYSICS_TIMESTEP);
+    }
+
+    uint32_t mismatches = 0;
+    PhysicSolver check(serial, &bowl);
+    for (uint32_t w = 0; w < validate; ++w) {
+        batch.saveWorld(w, state);
+        check.loadState(state);
+        if (solverChecksum(check) != solverChecksum(*reference[w])) ++mismatches;
+    }
+
+    uint64_t fruits = 0;
+    for (uint32_t w = 0; w < worlds; ++w) fruits += batch.objectCount(w);
+    const double fruit_steps_per_sec = step_seconds > 0.0 ? batch.fruitSteps() / step_seconds : 0.0;
+    std::printf("%u worlds x %u ticks on %s x%u: %llu fruit-steps in %.1f ms, %.2fM fruit-steps/s, %.1f us per world tick\n",
+                worlds, ticks, executor->name(), executor->threadCount(),
+                static_cast<unsigned long long>(batch.fruitSteps()), step_seconds * 1000.0, fruit_steps_per_sec / 1e6,
+                step_seconds * 1e6 / (static_cast<double>(worlds) * ticks));
+    std::printf("%.1f fruits per world at the end, %llu games lost, %u/%u validated worlds match the serial solver\n",
+                static_cast<double>(fruits) / worlds, static_cast<unsigned long long>(games_lost), validate - mismatches, validate);
+
+    if (!json_path.empty()) {
+        std::ofstream out(json_path);
+        out << "{\"worlds\": " << worlds << ", \"ticks\": " << ticks << ", \"backend\": \"" << executor->name()
+            << "\", \"threads\": " << executor->threadCount() << ", \"fruit_steps\": " << batch.fruitSteps()
+            << ", \"seconds\": " << step_seconds << ", \"fruit_steps_per_sec\": " << fruit_steps_per_sec
+            << ", \"mismatches\": " << mismatches << "}\n";
+        std::cout << "wrote " << json_path << std::endl;
+    }
+    return mismatches == 0 ? 0 : 2;
+}
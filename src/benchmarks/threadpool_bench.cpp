@@ -0,0 +1,247 @@
+/*******************************************************************
+** Micro-benchmarks for the task executors in src/4d_game.
+**
+** Measures per-call cost of dispatch / addTask / waitForCompletion,
+** tiny-task throughput, fork-join overhead and scaling over 1..N
+** threads for every backend, so scheduler changes can be compared
+** before they touch the physics.
+**
+** usage: threadpool_bench [--backend serial|pool|steal|all]
+**                         [--max-threads N] [--quick] [--json out.json]
+******************************************************************/
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "executor_factory.hpp"
+
+namespace
+{
+
+struct Sample
+{
+    double median = 0.0;
+    double p99    = 0.0;
+};
+
+Sample summarize(std::vector<double> values)
+{
+    Sample out;
+    if (values.empty()) return out;
+    std::sort(values.begin(), values.end());
+    out.median = values[values.size() / 2];
+    out.p99    = values[std::min(values.size() - 1, values.size() * 99 / 100)];
+    return out;
+}
+
+// Busy work with a predictable cost that the optimiser cannot drop
+inline uint64_t spin(uint32_t iterations, uint64_t seed)
+{
+    uint64_t x = seed | 1;
+    for (uint32_t i = 0; i < iterations; ++i) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+    }
+    return x;
+}
+
+std::atomic<uint64_t> g_sink{0};
+
+std::unique_ptr<tp::Executor> makeBackend(const std::string& backend, uint32_t threads)
+{
+    tp::ThreadPlacement placement;
+    placement.worker_cpus.assign(threads, -1);
+    return tp::makeExecutor(backend, placement);
+}
+
+struct Result
+{
+    std::string backend;
+    uint32_t    threads = 0;
+    Sample      empty_dispatch_ns;
+    Sample      add_task_ns;
+    Sample      wait_ns;
+    double      tiny_tasks_per_sec = 0.0;
+    Sample      fork_join_overhead_ns;
+    double      work_ms            = 0.0; // fixed workload, used for the scaling curve
+    std::string pool_stats;               // executor telemetry for the pairs workload
+};
+
+Result run(const std::string& backend, uint32_t threads, bool quick)
+{
+    const uint32_t reps = quick ? 200 : 2000;
+    auto executor = makeBackend(backend, threads);
+
+    Result result;
+    result.backend = executor->name();
+    result.threads = executor->threadCount();
+
+    // 1. empty dispatch: pure scheduling and join cost
+    {
+        std::vector<double> samples;
+        for (uint32_t r = 0; r < reps; ++r) {
+            const uint64_t start = tp::nowNs();
+            executor->dispatch(threads, [](uint32_t, uint32_t) {}, "empty");
+            samples.push_back(static_cast<double>(tp::nowNs() - start));
+        }
+        result.empty_dispatch_ns = summarize(samples);
+    }
+
+    // 2. addTask and waitForCompletion measured separately, batches of 64 tiny tasks
+    {
+        const uint32_t batch = 64;
+        std::vector<double> add_samples, wait_samples;
+        std::atomic<uint64_t> counter{0};
+        const uint64_t throughput_start = tp::nowNs();
+        for (uint32_t r = 0; r < reps / 4 + 1; ++r) {
+            const uint64_t start = tp::nowNs();
+            for (uint32_t i = 0; i < batch; ++i) {
+                executor->addTask([&counter]() { counter.fetch_add(1, std::memory_order_relaxed); });
+            }
+            const uint64_t added = tp::nowNs();
+            executor->waitForCompletion();
+            const uint64_t done = tp::nowNs();
+            add_samples.push_back(static_cast<double>(added - start) / batch);
+            wait_samples.push_back(static_cast<double>(done - added));
+        }
+        const double seconds = static_cast<double>(tp::nowNs() - throughput_start) * 1e-9;
+        result.add_task_ns        = summarize(add_samples);
+        result.wait_ns            = summarize(wait_samples);
+        result.tiny_tasks_per_sec = seconds > 0.0 ? static_cast<double>(counter.load()) / seconds : 0.0;
+    }
+
+    // 3. fork-join overhead: wall time minus the ideal share of a known amount of work
+    {
+        const uint32_t items = 4096, cost = 200;
+        std::atomic<uint64_t> local{0};
+        const std::function<void(uint32_t, uint32_t)> work = [&](uint32_t begin, uint32_t end) {
+            uint64_t sum = 0;
+            for (uint32_t i = begin; i < end; ++i) sum += spin(cost, i);
+            local += sum;
+        };
+        // the same callable run inline gives the cost without any scheduling
+        const uint64_t serial_start = tp::nowNs();
+        work(0, items);
+        const double serial_ns = static_cast<double>(tp::nowNs() - serial_start);
+        const uint32_t usable = std::min(threads, std::max(1u, std::thread::hardware_concurrency()));
+
+        std::vector<double> samples;
+        for (uint32_t r = 0; r < reps / 10 + 1; ++r) {
+            const uint64_t start = tp::nowNs();
+            executor->dispatch(items, work, "fork_join");
+            const double elapsed = static_cast<double>(tp::nowNs() - start);
+            samples.push_back(std::max(0.0, elapsed - serial_ns / usable));
+        }
+        g_sink += local;
+        result.fork_join_overhead_ns = summarize(samples);
+    }
+
+    // 4. fixed workload shaped like solveCollisions (4950 pairs, uneven cost per pair)
+    {
+        const uint32_t pairs = 4950;
+        const uint32_t rounds = quick ? 20 : 100;
+        executor->resetStats();
+        const uint64_t start = tp::nowNs();
+        for (uint32_t r = 0; r < rounds; ++r) {
+            std::atomic<uint64_t> local{0};
+            executor->dispatch(pairs, [&](uint32_t begin, uint32_t end) {
+                uint64_t sum = 0;
+                for (uint32_t k = begin; k < end; ++k) sum += spin(20 + (k % 97), k);
+                local += sum;
+            }, "pairs");
+            g_sink += local;
+        }
+        result.work_ms = static_cast<double>(tp::nowNs() - start) * 1e-6 / rounds;
+        result.pool_stats = executor->stats().toJson();
+    }
+
+    return result;
+}
+
+std::string toJson(const std::vector<Result>& results)
+{
+    std::stringstream ss;
+    ss << "[";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        ss << (i ? ",\n " : "") << "{\"backend\":\"" << r.backend << "\",\"threads\":" << r.threads
+           << ",\"empty_dispatch_ns\":{\"median\":" << r.empty_dispatch_ns.median << ",\"p99\":" << r.empty_dispatch_ns.p99 << "}"
+           << ",\"add_task_ns\":{\"median\":" << r.add_task_ns.median << ",\"p99\":" << r.add_task_ns.p99 << "}"
+           << ",\"wait_ns\":{\"median\":" << r.wait_ns.median << ",\"p99\":" << r.wait_ns.p99 << "}"
+           << ",\"tiny_tasks_per_sec\":" << r.tiny_tasks_per_sec
+           << ",\"fork_join_overhead_ns\":{\"median\":" << r.fork_join_overhead_ns.median << ",\"p99\":" << r.fork_join_overhead_ns.p99 << "}"
+           << ",\"pairs_workload_ms\":" << r.work_ms << ",\"pool_stats\":" << r.pool_stats << "}";
+    }
+    ss << "]\n";
+    return ss.str();
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    std::string backend = "all";
+    std::string json_path;
+    uint32_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    bool quick = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--backend") && i + 1 < argc) backend = argv[++i];
+        else if (!std::strcmp(argv[i], "--max-threads") && i + 1 < argc) max_threads = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--json") && i + 1 < argc) json_path = argv[++i];
+        else if (!std::strcmp(argv[i], "--quick")) quick = true;
+        else {
+            std::cerr << "usage: " << argv[0] << " [--backend serial|pool|steal|all] [--max-threads N] [--quick] [--json out.json]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<std::string> backends;
+    if (backend == "all") backends = {"serial", "pool", "steal"};
+    else backends = {backend};
+
+    std::vector<Result> results;
+    std::printf("%-7s %4s %16s %16s %14s %14s %18s %12s %8s\n",
+                "backend", "thr", "empty disp (ns)", "addTask (ns)", "wait64 (ns)", "tiny task/s",
+                "fork-join ovh (ns)", "pairs (ms)", "speedup");
+    for (const std::string& name : backends) {
+        double baseline_ms = 0.0;
+        // 1, 2, 3, 4, 8, 16... and always --max-threads itself, so any pool size can be measured
+        for (uint32_t threads = 1; threads <= max_threads;) {
+            if (name == "serial" && threads > 1) break;
+            Result r = run(name, threads, quick);
+            if (baseline_ms == 0.0) baseline_ms = r.work_ms;
+            std::printf("%-7s %4u %9.0f/%-6.0f %9.1f/%-6.1f %7.0f/%-6.0f %14.0f %11.0f/%-6.0f %12.3f %7.2fx\n",
+                        r.backend.c_str(), r.threads,
+                        r.empty_dispatch_ns.median, r.empty_dispatch_ns.p99,
+                        r.add_task_ns.median, r.add_task_ns.p99,
+                        r.wait_ns.median, r.wait_ns.p99,
+                        r.tiny_tasks_per_sec,
+                        r.fork_join_overhead_ns.median, r.fork_join_overhead_ns.p99,
+                        r.work_ms, baseline_ms / r.work_ms);
+            results.push_back(r);
+            if (threads == max_threads) break;
+            const uint32_t next = threads < 4 ? threads + 1 : threads * 2;
+            threads = next > max_threads ? max_threads : next;
+        }
+    }
+    std::printf("(median/p99; speedup is relative to the same backend at its lowest thread count)\n");
+
+    if (!json_path.empty()) {
+        std::ofstream out(json_path);
+        out << toJson(results);
+        std::cout << "wrote " << json_path << std::endl;
+    }
+    return g_sink.load() == 42 ? 2 : 0;
+}
@@ -0,0 +1,212 @@
+/*******************************************************************
+** libsuika4d: C API over BatchSolver (see suika4d.h).
+******************************************************************/
+#define SUIKA4D_BUILD
+#include "suika4d.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <thread>
+
+#include "batch_solver.hpp"
+#include "executor_factory.hpp"
+
+static_assert(S4D_SLOTS_PER_BOWL == MAX_OBJECTS, "S4D_SLOTS_PER_BOWL must match MAX_OBJECTS");
+static_assert(S4D_FRUIT_COUNT == FRUIT_COUNT, "S4D_FRUIT_COUNT must match FRUIT_COUNT");
+static_assert(S4D_EVENTS_PER_BOWL == BatchSolver::EVENT_QUEUE_CAPACITY, "S4D_EVENTS_PER_BOWL must match BatchSolver");
+static_assert(S4D_SLOT_PRESENT == BatchSolver::PRESENT && S4D_SLOT_GROWING == BatchSolver::GROWING, "slot flags must match BatchSolver");
+
+struct s4d_world
+{
+    std::unique_ptr<tp::Executor> executor;
+    HemisphereBoundary            bowl{glm::vec4(0.0f), 3, 90.0f, 0.1f}; // same bowl as the game
+    std::unique_ptr<BatchSolver>  solver;
+    std::vector<BatchEvent>       scratch; // drained events before conversion
+};
+
+namespace
+{
+
+bool validRange(const s4d_world* world, uint32_t first, uint32_t count)
+{
+    return world && first <= world->solver->worldCount() && count <= world->solver->worldCount() - first;
+}
+
+// Exceptions must not cross the C boundary
+template <typename F>
+int32_t guarded(F&& f)
+{
+    try {
+        return f();
+    } catch (const std::bad_alloc&) {
+        return S4D_ERROR_MEMORY;
+    } catch (...) {
+        return S4D_ERROR_ARGUMENT;
+    }
+}
+
+}
+
+extern "C" {
+
+uint32_t s4d_api_version(void)
+{
+    return S4D_API_VERSION;
+}
+
+const char* s4d_status_string(int32_t status)
+{
+    switch (status) {
+        case S4D_ERROR_ARGUMENT: return "invalid argument";
+        case S4D_ERROR_MEMORY:   return "out of memory";
+        default:                 return status >= 0 ? "ok" : "unknown error";
+    }
+}
+
+s4d_world* s4d_world_create(uint32_t bowl_count, uint32_t thread_count)
+{
+    if (bowl_count == 0) return nullptr;
+    try {
+        std::unique_ptr<s4d_world> world(new s4d_world);
+        tp::ThreadPlacement placement;
+        placement.worker_cpus.assign(thread_count ? thread_count : std::max(1u, std::thread::hardware_concurrency()), -1);
+        // pool workers park once a step is done, so a world the host is not stepping stays idle
+        world->executor = tp::makeExecutor("", placement);
+        world->solver = std::make_unique<BatchSolver>(*world->executor, bowl_count, world->bowl);
+        world->solver->recordEvents(true);
+        return world.release();
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void s4d_world_destroy(s4d_world* world)
+{
+    delete world;
+}
+
+uint32_t s4d_world_bowl_count(const s4d_world* world)
+{
+    return world ? world->solver->worldCount() : 0;
+}
+
+uint64_t s4d_world_tick(const s4d_world* world)
+{
+    return world ? world->solver->tick() : 0;
+}
+
+int32_t s4d_set_boundaries(s4d_world* world, uint32_t first, uint32_t count, const s4d_boundary* boundaries)
+{
+    if (!validRange(world, first, count) || (count && !boundaries)) return S4D_ERROR_ARGUMENT;
+    for (uint32_t i = 0; i < count; ++i) {
+        const s4d_boundary& b = boundaries[i];
+        if (!(b.radius > 0.0f) || b.margin < 0.0f) return S4D_ERROR_ARGUMENT;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        const s4d_boundary& b = boundaries[i];
+        const HemisphereBoundary bowl(glm::vec4(b.center[0], b.center[1], b.center[2], b.center[3]), b.radius, b.angle_degrees, b.margin);
+        world->solver->setBowl(first + i, bowl);
+    }
+    return S4D_OK;
+}
+
+int32_t s4d_reset_bowls(s4d_world* world, uint32_t first, uint32_t count)
+{
+    if (!validRange(world, first, count)) return S4D_ERROR_ARGUMENT;
+    for (uint32_t i = 0; i < count; ++i) world->solver->clearWorld(first + i);
+    return S4D_OK;
+}
+
+int32_t s4d_drop_fruits(s4d_world* world, const s4d_drop* drops, uint32_t count)
+{
+    if (!world || (count && !drops)) return S4D_ERROR_ARGUMENT;
+    // validate the whole batch first so that a bad entry places nothing
+    for (uint32_t i = 0; i < count; ++i) {
+        if (drops[i].bowl >= world->solver->worldCount() || drops[i].fruit >= S4D_FRUIT_COUNT) return S4D_ERROR_ARGUMENT;
+    }
+    int32_t placed = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        const s4d_drop& d = drops[i];
+        const glm::vec4 position(d.position[0], d.position[1], d.position[2], d.position[3]);
+        placed += world->solver->addObject(d.bowl, PhysicsObject(position, static_cast<Fruit>(d.fruit), true, false)) ? 1 : 0;
+    }
+    return placed;
+}
+
+int32_t s4d_step(s4d_world* world, uint32_t ticks)
+{
+    if (!world) return S4D_ERROR_ARGUMENT;
+    return guarded([&]() {
+        for (uint32_t t = 0; t < ticks; ++t) world->solver->update(PHYSICS_TIMESTEP);
+        return static_cast<int32_t>(S4D_OK);
+    });
+}
+
+int32_t s4d_read_state(const s4d_world* world, uint32_t first, uint32_t count, const s4d_state_buffers* out)
+{
+    if (!validRange(world, first, count) || !out) return S4D_ERROR_ARGUMENT;
+    const BatchSolver& solver = *world->solver;
+    const size_t begin = static_cast<size_t>(first) * MAX_OBJECTS;
+    const size_t slots = static_cast<size_t>(count) * MAX_OBJECTS;
+    for (size_t s = 0; s < slots; ++s) {
+        const size_t k = begin + s;
+        const bool present = (solver.flags[k] & BatchSolver::PRESENT) != 0;
+        if (out->positions) {
+            float* p = out->positions + 4 * s;
+            p[0] = present ? solver.px[k] : 0.0f;
+            p[1] = present ? solver.py[k] : 0.0f;
+            p[2] = present ? solver.pz[k] : 0.0f;
+            p[3] = present ? solver.pw[k] : 0.0f;
+        }
+        if (out->radii) out->radii[s] = present ? solver.radius[k] : 0.0f;
+        if (out->fruits) out->fruits[s] = present ? solver.fruit[k] : 0;
+        if (out->flags) out->flags[s] = present ? (solver.flags[k] & (BatchSolver::PRESENT | BatchSolver::GROWING)) : 0;
+    }
+    for (uint32_t b = 0; b < count; ++b) {
+        if (out->points) out->points[b] = solver.points(first + b);
+        if (out->fruit_counts) out->fruit_counts[b] = solver.objectCount(first + b);
+    }
+    return S4D_OK;
+}
+
+int32_t s4d_read_events(s4d_world* world, s4d_event* out, uint32_t capacity)
+{
+    if (!world || (capacity && !out)) return S4D_ERROR_ARGUMENT;
+    return guarded([&]() {
+        const uint32_t limit = static_cast<uint32_t>(std::min<size_t>(capacity, INT32_MAX));
+        world->scratch.resize(std::min<size_t>(limit, world->solver->pendingEvents()));
+        const size_t n = world->solver->drainEvents(world->scratch.data(), world->scratch.size());
+        for (size_t i = 0; i < n; ++i) {
+            const BatchEvent& e = world->scratch[i];
+            s4d_event& dst = out[i];
+            dst.tick  = e.tick;
+            dst.bowl  = e.world;
+            dst.slot  = e.slot;
+            dst.type  = e.type == BatchEventType::Merge ? S4D_EVENT_MERGE : S4D_EVENT_LOST;
+            dst.fruit = static_cast<uint32_t>(e.fruit);
+            std::memcpy(dst.position, &e.position[0], sizeof(dst.position));
+        }
+        return static_cast<int32_t>(n);
+    });
+}
+
+uint32_t s4d_pending_events(const s4d_world* world)
+{
+    return world ? static_cast<uint32_t>(std::min<size_t>(world->solver->pendingEvents(), UINT32_MAX)) : 0;
+}
+
+int32_t s4d_record_events(s4d_world* world, int32_t enabled)
+{
+    if (!world) return S4D_ERROR_ARGUMENT;
+    world->solver->recordEvents(enabled != 0);
+    return S4D_OK;
+}
+
+uint64_t s4d_dropped_events(const s4d_world* world)
+{
+    return world ? world->solver->droppedEvents() : 0;
+}
+
+}
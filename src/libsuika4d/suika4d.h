@@ -0,0 +1,140 @@
+/*******************************************************************
+** libsuika4d: C API of the Suika 4D simulation core.
+**
+** Drives the 4D fruit physics without GLFW, SDL or the game. A world
+** holds any number of independent bowls that step together; every
+** call works on a range of bowls or a list of drops, so the per-call
+** overhead is paid once per batch, not once per bowl or fruit, when
+** the library is driven from a foreign runtime.
+**
+** Results are written into buffers the caller owns; the library never
+** allocates memory the caller has to free and keeps no pointers to
+** them after a call returns. Struct layouts and function signatures
+** only change together with S4D_API_VERSION.
+**
+** A world must not be used from two threads at the same time.
+******************************************************************/
+#ifndef SUIKA4D_H
+#define SUIKA4D_H
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#  if defined(SUIKA4D_BUILD)
+#    define S4D_API __declspec(dllexport)
+#  else
+#    define S4D_API __declspec(dllimport)
+#  endif
+#else
+#  define S4D_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define S4D_API_VERSION 1
+
+/* Fruit slots per bowl and fruit kinds (0 = cherry ... 10 = watermelon) */
+#define S4D_SLOTS_PER_BOWL 100
+#define S4D_FRUIT_COUNT    11
+
+/* Unread events a bowl keeps; older ones are dropped (see s4d_dropped_events) */
+#define S4D_EVENTS_PER_BOWL 1024
+
+typedef enum s4d_status {
+    S4D_OK             = 0,
+    S4D_ERROR_ARGUMENT = -1, /* null pointer, bowl out of range or unknown fruit */
+    S4D_ERROR_MEMORY   = -2,
+} s4d_status;
+
+/* Slot flags in s4d_state_buffers.flags */
+#define S4D_SLOT_PRESENT 1u
+#define S4D_SLOT_GROWING 8u
+
+typedef enum s4d_event_type {
+    S4D_EVENT_MERGE = 0, /* two fruits merged into `fruit` at `position` */
+    S4D_EVENT_LOST  = 1, /* a fruit fell out of the bowl (the game's game over) */
+} s4d_event_type;
+
+typedef struct s4d_world s4d_world;
+
+/* Hemisphere bowl; the game uses center 0, radius 3, angle 90, margin 0.1 */
+typedef struct s4d_boundary {
+    float center[4]; /* x, y, z, w */
+    float radius;
+    float angle_degrees; /* opening of the bowl, 90 = half a hypersphere */
+    float margin;
+} s4d_boundary;
+
+typedef struct s4d_drop {
+    uint32_t bowl;
+    uint32_t fruit;
+    float    position[4]; /* the game drops 3 units above the rim */
+} s4d_drop;
+
+typedef struct s4d_event {
+    uint64_t tick; /* world tick the event happened in */
+    uint32_t bowl;
+    uint32_t slot;
+    uint32_t type; /* s4d_event_type */
+    uint32_t fruit;
+    float    position[4];
+} s4d_event;
+
+/* Destinations for s4d_read_state. Every pointer is optional (NULL skips the field).
+   Slot arrays hold bowl_count * S4D_SLOTS_PER_BOWL entries, bowl-major; absent slots
+   read as zero. */
+typedef struct s4d_state_buffers {
+    float*   positions; /* 4 floats per slot */
+    float*   radii;     /* 1 float per slot */
+    uint8_t* fruits;    /* 1 byte per slot */
+    uint8_t* flags;     /* 1 byte per slot, S4D_SLOT_* */
+    int32_t* points;    /* 1 per bowl */
+    uint32_t* fruit_counts; /* 1 per bowl */
+} s4d_state_buffers;
+
+S4D_API uint32_t    s4d_api_version(void);
+S4D_API const char* s4d_status_string(int32_t status);
+
+/* Creates `bowl_count` empty game bowls. thread_count 0 uses every hardware thread,
+   1 steps on the calling thread. Worker threads sleep between s4d_step calls, so an
+   idle world costs the host no CPU. Returns NULL on failure. */
+S4D_API s4d_world* s4d_world_create(uint32_t bowl_count, uint32_t thread_count);
+S4D_API void       s4d_world_destroy(s4d_world* world);
+S4D_API uint32_t   s4d_world_bowl_count(const s4d_world* world);
+S4D_API uint64_t   s4d_world_tick(const s4d_world* world);
+
+/* Sets the bowl of bowls [first, first + count) from `boundaries` (count entries) */
+S4D_API int32_t s4d_set_boundaries(s4d_world* world, uint32_t first, uint32_t count, const s4d_boundary* boundaries);
+
+/* Empties bowls [first, first + count) and zeroes their score */
+S4D_API int32_t s4d_reset_bowls(s4d_world* world, uint32_t first, uint32_t count);
+
+/* Places fruits for the next step. Returns how many were placed (drops into a full
+   bowl are skipped) or a negative s4d_status; nothing is placed on error. */
+S4D_API int32_t s4d_drop_fruits(s4d_world* world, const s4d_drop* drops, uint32_t count);
+
+/* Advances every bowl by `ticks` fixed steps of 1/60 s */
+S4D_API int32_t s4d_step(s4d_world* world, uint32_t ticks);
+
+/* Copies the state of bowls [first, first + count) into the caller's buffers */
+S4D_API int32_t s4d_read_state(const s4d_world* world, uint32_t first, uint32_t count, const s4d_state_buffers* out);
+
+/* Moves up to `capacity` merge and loss events into `out`, oldest first within a bowl.
+   Returns the number written; call again while it returns `capacity`. */
+S4D_API int32_t  s4d_read_events(s4d_world* world, s4d_event* out, uint32_t capacity);
+S4D_API uint32_t s4d_pending_events(const s4d_world* world);
+
+/* Events are recorded from world creation on. Passing 0 stops recording (and its cost)
+   for callers that never read them; queued events stay readable. */
+S4D_API int32_t  s4d_record_events(s4d_world* world, int32_t enabled);
+
+/* Events dropped because a bowl already held S4D_EVENTS_PER_BOWL unread ones */
+S4D_API uint64_t s4d_dropped_events(const s4d_world* world);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
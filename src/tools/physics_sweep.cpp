@@ -0,0 +1,354 @@
+/*******************************************************************
+** Physics parameter sweep.
+**
+** Plays a corpus of games through the headless solver once for
+** every point of a parameter grid (velocity damping, response
+** coefficient, grow speed, sub steps), spreading the runs over all
+** cores, and reports per parameter set:
+**   settle      seconds until every fruit is at rest after the last
+**               input (the game keeps running for --tail seconds)
+**   penetration deepest overlap of two grown fruits, as a fraction
+**               of the smaller radius
+**   drift       mechanical energy gained per unit mass and second
+**               by the resting pile (positive = the pile jitters)
+**   cost        solver time per physics step
+** and picks the cheapest set that meets the stability bar. Unless
+** given with --max-*, the bar is the game's own tuning (the
+** constants in globals.h at one sub step), which always runs as the
+** baseline: a set passes when it settles, penetrates and loses
+** fruits no worse than that, within --slack (10 %).
+**
+** The corpus is the replays given on the command line, or generated
+** games when there are none: a drop every 1.5 s until the fruits
+** would fill --fill (30 %) of the bowl's volume, at most --seconds. Drops, resets and rewinds are replayed;
+** sub step changes of the recorded session are not, since sub steps
+** are part of the grid.
+**
+** usage: physics_sweep [replay.s4dr ...] [--damping 50,100,200]
+**                      [--response 0.05,0.1,0.2] [--grow 5] [--substeps 1,2,4]
+**                      [--games N] [--seconds S] [--fill F] [--tail S] [--threads N]
+**                      [--max-penetration F] [--max-settle S] [--max-drift F]
+**                      [--max-lost N] [--slack F] [--json out.json]
+******************************************************************/
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "executor_factory.hpp"
+#include "replay.hpp"
+
+namespace
+{
+
+const float LOSS_Y = -3.0f;          // fruits below this left the bowl (the game's game over line)
+const float REST_SPEED = 0.1f;       // units per second; slower fruits count as resting
+const float REST_HOLD_SECONDS = 0.5f; // the pile must stay at rest this long to count as settled
+
+struct SweepPoint
+{
+    PhysicsParams params;
+    uint32_t      sub_steps = 1;
+};
+
+struct RunMetrics
+{
+    double   settle = 0.0;      // seconds after the last input
+    bool     settled = false;
+    float    penetration = 0.0f;
+    double   drift = 0.0;
+    double   update_seconds = 0.0;
+    uint64_t ticks = 0;
+    uint32_t escaped = 0;       // fruits that left the bowl
+};
+
+struct PointResult
+{
+    SweepPoint point;
+    double     settle = 0.0;
+    uint32_t   unsettled = 0;
+    float      penetration = 0.0f;
+    double     drift = 0.0;
+    double     step_us = 0.0;
+    uint32_t   escaped = 0;
+    bool       pass = false;
+};
+
+std::vector<float> parseList(const char* text)
+{
+    std::vector<float> values;
+    std::stringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        if (!item.empty()) values.push_back(static_cast<float>(std::atof(item.c_str())));
+    }
+    return values;
+}
+
+const float DROP_SECONDS = 1.5f; // generated games drop a fruit this often
+
+// A game of random drops that stops once the fruits dropped would fill `fill` of the
+// bowl's volume (or after `seconds`), so the pile stays inside the bowl and settles:
+// fruits lost over the rim are then a property of the parameters, not of the corpus
+Replay generatedGame(uint64_t seed, float seconds, float fill)
+{
+    Replay replay;
+    replay.header.seed = seed;
+    Pcg32 rng(seed, 0x5eed);
+    auto unit = [&rng]() { return static_cast<float>(rng.next()) * (2.0f / 4294967296.0f) - 1.0f; };
+    const uint64_t drop_every = static_cast<uint64_t>(DROP_SECONDS / replay.header.timestep + 0.5f);
+    replay.end_tick = static_cast<uint64_t>(seconds / replay.header.timestep + 0.5f);
+    float filled = 0.0f;
+    for (uint64_t tick = 0; tick < replay.end_tick; tick += drop_every) {
+        ReplayEvent e;
+        e.tick = tick;
+        e.type = ReplayEventType::Drop;
+        e.fruit = randomDropFruit(rng);
+        // a 4-ball of radius r against the half 4-ball of the bowl: 2 (r / R)^4
+        const float r = fruitPhysics(e.fruit).radius / replay.header.bowl_radius;
+        filled += 2.0f * r * r * r * r;
+        if (filled > fill) {
+            replay.end_tick = tick;
+            break;
+        }
+        const float reach = replay.header.bowl_radius - replay.header.bowl_margin - fruitPhysics(e.fruit).radius;
+        glm::vec3 p;
+        do p = glm::vec3(unit(), unit(), unit()); while (glm::dot(p, p) > 1.0f);
+        e.position = glm::vec4(p.x * reach, 3.0f, p.y * reach, p.z * reach);
+        replay.events.push_back(e);
+    }
+    return replay;
+}
+
+RunMetrics runGame(const Replay& replay, const SweepPoint& point, float tail_seconds)
+{
+    using clock = std::chrono::steady_clock;
+    tp::SerialExecutor serial(false);
+    HemisphereBoundary bowl(glm::vec4(0.0f), replay.header.bowl_radius, replay.header.bowl_angle, replay.header.bowl_margin);
+    PhysicSolver solver(serial, &bowl);
+    solver.params = point.params;
+    solver.sub_steps = point.sub_steps;
+    SnapshotRing history(rewindCapacity(replay.header.timestep));
+    SolverState snapshot;
+
+    const float dt = replay.header.timestep;
+    const uint64_t tail_ticks = static_cast<uint64_t>(tail_seconds / dt + 0.5f);
+    const uint64_t total_ticks = replay.end_tick + tail_ticks;
+    const uint64_t drift_from = replay.end_tick + tail_ticks / 2;
+    RunMetrics metrics;
+    uint64_t last_moving = replay.end_tick;
+    double drift_start = 0.0;
+    size_t next = 0;
+    for (uint64_t tick = 0; tick < total_ticks; ++tick) {
+        for (; next < replay.events.size() && replay.events[next].tick == tick; ++next) {
+            const ReplayEvent& e = replay.events[next];
+            if (e.type == ReplayEventType::Drop) solver.addObject(PhysicsObject(e.position, e.fruit, true, false));
+            else if (e.type == ReplayEventType::Reset) solver.clear();
+            else if (e.type == ReplayEventType::Rewind && history.rewind(e.rewind_steps, snapshot)) solver.loadState(snapshot);
+        }
+        const auto start = clock::now();
+        solver.update(dt);
+        metrics.update_seconds += std::chrono::duration<double>(clock::now() - start).count();
+        ++metrics.ticks;
+        solver.saveState(snapshot);
+        history.capture(snapshot);
+
+        for (int i = 0; i < MAX_OBJECTS; ++i) {
+            if (solver.has_obj[i] && solver.objects[i].position.y < LOSS_Y) {
+                solver.removeObject(i);
+                ++metrics.escaped;
+            }
+        }
+        const PhysicsStats stats = measurePhysics(solver);
+        metrics.penetration = std::max(metrics.penetration, stats.max_penetration);
+        if (tick < replay.end_tick) continue;
+
+        const double e = stats.kinetic_energy + stats.potential_energy;
+        if (stats.max_speed >= REST_SPEED) last_moving = tick + 1;
+        if (tick == drift_from) drift_start = e;
+        if (tick + 1 == total_ticks && stats.mass > 0.0 && tick > drift_from) {
+            metrics.drift = (e - drift_start) / (stats.mass * (tick - drift_from) * dt);
+        }
+    }
+    metrics.settle = (last_moving - replay.end_tick) * dt;
+    metrics.settled = (total_ticks - last_moving) * dt >= REST_HOLD_SECONDS;
+    return metrics;
+}
+
+std::string describe(const SweepPoint& p)
+{
+    char buf[96];
+    std::snprintf(buf, sizeof(buf), "damping %g  response %g  grow %g  substeps %u",
+                  p.params.velocity_damping, p.params.response_coef, p.params.grow_speed, p.sub_steps);
+    return buf;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<float> damping = {50.0f, VELOCITY_DAMPING, 200.0f};
+    std::vector<float> response = {0.05f, RESPONSE_COEF, 0.2f};
+    std::vector<float> grow = {GROW_SPEED};
+    std::vector<float> substeps = {1, 2, 4};
+    std::vector<std::string> replay_paths;
+    uint32_t games = 8;
+    float game_seconds = 60.0f;
+    float fill = 0.3f;
+    float tail_seconds = 10.0f;
+    // negative: taken from the baseline
+    float max_penetration = -1.0f;
+    float max_settle = -1.0f;
+    float max_drift = 0.01f;
+    long max_lost = -1;
+    float slack = 0.1f;
+    uint32_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string json_path;
+
+    for (int i = 1; i < argc; ++i) {
+        const bool more = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--damping") && more) damping = parseList(argv[++i]);
+        else if (!std::strcmp(argv[i], "--response") && more) response = parseList(argv[++i]);
+        else if (!std::strcmp(argv[i], "--grow") && more) grow = parseList(argv[++i]);
+        else if (!std::strcmp(argv[i], "--substeps") && more) substeps = parseList(argv[++i]);
+        else if (!std::strcmp(argv[i], "--games") && more) games = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--seconds") && more) game_seconds = static_cast<float>(std::atof(argv[++i]));
+        else if (!std::strcmp(argv[i], "--fill") && more) fill = static_cast<float>(std::atof(argv[++i]));
+        else if (!std::strcmp(argv[i], "--tail") && more) tail_seconds = static_cast<float>(std::atof(argv[++i]));
+        else if (!std::strcmp(argv[i], "--threads") && more) threads = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--max-penetration") && more) max_penetration = static_cast<float>(std::atof(argv[++i]));
+        else if (!std::strcmp(argv[i], "--max-settle") && more) max_settle = static_cast<float>(std::atof(argv[++i]));
+        else if (!std::strcmp(argv[i], "--max-drift") && more) max_drift = static_cast<float>(std::atof(argv[++i]));
+        else if (!std::strcmp(argv[i], "--max-lost") && more) max_lost = std::atol(argv[++i]);
+        else if (!std::strcmp(argv[i], "--slack") && more) slack = static_cast<float>(std::atof(argv[++i]));
+        else if (!std::strcmp(argv[i], "--json") && more) json_path = argv[++i];
+        else if (argv[i][0] != '-') replay_paths.push_back(argv[i]);
+        else {
+            std::cerr << "usage: " << argv[0] << " [replay.s4dr ...] [--damping a,b] [--response a,b] [--grow a,b]"
+                      << " [--substeps a,b] [--games N] [--seconds S] [--fill F] [--tail S] [--threads N]"
+                      << " [--max-penetration F] [--max-settle S] [--max-drift F] [--max-lost N] [--slack F]"
+                      << " [--json out.json]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<Replay> corpus;
+    for (const std::string& path : replay_paths) {
+        Replay replay;
+        std::string error;
+        if (!loadReplay(path, replay, error)) {
+            std::cerr << path << ": " << error << std::endl;
+            return 1;
+        }
+        corpus.push_back(std::move(replay));
+    }
+    if (corpus.empty()) {
+        for (uint32_t g = 0; g < games; ++g) corpus.push_back(generatedGame(1000 + g, game_seconds, fill));
+    }
+
+    // The game's own tuning comes first, as the baseline of the bar
+    std::vector<SweepPoint> grid(1);
+    for (float d : damping)
+        for (float r : response)
+            for (float g : grow)
+                for (float s : substeps) {
+                    SweepPoint p;
+                    p.params.velocity_damping = d;
+                    p.params.response_coef = r;
+                    p.params.grow_speed = g;
+                    p.sub_steps = std::max(1u, static_cast<uint32_t>(s));
+                    const bool baseline = p.sub_steps == grid[0].sub_steps &&
+                                          !std::memcmp(&p.params, &grid[0].params, sizeof(PhysicsParams));
+                    if (!baseline) grid.push_back(p);
+                }
+
+    tp::ThreadPlacement placement;
+    placement.worker_cpus.assign(threads, -1);
+    std::unique_ptr<tp::Executor> executor = tp::makeExecutor("steal", placement);
+    std::printf("%zu parameter sets x %zu games (+%.0f s at rest) on %s x%u\n", grid.size(), corpus.size(), tail_seconds,
+                executor->name(), executor->threadCount());
+
+    // One run per (point, game); each is stepped on its own serial executor
+    const uint32_t runs = static_cast<uint32_t>(grid.size() * corpus.size());
+    std::vector<RunMetrics> metrics(runs);
+    const auto start = std::chrono::steady_clock::now();
+    executor->dispatch(runs, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t k = begin; k < end; ++k) {
+            metrics[k] = runGame(corpus[k % corpus.size()], grid[k / corpus.size()], tail_seconds);
+        }
+    }, "sweep");
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<PointResult> results;
+    for (size_t p = 0; p < grid.size(); ++p) {
+        PointResult r;
+        r.point = grid[p];
+        double update_seconds = 0.0;
+        uint64_t ticks = 0;
+        for (size_t g = 0; g < corpus.size(); ++g) {
+            const RunMetrics& m = metrics[p * corpus.size() + g];
+            r.settle = std::max(r.settle, m.settle);
+            r.unsettled += m.settled ? 0 : 1;
+            r.penetration = std::max(r.penetration, m.penetration);
+            r.drift = std::max(r.drift, m.drift);
+            r.escaped += m.escaped;
+            update_seconds += m.update_seconds;
+            ticks += m.ticks;
+        }
+        r.step_us = ticks ? update_seconds * 1e6 / ticks : 0.0;
+        results.push_back(r);
+    }
+    const PointResult baseline = results[0]; // a copy, results are sorted below
+    if (max_settle < 0.0f) max_settle = static_cast<float>(baseline.settle) * (1.0f + slack);
+    if (max_penetration < 0.0f) max_penetration = baseline.penetration * (1.0f + slack);
+    if (max_lost < 0) max_lost = baseline.escaped;
+    for (PointResult& r : results) {
+        r.pass = r.unsettled <= baseline.unsettled && r.escaped <= static_cast<uint32_t>(max_lost) &&
+                 r.settle <= max_settle && r.penetration <= max_penetration && r.drift <= max_drift;
+    }
+    std::sort(results.begin(), results.end(), [](const PointResult& a, const PointResult& b) { return a.step_us < b.step_us; });
+
+    std::printf("%-8s %-9s %-5s %-4s | %-9s %-8s %-10s %-6s %-9s\n", "damping", "response", "grow", "sub", "settle s",
+                "penetr.", "drift", "lost", "us/step");
+    for (const PointResult& r : results) {
+        char settle[16];
+        if (r.unsettled) std::snprintf(settle, sizeof(settle), "no (%u)", r.unsettled);
+        else std::snprintf(settle, sizeof(settle), "%.2f", r.settle);
+        std::printf("%-8g %-9g %-5g %-4u | %-9s %-8.3f %-+10.4f %-6u %-9.1f %s\n", r.point.params.velocity_damping,
+                    r.point.params.response_coef, r.point.params.grow_speed, r.point.sub_steps, settle, r.penetration,
+                    r.drift, r.escaped, r.step_us, r.pass ? "ok" : "");
+    }
+    std::printf("%u runs in %.1f s; bar: settle <= %.2f s, penetration <= %.3f, drift <= %g, lost <= %ld\n", runs,
+                wall, max_settle, max_penetration, max_drift, max_lost);
+    std::printf("baseline: %s (%.1f us/step)\n", describe(baseline.point).c_str(), baseline.step_us);
+
+    const auto best = std::find_if(results.begin(), results.end(), [](const PointResult& r) { return r.pass; });
+    if (best != results.end()) std::printf("cheapest stable set: %s (%.1f us/step)\n", describe(best->point).c_str(), best->step_us);
+    else std::printf("no parameter set meets the bar\n");
+
+    if (!json_path.empty()) {
+        std::ofstream out(json_path);
+        out << "[\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const PointResult& r = results[i];
+            out << "  {\"velocity_damping\": " << r.point.params.velocity_damping << ", \"response_coef\": "
+                << r.point.params.response_coef << ", \"grow_speed\": " << r.point.params.grow_speed
+                << ", \"sub_steps\": " << r.point.sub_steps << ", \"settle_seconds\": " << r.settle
+                << ", \"unsettled\": " << r.unsettled << ", \"max_penetration\": " << r.penetration
+                << ", \"energy_drift\": " << r.drift << ", \"escaped\": " << r.escaped << ", \"step_us\": " << r.step_us
+                << ", \"pass\": " << (r.pass ? "true" : "false") << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "]\n";
+        std::cout << "wrote " << json_path << std::endl;
+    }
+    return best != results.end() ? 0 : 2;
+}
@@ -0,0 +1,154 @@
+/*******************************************************************
+** Reference viewer for the spectator stream of 4d_game --spectate.
+**
+** Connects to the game, decodes every frame and prints once per
+** second what is in the bowl and what the stream costs: frames per
+** second, bytes per second and bytes per frame. --csv writes every
+** decoded fruit of every tick, for dashboards or offline analysis.
+**
+** usage: spectator_view [endpoint] [--frames N] [--csv out.csv]
+**        endpoint: tcp:[host:]port or unix:path (default tcp:7878)
+******************************************************************/
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "spectator_codec.hpp"
+#include "spectator_net.hpp"
+
+namespace
+{
+
+const char* FRUIT_NAMES[FRUIT_COUNT] = {"cherry", "strawberry", "grape", "dekopon", "persimmon", "apple",
+                                        "pear", "peach", "pineapple", "melon", "watermelon"};
+
+bool readMessage(net::Socket socket, std::vector<uint8_t>& payload)
+{
+    uint8_t header[4];
+    if (!net::receive(socket, header, 4)) return false;
+    const uint32_t size = header[0] | (header[1] << 8) | (header[2] << 16) | (static_cast<uint32_t>(header[3]) << 24);
+    if (size == 0 || size > SPECTATOR_MAX_MESSAGE) return false;
+    payload.resize(size);
+    return net::receive(socket, payload.data(), size);
+}
+
+bool checkHello(const std::vector<uint8_t>& hello, float& timestep)
+{
+    if (hello.size() < 16 || hello[0] != SPECTATOR_HELLO || std::memcmp(hello.data() + 1, "S4DV", 4) != 0) return false;
+    if (hello[5] != SPECTATOR_VERSION) return false;
+    float scale;
+    std::memcpy(&timestep, hello.data() + 6, 4);
+    std::memcpy(&scale, hello.data() + 10, 4);
+    const uint32_t slots = hello[14] | (hello[15] << 8);
+    return scale == SpectatorFrame::SCALE && slots == MAX_OBJECTS;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    std::string endpoint_text = "tcp:7878";
+    uint64_t max_frames = 0;
+    std::string csv_path;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--frames") && i + 1 < argc) max_frames = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--csv") && i + 1 < argc) csv_path = argv[++i];
+        else if (argv[i][0] != '-') endpoint_text = argv[i];
+        else {
+            std::cerr << "usage: " << argv[0] << " [tcp:[host:]port | unix:path] [--frames N] [--csv out.csv]" << std::endl;
+            return 1;
+        }
+    }
+
+    net::Endpoint endpoint;
+    std::string error;
+    if (!net::parseEndpoint(endpoint_text, endpoint, error) || !net::startup()) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    const net::Socket socket = net::connect(endpoint, error);
+    if (socket == net::INVALID) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    std::vector<uint8_t> payload;
+    float timestep = 0.0f;
+    if (!readMessage(socket, payload) || !checkHello(payload, timestep)) {
+        std::cerr << "not a compatible spectator stream at " << endpoint.describe() << std::endl;
+        net::close(socket);
+        return 1;
+    }
+    std::cout << "watching " << endpoint.describe() << " (" << 1.0f / timestep << " ticks/s)" << std::endl;
+
+    std::ofstream csv;
+    if (!csv_path.empty()) {
+        csv.open(csv_path);
+        csv << "tick,slot,fruit,x,y,z,w,radius\n";
+    }
+
+    using clock = std::chrono::steady_clock;
+    SpectatorCodec codec;
+    SpectatorFrame frame;
+    uint64_t frames = 0, keyframes = 0, bytes = 0, rejected = 0;
+    uint64_t window_frames = 0, window_bytes = 0;
+    auto window_start = clock::now();
+    while (max_frames == 0 || frames < max_frames) {
+        if (!readMessage(socket, payload)) {
+            std::cout << "stream closed" << std::endl;
+            break;
+        }
+        bytes += payload.size() + 4;
+        window_bytes += payload.size() + 4;
+        if (!codec.decode(payload.data(), payload.size(), frame)) {
+            ++rejected; // deltas before the first keyframe
+            continue;
+        }
+        ++frames;
+        ++window_frames;
+        if (payload[0] == SPECTATOR_KEYFRAME) ++keyframes;
+
+        if (csv.is_open()) {
+            for (int i = 0; i < MAX_OBJECTS; ++i) {
+                if (!frame.slots[i].present) continue;
+                const glm::vec4 p = frame.position(i);
+                csv << frame.tick << ',' << i << ',' << FRUIT_NAMES[frame.slots[i].fruit] << ',' << p.x << ',' << p.y
+                    << ',' << p.z << ',' << p.w << ',' << frame.radius(i) << '\n';
+            }
+        }
+
+        const double elapsed = std::chrono::duration<double>(clock::now() - window_start).count();
+        if (elapsed >= 1.0) {
+            int fruits = 0, biggest = -1;
+            float top = -1e9f;
+            for (int i = 0; i < MAX_OBJECTS; ++i) {
+                if (!frame.slots[i].present) continue;
+                ++fruits;
+                biggest = std::max(biggest, static_cast<int>(frame.slots[i].fruit));
+                top = std::max(top, frame.position(i).y + frame.radius(i));
+            }
+            std::printf("tick %llu  %d fruits  %d points  biggest %s  top %.2f  |  %.1f frames/s  %.2f KB/s  %.0f B/frame\n",
+                        static_cast<unsigned long long>(frame.tick), fruits, frame.points,
+                        biggest >= 0 ? FRUIT_NAMES[biggest] : "-", fruits ? top : 0.0f, window_frames / elapsed,
+                        window_bytes / elapsed / 1024.0, window_frames ? static_cast<double>(window_bytes) / window_frames : 0.0);
+            std::fflush(stdout);
+            window_start = clock::now();
+            window_frames = 0;
+            window_bytes = 0;
+        }
+    }
+    net::close(socket);
+
+    std::printf("%llu frames (%llu keyframes), %llu bytes, %.1f B/frame on average",
+                static_cast<unsigned long long>(frames), static_cast<unsigned long long>(keyframes),
+                static_cast<unsigned long long>(bytes), frames ? static_cast<double>(bytes) / frames : 0.0);
+    if (rejected) std::printf(", %llu frames before the first keyframe skipped", static_cast<unsigned long long>(rejected));
+    std::printf("\n");
+    return 0;
+}